@@ -0,0 +1,36 @@
+// bench.c - driver hot path benchmark against the chip model, one JSON object per line
+//
+// usage: lis2hh12_bench [LatencyUS [DurationMS [FTH [ODR]]]]
+//		lis2hh12_bench spec		FFT & Goertzel block cost at every ODR instead
+//	LatencyUS	model bus time per transaction, default 0
+//	DurationMS	model time of the macro run, default 10000
+//	FTH			FIFO threshold 1..31, default 16
+//	ODR			lis2hh12_odr_t 1..6, default 6 (800Hz)
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+int main(int argc, char ** argv) {
+	if (argc > 1 && strcmp(argv[1], "spec") == 0) return lis2hh12SpecBench(NULL) > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	u32_t LatencyUS = argc > 1 ? strtoul(argv[1], NULL, 0) : 0;
+	u32_t DurationMS = argc > 2 ? strtoul(argv[2], NULL, 0) : 10000;
+	u32_t FTH = argc > 3 ? strtoul(argv[3], NULL, 0) : 16;
+	u32_t ODR = argc > 4 ? strtoul(argv[4], NULL, 0) : lis2hh12_odr800;
+	if (FTH == 0 || FTH >= lis2hh12FIFO_DEPTH || ODR == lis2hh12_odr0 || ODR > lis2hh12_odr800) {
+		fprintf(stderr, "usage: %s [LatencyUS [DurationMS [FTH 1..31 [ODR 1..6]]]]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	lis2hh12_cfg_t Cfg = lis2hh12CfgDefault;
+	Cfg.CTRL[0] = makeCTRL1(1,ODR,1,1,1,1);
+	Cfg.CTRL[2] = makeCTRL3(1,0,0,0,0,0,1,0);
+	Cfg.FIFO_CTRL = makeFIFOC(fmSTREAM, FTH);
+	static lis2hh12_bench_t sB;
+	static report_t sSink;								// timed report output discarded
+	int iRV = lis2hh12Bench(&sB, &Cfg, &sSink, 0, LatencyUS, DurationMS);
+	if (iRV < erSUCCESS) {
+		fprintf(stderr, "lis2hh12Bench() failed %d\n", iRV);
+		return EXIT_FAILURE;
+	}
+	lis2hh12ReportBench(NULL, &sB);
+	return (DurationMS && sB.Samples == 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,64 @@
+// decode.c - recording to CSV, built from lis2hh12_codec.c alone without the driver or HAL stubs
+//
+// usage: lis2hh12_decode Recording [mG]
+//	Recording	lis2hh12EncHeader() + lis2hh12EncBlock() output
+//	mG			any second argument prints X Y Z in mG using the header scale, default raw LSb
+// output: TS,X,Y,Z,Gap lines on stdout, header & summary on stderr
+
+#include "lis2hh12_codec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#define decodeCHUNK				256
+
+int main(int argc, char ** argv) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s Recording [mG]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	FILE * psF = fopen(argv[1], "rb");
+	if (psF == NULL) {
+		perror(argv[1]);
+		return EXIT_FAILURE;
+	}
+	fseek(psF, 0, SEEK_END);
+	long Len = ftell(psF);
+	rewind(psF);
+	uint8_t * pBuf = malloc(Len > 0 ? Len : 1);
+	if (pBuf == NULL || fread(pBuf, 1, Len, psF) != (size_t) Len) {
+		fprintf(stderr, "%s: read failed\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	fclose(psF);
+
+	lis2hh12_dec_t sDec;
+	if (lis2hh12DecInit(&sDec, pBuf, Len) != lis2hh12_codecOK) {
+		fprintf(stderr, "%s: not a recording\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	lis2hh12_enc_hdr_t * psH = &sDec.Hdr;
+	fprintf(stderr, "version %u  CTRL1=x%02X CTRL4=x%02X CTRL5=x%02X FIFO_CTRL=x%02X  SyncEvery=%u  mG/LSb=%.6f  Period=%.3fuS  TS=%" PRIu64 "\n",
+		psH->Version, psH->CTRL1, psH->CTRL4, psH->CTRL5, psH->FIFO_CTRL, psH->SyncEvery, psH->ScaleQ16 / 65536.0,
+		psH->PeriodQ8 / 256.0, psH->TS);
+	static lis2hh12_sample_t sS[decodeCHUNK];
+	uint64_t Samples = 0, Lost = 0;
+	int Count;
+	while ((Count = lis2hh12DecBlock(&sDec, sS, decodeCHUNK)) > 0) {
+		for (int i = 0; i < Count; ++i) {
+			if (argc > 2) {
+				double Scale = psH->ScaleQ16 / 65536.0;
+				printf("%" PRIu64 ",%.1f,%.1f,%.1f,%u\n", sS[i].TS, sS[i].XYZ.X * Scale, sS[i].XYZ.Y * Scale, sS[i].XYZ.Z * Scale, sS[i].Gap);
+			} else {
+				printf("%" PRIu64 ",%d,%d,%d,%u\n", sS[i].TS, sS[i].XYZ.X, sS[i].XYZ.Y, sS[i].XYZ.Z, sS[i].Gap);
+			}
+			Lost += sS[i].Gap;
+		}
+		Samples += Count;
+	}
+	fprintf(stderr, "%" PRIu64 " samples, %" PRIu64 " lost, %ld bytes, %.2f B/sample, %u bytes skipped\n",
+		Samples, Lost, Len, Samples ? (double) Len / Samples : 0.0, sDec.Resync);
+	free(pBuf);
+	return (Samples && sDec.Resync == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,248 @@
+// hal_host.c - host build stubs for the HAL/FreeRTOS/ESP-IDF symbols used by the LIS2HH12 driver
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+#include "driver/spi_master.h"
+
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
+
+// ###################################### Global variables #########################################
+
+EventGroupHandle_t TaskRunState = NULL;
+i64_t hostTime = -1;
+void (* hostDelayHook)(void) = NULL;
+u32_t hostI2Ctrans = 0, hostI2Cbytes = 0, hostI2Clatency = 0;
+u32_t hostSPItrans = 0, hostSPIbytes = 0;
+
+// ###################################### Local variables ##########################################
+
+#define hostGPIO_PINS				40
+
+typedef struct {
+	i2c_di_t * psI2C;
+	lis2hh12_sim_t * psSim;
+} host_i2c_t;
+
+struct host_spi_t {
+	lis2hh12_sim_t * psSim;
+};
+
+typedef struct {
+	void (* Func)(void *);
+	void * Arg;
+} host_task_t;
+
+static host_i2c_t HostI2C[lis2hh12MAX_DEV] = { 0 };
+static struct host_spi_t HostSPI[lis2hh12MAX_DEV] = { 0 };
+static struct { void (* Handler)(void *); void * Arg; } HostGPIO[hostGPIO_PINS] = { 0 };
+static BaseType_t HostIsr = 0;
+static u32_t HostFail = 0, HostPass = 0;
+
+// #################################### Local ONLY functions #######################################
+
+static i64_t hostClock(void) {
+	struct timespec sTS;
+	clock_gettime(CLOCK_MONOTONIC, &sTS);
+	return (i64_t) sTS.tv_sec * 1000000000LL + sTS.tv_nsec;
+}
+
+static void * hostTaskRun(void * pv) {
+	host_task_t sT = *(host_task_t *) pv;
+	free(pv);
+	sT.Func(sT.Arg);
+	return NULL;
+}
+
+// ############################################## HAL ##############################################
+
+/**
+ * @brief		I2C queue answered by the chip model attached to the device, synchronous completion
+ */
+int halI2C_Queue(i2c_di_t * psI2C, i2cq_t eCmd, u8_t * pTx, size_t TxSize, u8_t * pRx, size_t RxSize, i2cq_p1_t p1, i2cq_p2_t p2) {
+	for (int i = 0; i < lis2hh12MAX_DEV; ++i) {
+		if (HostI2C[i].psI2C != psI2C)				continue;
+		if (HostI2C[i].psSim->Reg[lis2hh12CTRL4] & 0x02)	return erFAILURE;	// i2c_disable, device only answers SPI
+		++hostI2Ctrans;
+		hostI2Cbytes += TxSize + RxSize;
+		if (hostI2Clatency) esp_rom_delay_us(hostI2Clatency);
+		return lis2hh12SimQueue(HostI2C[i].psSim, eCmd, pTx, TxSize, pRx, RxSize, p1, p2);
+	}
+	return erFAILURE;
+}
+
+int halI2C_DeviceReport(report_t * psR, void * pvI2C) {
+	i2c_di_t * psI2C = pvI2C;
+	return xReport(psR, "I2C Type=%hhu  IDok=%hhu  CFGok=%hhu" strNL, psI2C->Type, psI2C->IDok, psI2C->CFGok);
+}
+
+void halGPIO_IRQconfig(int Pin, void (* Handler)(void *), void * Arg) {
+	if (Pin < 0 || Pin >= hostGPIO_PINS)			return;
+	HostGPIO[Pin].Handler = Handler;
+	HostGPIO[Pin].Arg = Arg;
+}
+
+bool halMemoryRAM(void * pv) { return pv != NULL; }
+
+int xReport(report_t * psR, const char * pcFormat, ...) {
+	va_list vaList;
+	va_start(vaList, pcFormat);
+	int iRV = psR ? vsnprintf(NULL, 0, pcFormat, vaList) : vprintf(pcFormat, vaList);
+	va_end(vaList);
+	if (psR && iRV > 0) psR->Bytes += iRV;
+	return iRV;
+}
+
+// ############################################ ESP-IDF ############################################
+
+int gpio_config(const gpio_config_t * psCfg) { return 0; }
+
+i64_t esp_timer_get_time(void) { return (hostTime >= 0) ? hostTime : hostClock() / 1000LL; }
+
+u32_t esp_cpu_get_cycle_count(void) { return (u32_t) hostClock(); }	// 1GHz nominal
+
+u32_t esp_rom_get_cpu_ticks_per_us(void) { return 1000; }
+
+/**
+ * @brief		busy wait as the ROM function does, in virtual time just advance the clock
+ */
+void esp_rom_delay_us(u32_t US) {
+	if (hostTime >= 0) {
+		hostTime += US;
+	} else {
+		i64_t Tend = hostClock() + US * 1000LL;
+		while (hostClock() < Tend);
+	}
+}
+
+/**
+ * @brief		SPI transaction answered by the chip model, address phase R/W bit decoded as the device does
+ */
+esp_err_t spi_device_polling_transmit(spi_device_handle_t hDev, spi_transaction_t * psT) {
+	if (hDev == NULL || hDev->psSim == NULL || psT->length == 0 || psT->length % 8)	return ESP_FAIL;
+	size_t Size = psT->length / 8;
+	u8_t Buf[1 + sizeof(lis2hh12_reg_t)] = { psT->addr & 0x7F };
+	++hostSPItrans;
+	hostSPIbytes += 1 + Size;
+	int iRV;
+	if (psT->addr & 0x80) {
+		iRV = lis2hh12SimQueue(hDev->psSim, i2cWR_B, Buf, 1, psT->rx_buffer, Size, NULL, NULL);
+	} else {
+		if (Size >= sizeof(Buf))					return ESP_FAIL;
+		memcpy(&Buf[1], psT->tx_buffer, Size);
+		iRV = lis2hh12SimQueue(hDev->psSim, i2cW_B, Buf, 1 + Size, NULL, 0, NULL, NULL);
+	}
+	return (iRV == erSUCCESS) ? ESP_OK : ESP_FAIL;
+}
+
+// ############################################ FreeRTOS ###########################################
+
+EventBits_t xEventGroupGetBitsFromISR(EventGroupHandle_t xEG) { return taskI2C_MASK; }
+
+BaseType_t xPortInIsrContext(void) { return HostIsr; }
+
+BaseType_t xTimerPendFunctionCallFromISR(void (* Func)(void *, u32_t), void * pv, u32_t U32, BaseType_t * pxHPTW) {
+	BaseType_t Isr = HostIsr;
+	HostIsr = 0;									// timer task context
+	Func(pv, U32);
+	HostIsr = Isr;
+	if (pxHPTW) *pxHPTW = pdTRUE;
+	return pdPASS;
+}
+
+void vTaskDelay(TickType_t Ticks) {
+	if (hostDelayHook) hostDelayHook();
+	if (hostTime >= 0) {
+		hostTime += (i64_t) Ticks * portTICK_PERIOD_MS * 1000LL;
+	} else {
+		struct timespec sTS = { .tv_sec = Ticks / 1000, .tv_nsec = (Ticks % 1000) * 1000000L };
+		nanosleep(&sTS, NULL);
+	}
+}
+
+BaseType_t xTaskCreate(void (* Func)(void *), const char * pcName, u32_t Stack, void * pv, UBaseType_t Prio, TaskHandle_t * pxTask) {
+	host_task_t * psT = malloc(sizeof(host_task_t));
+	if (psT == NULL)								return pdFALSE;
+	psT->Func = Func;
+	psT->Arg = pv;
+	pthread_t Thread;
+	if (pthread_create(&Thread, NULL, hostTaskRun, psT)) { free(psT); return pdFALSE; }
+	pthread_detach(Thread);
+	if (pxTask) *pxTask = (TaskHandle_t) Thread;
+	return pdPASS;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t xTask) { return 5; }
+
+void vTaskDelete(TaskHandle_t xTask) { if (xTask == NULL) pthread_exit(NULL); }
+
+void xTaskNotifyGive(TaskHandle_t xTask) {}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+	pthread_mutex_t * psMux = malloc(sizeof(pthread_mutex_t));
+	if (psMux) pthread_mutex_init(psMux, NULL);
+	return psMux;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSem, TickType_t Ticks) { return pthread_mutex_lock(xSem) ? pdFALSE : pdTRUE; }
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSem) { return pthread_mutex_unlock(xSem) ? pdFALSE : pdTRUE; }
+
+// ########################################## Host harness #########################################
+
+/**
+ * @brief		route halI2C_Queue() for the device to a chip model
+ * @note		lis2hh12Identify() binds a registered model directly, set psDev->psBus = &lis2hh12BusI2C
+ * 				after it to exercise the I2C transport against this stub instead
+ */
+void hostI2Cattach(i2c_di_t * psI2C, void * pvSim) {
+	for (int i = 0; i < lis2hh12MAX_DEV; ++i) {
+		if (HostI2C[i].psI2C == psI2C || HostI2C[i].psI2C == NULL) {
+			HostI2C[i].psI2C = psI2C;
+			HostI2C[i].psSim = pvSim;
+			return;
+		}
+	}
+}
+
+/**
+ * @brief		SPI device handle answered by a chip model, for lis2hh12IdentifyBus(psI2C, &lis2hh12BusSPI, hDev)
+ * @return		handle or NULL if all slots are in use
+ */
+spi_device_handle_t hostSPIattach(void * pvSim) {
+	for (int i = 0; i < lis2hh12MAX_DEV; ++i) {
+		if (HostSPI[i].psSim == pvSim || HostSPI[i].psSim == NULL) {
+			HostSPI[i].psSim = pvSim;
+			return &HostSPI[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief		assert an INTx line, calling the handler lis2hh12Config() installed in ISR context
+ * @return		erSUCCESS or erINV_STATE if no handler is installed on the pin
+ */
+int hostGPIOraise(int Pin) {
+	if (Pin < 0 || Pin >= hostGPIO_PINS || HostGPIO[Pin].Handler == NULL)	return erINV_STATE;
+	HostIsr = 1;
+	HostGPIO[Pin].Handler(HostGPIO[Pin].Arg);
+	HostIsr = 0;
+	return erSUCCESS;
+}
+
+void hostCheck(bool Cond, const char * pcFormat, ...) {
+	va_list vaList;
+	va_start(vaList, pcFormat);
+	printf("%s ", Cond ? "PASS" : "FAIL");
+	vprintf(pcFormat, vaList);
+	printf("\n");
+	va_end(vaList);
+	if (Cond) ++HostPass; else ++HostFail;
+}
+
+int hostResult(void) {
+	printf("%u passed, %u failed\n", HostPass, HostFail);
+	return HostFail ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,36 @@
+// spi_master.h - host build stub of the ESP-IDF SPI master driver, transactions answered by a chip model
+
+#pragma once
+
+#include "hal_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_OK						0
+#define ESP_FAIL					-1
+
+typedef int esp_err_t;
+typedef struct host_spi_t * spi_device_handle_t;
+
+typedef struct {
+	u32_t flags;
+	u16_t cmd;
+	u64_t addr;						// address phase, R/W bit and register
+	size_t length;					// bits
+	size_t rxlength;				// bits, 0 = length
+	void * user;
+	const void * tx_buffer;
+	void * rx_buffer;
+} spi_transaction_t;
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t * trans_desc);
+
+// host harness, see hal_host.c
+extern u32_t hostSPItrans, hostSPIbytes;	// spi_device_polling_transmit() transactions & bytes, address byte included
+spi_device_handle_t hostSPIattach(void * pvSim);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,5 @@
+// hal_i2c_common.h - host build stub, declarations live in hal_platform.h
+
+#pragma once
+
+#include "hal_platform.h"
@@ -0,0 +1,5 @@
+// hal_memory.h - host build stub, declarations live in hal_platform.h
+
+#pragma once
+
+#include "hal_platform.h"
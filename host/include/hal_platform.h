@@ -0,0 +1,129 @@
+// hal_platform.h - host build stub of the HAL/FreeRTOS/ESP-IDF symbols used by the LIS2HH12 driver
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ############################################# Macros ############################################
+
+#define HAL_LIS2HH12				1
+#define debugFLAG_GLOBAL			0xFFFF
+
+#define DUMB_STATIC_ASSERT(x)		_Static_assert(x, #x)
+#define IF_myASSERT(f, x)
+#define INRANGE(a, b, c)			((a) <= (b) && (b) <= (c))
+#define SO_MEM(s, m)				sizeof(((s *) 0)->m)
+#define IRAM_ATTR
+#define strNL						"\r\n"
+#define PX(...)						printf(__VA_ARGS__)
+#define SL_ERROR(x)					(void) (x)
+#define ESP_ERROR_CHECK(x)			(void) (x)
+
+#define pdTRUE						1
+#define pdFALSE						0
+#define pdPASS						1
+#define portMAX_DELAY				0xFFFFFFFF
+#define portTICK_PERIOD_MS			1
+#define pdMS_TO_TICKS(x)			(x)
+#define portYIELD_FROM_ISR()		do {} while (0)
+
+// ############################################ Types ##############################################
+
+typedef uint8_t u8_t;
+typedef int8_t i8_t;
+typedef uint16_t u16_t;
+typedef int16_t i16_t;
+typedef uint32_t u32_t;
+typedef int32_t i32_t;
+typedef uint64_t u64_t;
+typedef int64_t i64_t;
+typedef float f32_t;
+typedef double f64_t;
+
+typedef int BaseType_t;
+typedef u32_t UBaseType_t;
+typedef u32_t TickType_t;
+typedef u32_t EventBits_t;
+typedef void * SemaphoreHandle_t;
+typedef void * TaskHandle_t;
+typedef void * EventGroupHandle_t;
+
+enum { erSUCCESS = 0, erFAILURE = -1, erINV_WHOAMI = -2, erINV_STATE = -3, erINV_PARA = -4, erNO_MEM = -5, erTIMEOUT = -6 };
+
+typedef enum { i2cR, i2cW, i2cW_B, i2cWR, i2cWR_B, i2cWRC, i2cWRMW } i2cq_t;
+typedef void * i2cq_p1_t;
+typedef void * i2cq_p2_t;
+enum { i2cDEV_LIS2HH12 = 1 };
+enum { i2cSPEED_400 = 1 };
+
+typedef struct i2c_di_t {
+	u8_t Type, Speed, TObus, Test, IDok, CFGok, CFGerr, Addr;
+} i2c_di_t;
+
+typedef struct report_t {				// xReport() destination, output counted & discarded
+	u32_t Bytes;
+} report_t;
+
+typedef struct {
+	u64_t pin_bit_mask;
+	int mode, pull_up_en, pull_down_en, intr_type;
+} gpio_config_t;
+enum { GPIO_MODE_INPUT, GPIO_PULLUP_ENABLE, GPIO_PULLDOWN_DISABLE, GPIO_INTR_LOW_LEVEL };
+
+// ###################################### Global variables #########################################
+
+extern EventGroupHandle_t TaskRunState;
+enum { taskI2C_MASK = 1 };
+
+// ###################################### Public functions #########################################
+
+// HAL
+int halI2C_Queue(i2c_di_t * psI2C, i2cq_t eCmd, u8_t * pTx, size_t TxSize, u8_t * pRx, size_t RxSize, i2cq_p1_t p1, i2cq_p2_t p2);
+int halI2C_DeviceReport(report_t * psR, void * pvI2C);
+void halGPIO_IRQconfig(int Pin, void (* Handler)(void *), void * Arg);
+bool halMemoryRAM(void * pv);
+int xReport(report_t * psR, const char * pcFormat, ...);
+
+// ESP-IDF
+int gpio_config(const gpio_config_t * psCfg);
+i64_t esp_timer_get_time(void);
+u32_t esp_cpu_get_cycle_count(void);
+void esp_rom_delay_us(u32_t US);
+u32_t esp_rom_get_cpu_ticks_per_us(void);
+
+// FreeRTOS
+EventBits_t xEventGroupGetBitsFromISR(EventGroupHandle_t xEG);
+BaseType_t xPortInIsrContext(void);
+BaseType_t xTimerPendFunctionCallFromISR(void (* Func)(void *, u32_t), void * pv, u32_t U32, BaseType_t * pxHPTW);
+void vTaskDelay(TickType_t Ticks);
+BaseType_t xTaskCreate(void (* Func)(void *), const char * pcName, u32_t Stack, void * pv, UBaseType_t Prio, TaskHandle_t * pxTask);
+UBaseType_t uxTaskPriorityGet(TaskHandle_t xTask);
+void vTaskDelete(TaskHandle_t xTask);
+void xTaskNotifyGive(TaskHandle_t xTask);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSem, TickType_t Ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSem);
+
+// host harness, see hal_host.c
+extern i64_t hostTime;					// uSec, >= 0 virtual time advanced by vTaskDelay(), < 0 monotonic clock
+extern void (* hostDelayHook)(void);	// called by vTaskDelay() before time advances
+extern u32_t hostI2Ctrans, hostI2Cbytes;	// halI2C_Queue() transactions & bytes, device address excluded
+extern u32_t hostI2Clatency;			// uSec bus time per halI2C_Queue() transaction, see esp_rom_delay_us()
+void hostI2Cattach(i2c_di_t * psI2C, void * pvSim);
+int hostGPIOraise(int Pin);
+void hostCheck(bool Cond, const char * pcFormat, ...);
+int hostResult(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,5 @@
+// rules.h - host build stub, declarations live in hal_platform.h
+
+#pragma once
+
+#include "hal_platform.h"
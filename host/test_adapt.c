@@ -0,0 +1,93 @@
+// test_adapt.c - FIFO watermark adaptation with a slow INTx service, gap marking on overrun
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+static lis2hh12_sim_t Sim;
+static i2c_di_t I2C;
+static lis2hh12_xyz_t Blk[lis2hh12FIFO_DEPTH];
+static u64_t Due;										// INTx serviced at, 0 = none pending
+static u32_t ServiceUS;									// INTx edge to IRQ handler
+static u32_t Skipped, Marked;							// samples missing from the sequence, gaps marked
+static u16_t Seq;
+
+static lis2hh12_xyz_t SimGen(lis2hh12_sim_t * psSim, u64_t TS) {	// raw X is the sequence number
+	lis2hh12_xyz_t XYZ = { .X = (i16_t) Seq++, .Y = 0, .Z = 16384 };
+	return XYZ;
+}
+
+static void SimIRQ(void * Arg) { Due = hostTime + ServiceUS; }
+
+/**
+ * @brief		model time in 50uS steps with AdaptFIFO() once a second
+ * @return		FTH after the last window
+ */
+static int Windows(lis2hh12_t * psDev, u32_t Count, u8_t Margin, int * pFTH) {
+	static i16_t Last = -1;
+	int FTH = psDev->Reg.fifo_ctrl.fth;
+	for (u32_t w = 0; w < Count; ++w) {
+		for (int Step = 0; Step < 20000; ++Step) {
+			hostTime += 50;
+			lis2hh12SimTick(&Sim, hostTime);
+			if (Due && hostTime >= Due) {
+				Due = 0;
+				hostGPIOraise(lis2hh12IRQ_PIN);
+			}
+			lis2hh12_sample_t * psS;
+			size_t Num;
+			while ((Num = lis2hh12RingPeek(&psDev->Ring, &psS))) {
+				for (size_t i = 0; i < Num; ++i) {
+					Skipped += (u16_t) (psS[i].XYZ.X - Last - 1);
+					Marked += psS[i].Gap;
+					Last = psS[i].XYZ.X;
+				}
+				lis2hh12RingRelease(&psDev->Ring, Num);
+			}
+		}
+		FTH = lis2hh12AdaptFIFO(psDev, Margin);
+		if (pFTH) pFTH[w] = FTH;
+	}
+	return FTH;
+}
+
+int main(void) {
+	hostTime = 0;
+	lis2hh12SimInit(&Sim, &I2C);
+	Sim.Gen = SimGen;
+	Sim.GenRaw = 1;
+	Sim.cbIRQ = SimIRQ;
+	lis2hh12Identify(&I2C);
+	lis2hh12_t * psDev = lis2hh12GetDev(&I2C);
+	hostCheck(lis2hh12Config(&I2C) == erSUCCESS, "Config");
+	lis2hh12_cfg_t Cfg = lis2hh12CfgDefault;
+	Cfg.CTRL[0] = makeCTRL1(1,lis2hh12_odr800,1,1,1,1);
+	Cfg.CTRL[2] = makeCTRL3(1,0,0,0,0,0,1,0);
+	Cfg.FIFO_CTRL = makeFIFOC(fmSTREAM, 1);
+	hostCheck(lis2hh12ApplyCfg(psDev, &Cfg) == erSUCCESS, "FIFO stream FTH 1 at 800Hz");
+	lis2hh12SetFIFOBlock(psDev, Blk, lis2hh12FIFO_DEPTH, NULL);
+
+	// 5mS service, 4 samples beyond FTH at decode, margin 2: deepest FTH 31 - 4 - 2
+	ServiceUS = 5000;
+	Windows(psDev, 1, 2, NULL);							// first window learns the ODR
+	int FTH = Windows(psDev, 30 * lis2hh12WM_CLEAN, 2, NULL);
+	u32_t Changes = psDev->WM.Changes;
+	hostCheck(FTH == 25, "FTH settled at %d after %lu changes", FTH, Changes);
+	FTH = Windows(psDev, 5 * lis2hh12WM_CLEAN, 2, NULL);
+	hostCheck(FTH == 25 && psDev->WM.Changes == Changes, "FTH %d held, no probing past the lag", FTH);
+	hostCheck(psDev->Inst.Overrun == 0 && Skipped == 0 && Marked == 0, "no overrun or gap while adapting");
+
+	// consumer stalls 50mS per INTx, FIFO overruns every window: FTH halved each time
+	ServiceUS = 50000;
+	int Trace[5];
+	Windows(psDev, 5, 2, Trace);
+	hostCheck(Trace[0] == 12 && Trace[1] == 6 && Trace[2] == 3 && Trace[3] == 1 && Trace[4] == 1,
+		"overrun halves FTH: %d %d %d %d %d", Trace[0], Trace[1], Trace[2], Trace[3], Trace[4]);
+	hostCheck(psDev->Inst.Overrun > 0 && Skipped > 0, "%lu overruns, %lu samples lost", psDev->Inst.Overrun, Skipped);
+	hostCheck(INRANGE(Skipped * 9 / 10, Marked, Skipped * 11 / 10), "%lu samples marked as gaps, %lu missing", Marked, Skipped);
+
+	// service back to 5mS, climbs again after a clean run
+	ServiceUS = 5000;
+	Windows(psDev, 1, 2, NULL);
+	hostCheck(Windows(psDev, 30 * lis2hh12WM_CLEAN, 2, NULL) == 25, "FTH recovers to 25");
+	return hostResult();
+}
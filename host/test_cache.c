@@ -0,0 +1,64 @@
+// test_cache.c - shadow register cache, bus transactions of a reconfiguration with and without it
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+static lis2hh12_sim_t Sim;
+static i2c_di_t I2C;
+
+/**
+ * @brief		typical reconfiguration, rate, range, filters & inactivity, 10 setters over CTRL1..5 & ACT_x
+ */
+static int Reconfigure(lis2hh12_t * psDev, lis2hh12_odr_t ODR, lis2hh12_fs_t FS) {
+	int iRV = lis2hh12SetODR(psDev, ODR);
+	if (iRV == erSUCCESS) iRV = lis2hh12SetHR(psDev, 1);
+	if (iRV == erSUCCESS) iRV = lis2hh12SetBDU(psDev, 1);
+	if (iRV == erSUCCESS) iRV = lis2hh12SetScale(psDev, FS);
+	if (iRV == erSUCCESS) iRV = lis2hh12SetBW(psDev, bw100);
+	if (iRV == erSUCCESS) iRV = lis2hh12SetFilterAAliasBW(psDev, lis2hh12_aa_bw105Hz);
+	if (iRV == erSUCCESS) iRV = lis2hh12SetFilterLoPassBW(psDev, lis2hh12_lp_odr_div50);
+	if (iRV == erSUCCESS) iRV = lis2hh12SetFilterHiPassBW(psDev, lis2hh12_hp_odr_div100);
+	if (iRV == erSUCCESS) iRV = lis2hh12SetDecimation(psDev, lis2hh12_deci0);
+	if (iRV == erSUCCESS) iRV = lis2hh12SetInactivity(psDev, 4, 2);
+	return iRV;
+}
+
+int main(void) {
+	hostTime = 0;
+	lis2hh12SimInit(&Sim, &I2C);
+	lis2hh12Identify(&I2C);
+	lis2hh12_t * psDev = lis2hh12GetDev(&I2C);
+	hostCheck(lis2hh12Config(&I2C) == erSUCCESS, "Config");
+
+	// uncached, every field change is a read & write back
+	u32_t Trans = psDev->Inst.BusTrans, Bytes = psDev->Inst.BusBytes;
+	hostCheck(Reconfigure(psDev, lis2hh12_odr400, lis2hh12_fs4G) == erSUCCESS, "uncached reconfigure");
+	u32_t TransRMW = psDev->Inst.BusTrans - Trans, BytesRMW = psDev->Inst.BusBytes - Bytes;
+	u8_t Img[lis2hh12CTRL5 - lis2hh12ACT_THS + 1];
+	memcpy(Img, &Sim.Reg[lis2hh12ACT_THS], sizeof(Img));
+	printf("\tuncached: %lu transactions, %lu bytes\n", TransRMW, BytesRMW);
+
+	// back to a different configuration, then the same reconfiguration cached
+	hostCheck(Reconfigure(psDev, lis2hh12_odr100, lis2hh12_fs2G) == erSUCCESS, "uncached reconfigure back");
+	u8_t Prev[sizeof(Img)];
+	memcpy(Prev, &Sim.Reg[lis2hh12ACT_THS], sizeof(Prev));
+	Trans = psDev->Inst.BusTrans;
+	hostCheck(lis2hh12CacheEnable(psDev, 1) == erSUCCESS, "cache enabled");
+	u32_t TransFill = psDev->Inst.BusTrans - Trans;
+	Trans = psDev->Inst.BusTrans, Bytes = psDev->Inst.BusBytes;
+	hostCheck(Reconfigure(psDev, lis2hh12_odr400, lis2hh12_fs4G) == erSUCCESS, "cached reconfigure");
+	hostCheck(psDev->Inst.BusTrans == Trans && memcmp(Prev, &Sim.Reg[lis2hh12ACT_THS], sizeof(Prev)) == 0, "setters stay in the shadow");
+	hostCheck(lis2hh12Commit(psDev) == erSUCCESS && psDev->Dirty == 0, "commit");
+	u32_t TransCache = psDev->Inst.BusTrans - Trans, BytesCache = psDev->Inst.BusBytes - Bytes;
+	printf("\tcached: %lu transactions, %lu bytes, shadow fill %lu transactions\n", TransCache, BytesCache, TransFill);
+	hostCheck(memcmp(Img, &Sim.Reg[lis2hh12ACT_THS], sizeof(Img)) == 0, "device holds the same configuration");
+	hostCheck(TransCache * 2 <= TransRMW && BytesCache * 2 <= BytesRMW, "%lu -> %lu transactions, %lu -> %lu bytes, at least halved",
+		TransRMW, TransCache, BytesRMW, BytesCache);
+	hostCheck((TransCache + TransFill) * 2 <= TransRMW, "still halved including the one off shadow fill");
+
+	// volatile registers bypass the shadow
+	Trans = psDev->Inst.BusTrans;
+	hostCheck(lis2hh12GetDRDY(psDev) == erSUCCESS && psDev->Inst.BusTrans - Trans == 1, "STATUS read from the device while cached");
+	hostCheck(lis2hh12CacheEnable(psDev, 0) == erSUCCESS && psDev->Cached == 0, "cache disabled");
+	return hostResult();
+}
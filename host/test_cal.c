@@ -0,0 +1,111 @@
+// test_cal.c - 6 position & least squares calibration of a synthetic device at every full scale
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+#define	EVAL						20					// orientations checked, none used by the fits
+#define	FIT							14					// least squares orientations: 6 faces & 8 corners
+
+static lis2hh12_t sDev = { .ScaleFS = 0xFF };
+static const f32_t A[3][3] = {							// gain 2-3%, cross axis 1%
+	{ 1.025f, 0.010f, -0.008f },
+	{ -0.010f, 0.980f, 0.009f },
+	{ 0.007f, -0.010f, 1.030f },
+};
+static const f32_t b[3] = { 40.0f, -25.0f, 60.0f };		// mG
+static u32_t Seed = 1;
+
+static f32_t Noise(void) {								// uniform +-1mG
+	Seed = Seed * 1664525 + 1013904223;
+	return (f32_t) (Seed >> 8) / (f32_t) (1 << 23) - 1.0f;
+}
+
+/**
+ * @brief		raw sample of the synthetic device for gravity vector g in G
+ */
+static lis2hh12_xyz_t Raw(const f32_t * g, f32_t LSbMG, f32_t NoiseMG) {
+	lis2hh12_xyz_t XYZ;
+	for (int i = 0; i < 3; ++i) {
+		f32_t S = b[i] + NoiseMG * Noise();
+		for (int j = 0; j < 3; ++j) S += 1000.0f * A[i][j] * g[j];
+		XYZ.Axis[i] = (i16_t) lroundf(S / LSbMG);
+	}
+	return XYZ;
+}
+
+/**
+ * @brief		worst error in mG of both block conversions over the evaluation orientations
+ */
+static f32_t Eval(const f32_t (* pG)[3], f32_t LSbMG) {
+	lis2hh12_xyz_t XYZ[EVAL];
+	i32_t Q16[EVAL * 3];
+	f32_t F32[EVAL * 3];
+	for (int k = 0; k < EVAL; ++k) XYZ[k] = Raw(pG[k], LSbMG, 0.0f);
+	lis2hh12ConvBlockQ16(&sDev, XYZ, Q16, EVAL);
+	lis2hh12ConvBlockF32(&sDev, XYZ, F32, EVAL);
+	f32_t Err = 0.0f;
+	for (int i = 0; i < EVAL * 3; ++i) {
+		f32_t Ref = 1000.0f * pG[i / 3][i % 3];
+		Err = fmaxf(Err, fabsf((f32_t) Q16[i] / 65536.0f - Ref));
+		Err = fmaxf(Err, fabsf(F32[i] * 1000.0f - Ref));
+	}
+	return Err;
+}
+
+int main(void) {
+	static const f32_t Six[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	f32_t Fit[FIT][3], Eg[EVAL][3];
+	memcpy(Fit, Six, sizeof(Six));
+	for (int k = 0; k < 8; ++k) {						// cube corners
+		for (int i = 0; i < 3; ++i) Fit[6 + k][i] = ((k >> i) & 1 ? 1.0f : -1.0f) / sqrtf(3.0f);
+	}
+	for (int k = 0; k < EVAL; ++k) {					// spread over the sphere
+		f32_t Z = 1.0f - (2.0f * k + 1.0f) / EVAL, R = sqrtf(1.0f - Z * Z), Az = 2.39996f * k;
+		Eg[k][0] = R * cosf(Az);
+		Eg[k][1] = R * sinf(Az);
+		Eg[k][2] = Z;
+	}
+	static const lis2hh12_fs_t FSlist[3] = { lis2hh12_fs2G, lis2hh12_fs4G, lis2hh12_fs8G };
+	for (int f = 0; f < 3; ++f) {
+		sDev.Reg.CTRL4 = makeCTRL4(0,FSlist[f],0,1,0,0);
+		lis2hh12CalApply(&sDev, NULL);
+		f32_t LSbMG = lis2hh12ConvCoord(&sDev, 10000) / 10.0f;	// nominal mG/LSb
+		int G = 2 << f;
+		f32_t Nominal = Eval(Eg, LSbMG);
+
+		// 16 sample averages per orientation in nominal mG, as lis2hh12_stat window means, plus
+		// 1mG RMS per orientation the linear model cannot fit, e.g. non-linearity
+		f32_t Meas[FIT][3];
+		for (int k = 0; k < FIT; ++k) {
+			for (int i = 0; i < 3; ++i) Meas[k][i] = 1.732f * Noise();
+			for (int n = 0; n < 16; ++n) {
+				lis2hh12_xyz_t XYZ = Raw(Fit[k], LSbMG, 1.0f);
+				for (int i = 0; i < 3; ++i) Meas[k][i] += XYZ.Axis[i] * LSbMG / 16.0f;
+			}
+		}
+		static lis2hh12_cal_t Cal6, CalLS;
+		int iRV = lis2hh12CalSixPos(&Cal6, Meas);
+		hostCheck(iRV == erSUCCESS && Cal6.Points == 6 && Cal6.ResMG <= 1,
+			"%dG 6 position fit, residual %humG", G, Cal6.ResMG);
+		hostCheck(lis2hh12CalApply(&sDev, &Cal6) == erSUCCESS, "%dG 6 position applied", G);
+		f32_t Err6 = Eval(Eg, LSbMG);
+		iRV = lis2hh12CalFit(&CalLS, Meas, Fit, FIT);
+		hostCheck(iRV == erSUCCESS && CalLS.Points == FIT && INRANGE(1, CalLS.ResMG, 2),
+			"%dG least squares fit of %d, residual %humG", G, FIT, CalLS.ResMG);
+		hostCheck(lis2hh12CalApply(&sDev, &CalLS) == erSUCCESS, "%dG least squares applied", G);
+		f32_t ErrLS = Eval(Eg, LSbMG);
+		hostCheck(Nominal > 40.0f && Err6 < 4.0f && ErrLS < 3.0f, "%dG Q16 & F32 worst error %.1fmG nominal, %.2fmG 6 position, %.2fmG least squares",
+			G, Nominal, Err6, ErrLS);
+		for (int i = 0; i < 3; ++i) {					// M ~ inv(A): M.A diagonal ~1
+			f32_t D = 0.0f;
+			for (int j = 0; j < 3; ++j) D += CalLS.M[i][j] / 65536.0f * A[j][i];
+			hostCheck(fabsf(D - 1.0f) < 0.002f && fabsf(CalLS.B[i] / 65536.0f - (CalLS.M[i][0] * b[0] + CalLS.M[i][1] * b[1] + CalLS.M[i][2] * b[2]) / 65536.0f) < 2.0f,
+				"%dG %c gain %.4f of 1, offset %.1fmG", G, 'X' + i, D, CalLS.B[i] / 65536.0f);
+		}
+	}
+	// degenerate: all orientations in the XY plane do not determine Z
+	f32_t Flat[4][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 } };
+	lis2hh12_cal_t Bad;
+	hostCheck(lis2hh12CalFit(&Bad, Flat, Flat, 4) == erINV_PARA, "orientations not spanning Z refused");
+	return hostResult();
+}
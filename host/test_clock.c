@@ -0,0 +1,75 @@
+// test_clock.c - sample timestamps against a chip model whose clock is off nominal by a known ppm
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+#define	TRUE_SIZE					4096				// power of 2, > samples in flight
+
+static lis2hh12_sim_t Sim;
+static i2c_di_t I2C;
+static lis2hh12_xyz_t Blk[lis2hh12FIFO_DEPTH];
+static u64_t TrueTS[TRUE_SIZE];							// model sample time by sequence number
+static u16_t Seq;
+
+static lis2hh12_xyz_t SimGen(lis2hh12_sim_t * psSim, u64_t TS) {	// raw X is the sequence number
+	TrueTS[Seq % TRUE_SIZE] = TS;
+	lis2hh12_xyz_t XYZ = { .X = (i16_t) Seq++, .Y = 0, .Z = 16384 };
+	return XYZ;
+}
+
+static void SimIRQ(void * Arg) { hostGPIOraise(lis2hh12IRQ_PIN); }
+
+/**
+ * @brief		run at 800Hz in 25uS steps, timestamp error measured after the estimator had LockMS to settle
+ */
+static void Run(lis2hh12_t * psDev, i32_t PPM, u32_t LockMS, u32_t RunMS) {
+	Sim.PPM = PPM;
+	u32_t Samples = 0;
+	i64_t ErrMax = 0, ErrSum = 0;
+	for (u32_t Step = 0; Step < RunMS * 40; ++Step) {
+		hostTime += 25;
+		lis2hh12SimTick(&Sim, hostTime);
+		lis2hh12_sample_t * psS;
+		size_t Count;
+		while ((Count = lis2hh12RingPeek(&psDev->Ring, &psS))) {
+			for (size_t i = 0; i < Count && Step >= LockMS * 40; ++i, ++Samples) {
+				i64_t Err = (i64_t) psS[i].TS - (i64_t) TrueTS[(u16_t) psS[i].XYZ.X % TRUE_SIZE];
+				ErrSum += Err;
+				if (Err < 0) Err = -Err;
+				if (Err > ErrMax) ErrMax = Err;
+			}
+			lis2hh12RingRelease(&psDev->Ring, Count);
+		}
+	}
+	lis2hh12_clk_t * psClk = &psDev->Clk;
+	i32_t Drift = (i32_t) (((i64_t) (psClk->Period - psClk->Nominal) * 1000000) / (i64_t) psClk->Nominal);
+	i32_t Mean = Samples ? (i32_t) (ErrSum / Samples) : 0;
+	u32_t Expect = (u32_t) (((u64_t) (RunMS - LockMS) * 800000) / (1000000 + PPM));	// 800Hz skewed
+	hostCheck(INRANGE(Expect - lis2hh12FIFO_DEPTH, Samples, Expect + lis2hh12FIFO_DEPTH), "%+dppm: %u samples timed after lock, %u expected", PPM, Samples, Expect);
+	hostCheck(INRANGE(PPM - 1000, Drift, PPM + 1000), "%+dppm: period %.3fuS, estimated %+dppm", PPM, (f32_t) psClk->Period / 65536.0f, Drift);
+	hostCheck(ErrMax <= 125, "%+dppm: timestamp error max %duS (period 1250uS), mean %+duS", PPM, (i32_t) ErrMax, Mean);
+	hostCheck(psDev->Inst.Overrun == 0, "%+dppm: no overrun", PPM);
+}
+
+int main(void) {
+	hostTime = 0;
+	lis2hh12SimInit(&Sim, &I2C);
+	Sim.Gen = SimGen;
+	Sim.GenRaw = 1;
+	Sim.cbIRQ = SimIRQ;
+	lis2hh12Identify(&I2C);
+	lis2hh12_t * psDev = lis2hh12GetDev(&I2C);
+	hostCheck(lis2hh12Config(&I2C) == erSUCCESS, "Config");
+	lis2hh12_cfg_t Cfg = lis2hh12CfgDefault;
+	Cfg.CTRL[0] = makeCTRL1(1,lis2hh12_odr800,1,1,1,1);
+	Cfg.CTRL[2] = makeCTRL3(1,0,0,0,0,0,1,0);
+	Cfg.FIFO_CTRL = makeFIFOC(fmSTREAM, 16);
+	hostCheck(lis2hh12ApplyCfg(psDev, &Cfg) == erSUCCESS, "FIFO stream FTH 16 at 800Hz");
+	lis2hh12SetFIFOBlock(psDev, Blk, lis2hh12FIFO_DEPTH, NULL);
+
+	// oscillator a few % off nominal either way, then a step change the loop has to follow
+	Run(psDev, 0, 2000, 5000);
+	Run(psDev, 30000, 3000, 10000);
+	Run(psDev, -25000, 3000, 10000);
+	return hostResult();
+}
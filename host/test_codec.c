@@ -0,0 +1,95 @@
+// test_codec.c - recording codec round trip, lost samples carried across the sync points they force
+//
+// usage: test_codec [Recording]	saves the round trip recording for lis2hh12_decode
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+#define testSAMPLES				4000
+
+static lis2hh12_t sDev;
+static lis2hh12_sample_t In[testSAMPLES], Out[testSAMPLES + 16];
+static u8_t Buf[testSAMPLES * 8];
+
+/**
+ * @brief		encoded size of 800Hz 2G HR data: 1G on Z, 100mG 20Hz vibration on X, uniform noise on all axes
+ * @param[in]	NoisemG - peak noise in mG, 1mG ~ 16 LSb
+ * @return		bytes per sample x 100
+ */
+static u32_t Size(int NoisemG) {
+	u32_t Seed = 1;
+	for (int i = 0; i < testSAMPLES; ++i) {
+		In[i].TS = 1000000 + i * 1250;
+		In[i].Gap = 0;
+		for (int a = 0; a < 3; ++a) {
+			Seed = Seed * 1664525 + 1013904223;
+			f32_t mG = (a == 0 ? 100 * sin(2 * M_PI * 20 * i / 800.0) : a == 2 ? 1000 : 0) +
+				NoisemG * ((Seed >> 8) / 8388608.0 - 1.0);
+			In[i].XYZ.Axis[a] = (i16_t) lrint(mG / 0.061);
+		}
+	}
+	lis2hh12_enc_t sEnc;
+	lis2hh12EncInit(&sEnc, Buf, sizeof(Buf), 256);
+	lis2hh12EncHeader(&sEnc, &sDev, In[0].TS);
+	lis2hh12EncBlock(&sEnc, In, testSAMPLES);
+	return sEnc.Len * 100 / testSAMPLES;
+}
+
+int main(int argc, char ** argv) {
+	for (int NoisemG = 0; NoisemG <= 8; NoisemG = NoisemG ? NoisemG * 2 : 1) {	// size against the 2-3 B/sample target
+		u32_t BpS = Size(NoisemG);
+		printf("\tnoise +-%dmG: %lu.%02lu B/sample\n", NoisemG, BpS / 100, BpS % 100);
+	}
+
+	static const u16_t GapAt[] = { 0, 17, 18, 500, 1024, 3999 };	// first, adjacent, group & chunk edges, last
+	u64_t TS = 1000000;
+	for (int i = 0, g = 0; i < testSAMPLES; ++i) {
+		u16_t Gap = (g < sizeof(GapAt) / sizeof(GapAt[0]) && GapAt[g] == i) ? 3 * ++g : 0;
+		TS += (u64_t) (1 + Gap) * 1250;
+		In[i].TS = TS;
+		In[i].Gap = Gap;
+		for (int a = 0; a < 3; ++a) In[i].XYZ.Axis[a] = (i16_t) (4000 * sin((i + Gap) * 0.01 * (a + 1)) + (a == 2 ? 16384 : 0));
+	}
+	In[GapAt[5]].Gap = 0xFFFF;								// saturated
+
+	lis2hh12_enc_t sEnc;
+	hostCheck(lis2hh12EncInit(&sEnc, Buf, sizeof(Buf), 256) == erSUCCESS && lis2hh12EncHeader(&sEnc, &sDev, In[0].TS) == erSUCCESS, "encoder");
+	size_t Done = 0;
+	while (Done < testSAMPLES) {							// odd sized chunks as drained from the ring
+		size_t Chunk = (testSAMPLES - Done < 100) ? testSAMPLES - Done : 100;
+		Done += lis2hh12EncBlock(&sEnc, &In[Done], Chunk);
+	}
+	if (argc > 1) {
+		FILE * psF = fopen(argv[1], "wb");
+		hostCheck(psF && fwrite(Buf, 1, sEnc.Len, psF) == sEnc.Len && fclose(psF) == 0, "saved %s", argv[1]);
+	}
+	printf("\t%lu samples in %lu bytes, %lu.%02lu B/sample\n", sEnc.Samples, sEnc.Len, sEnc.Len / testSAMPLES, (sEnc.Len * 100 / testSAMPLES) % 100);
+
+	lis2hh12_dec_t sDec;
+	int iRV = lis2hh12DecInit(&sDec, Buf, sEnc.Len);
+	hostCheck(iRV == erSUCCESS && sDec.Hdr.Version == 2, "decoder, version %d", sDec.Hdr.Version);
+	size_t Count = 0;
+	int N;
+	while ((N = lis2hh12DecBlock(&sDec, &Out[Count], testSAMPLES + 16 - Count)) > 0) Count += N;
+	u32_t BadXYZ = 0, BadGap = 0, BadTS = 0;
+	for (size_t i = 0; i < Count && i < testSAMPLES; ++i) {
+		BadXYZ += memcmp(&Out[i].XYZ, &In[i].XYZ, sizeof(lis2hh12_xyz_t)) != 0;
+		BadGap += Out[i].Gap != In[i].Gap;
+		BadTS += (Out[i].TS > In[i].TS + 2 || Out[i].TS + 2 < In[i].TS);
+	}
+	hostCheck(Count == testSAMPLES && sDec.Resync == 0, "%lu samples decoded, %lu bytes skipped", Count, sDec.Resync);
+	hostCheck(BadXYZ == 0 && BadGap == 0, "samples bit exact (%lu bad), gaps restored (%lu bad)", BadXYZ, BadGap);
+	hostCheck(BadTS == 0, "times within 2uS across the gaps (%lu bad)", BadTS);
+	N = lis2hh12DecBlock(&sDec, Out, 0);
+	hostCheck(N == 0, "end of data %d", N);
+
+	// room for less than the next group: refused with nothing consumed, never mistaken for the end
+	lis2hh12DecInit(&sDec, Buf, sEnc.Len);
+	int N1 = lis2hh12DecBlock(&sDec, Out, 1);
+	size_t Pos = sDec.Pos;
+	int N15 = lis2hh12DecBlock(&sDec, &Out[1], 15), N0 = lis2hh12DecBlock(&sDec, &Out[1], 0);
+	hostCheck(N1 == 1 && N15 == lis2hh12_codecINV_SIZE && N0 == lis2hh12_codecINV_SIZE && sDec.Pos == Pos, "sync point in 1, group refused in 15 (%d) & 0 (%d)", N15, N0);
+	N = lis2hh12DecBlock(&sDec, &Out[1], 16);
+	hostCheck(N == 16 && memcmp(&Out[16].XYZ, &In[16].XYZ, sizeof(lis2hh12_xyz_t)) == 0, "group decoded in 16");
+	return hostResult();
+}
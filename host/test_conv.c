@@ -0,0 +1,31 @@
+// test_conv.c - block conversion against lis2hh12ConvCoord() at every full scale setting
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+static lis2hh12_t sDev = { .ScaleFS = 0xFF };
+static lis2hh12_xyz_t XYZ[lis2hh12FIFO_DEPTH];
+static i32_t Q16[lis2hh12FIFO_DEPTH * 3];
+static f32_t F32[lis2hh12FIFO_DEPTH * 3];
+
+int main(void) {
+	for (int i = 0; i < lis2hh12FIFO_DEPTH; ++i) {
+		XYZ[i].X = (i16_t) (i * 2047 - 32768);
+		XYZ[i].Y = (i16_t) (32767 - i * 1999);
+		XYZ[i].Z = (i16_t) (i * 3 - 40);
+	}
+	for (int FS = 0; FS < 4; ++FS) {					// fs=1 reserved, same result as 8G
+		sDev.Reg.CTRL4 = makeCTRL4(0,FS,0,1,0,0);
+		lis2hh12ConvBlockQ16(&sDev, XYZ, Q16, lis2hh12FIFO_DEPTH);
+		lis2hh12ConvBlockF32(&sDev, XYZ, F32, lis2hh12FIFO_DEPTH);
+		f32_t ErrF = 0.0f, ErrQ = 0.0f;
+		for (int i = 0; i < lis2hh12FIFO_DEPTH * 3; ++i) {
+			f32_t G = lis2hh12ConvCoord(&sDev, XYZ[i / 3].Axis[i % 3]);
+			ErrF = fmaxf(ErrF, fabsf(F32[i] - G));
+			ErrQ = fmaxf(ErrQ, fabsf((f32_t) Q16[i] / 65536000.0f - G) / fmaxf(fabsf(G), 0.001f));
+		}
+		hostCheck(ErrF == 0.0f, "fs=%d F32 matches ConvCoord", FS);
+		hostCheck(ErrQ < 0.0001f, "fs=%d Q16 within %.1fppm of ConvCoord", FS, ErrQ * 1e6f);	// Q16 scale rounding
+	}
+	return hostResult();
+}
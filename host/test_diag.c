@@ -0,0 +1,52 @@
+// test_diag.c - self test against the chip model, pass/fail limits, duration & configuration restore
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+static lis2hh12_sim_t Sim;
+static i2c_di_t I2C;
+
+static void Tick(void) { lis2hh12SimTick(&Sim, hostTime + 1000); }	// samples due by the end of the delay
+
+int main(void) {
+	hostTime = 0;
+	hostDelayHook = Tick;
+	lis2hh12SimInit(&Sim, &I2C);
+	Sim.Noise = 20;
+	lis2hh12Identify(&I2C);
+	lis2hh12_t * psDev = lis2hh12GetDev(&I2C);
+	hostCheck(lis2hh12Config(&I2C) == erSUCCESS, "Config");
+
+	// application profile: 100Hz, 4G, decimating CTRL5 & active-low INTx, FIFO stream on INT1 FTH
+	lis2hh12_cfg_t Cfg = lis2hh12CfgDefault;
+	Cfg.CTRL[0] = makeCTRL1(1,lis2hh12_odr100,1,1,1,1);
+	Cfg.CTRL[2] = makeCTRL3(1,0,0,0,0,0,1,0);
+	Cfg.CTRL[3] = makeCTRL4(0,lis2hh12_fs4G,0,1,0,0);
+	Cfg.CTRL[4] = makeCTRL5(0,0,lis2hh12_deci4,0,1,0);
+	Cfg.FIFO_CTRL = makeFIFOC(fmSTREAM, 16);
+	hostCheck(lis2hh12ApplyCfg(psDev, &Cfg) == erSUCCESS, "profile with CTRL5 x%02X", Cfg.CTRL[4]);
+
+	lis2hh12_st_t sST;
+	int iRV = lis2hh12SelfTest(psDev, &sST);
+	hostCheck(iRV == erSUCCESS && sST.Done && sST.Fail == 0, "default %dmG self test passes", Sim.STmG);
+	for (int a = 0; a < 3; ++a) {
+		i32_t dPos = sST.Pos[a] - sST.Base[a], dNeg = sST.Base[a] - sST.Neg[a];
+		hostCheck(INRANGE(380, dPos, 420) && INRANGE(380, dNeg, 420), "%c +%ld -%ldmG", 'X' + a, dPos, dNeg);
+	}
+	hostCheck(sST.DurUS < 100000, "%luuS, below 100mS", sST.DurUS);
+	hostCheck(lis2hh12VerifyCfg(psDev, &Cfg) == erSUCCESS, "device profile unchanged afterwards");
+	hostCheck(memcmp(&psDev->Reg.CTRL1, Cfg.CTRL, sizeof(Cfg.CTRL)) == 0 && psDev->Reg.FIFO_CTRL == Cfg.FIFO_CTRL, "shadow profile unchanged");
+	lis2hh12ReportSelfTest(NULL, &sST);
+
+	// no proof mass movement, every axis fails both ways and the profile is still restored
+	Sim.STmG = 0;
+	iRV = lis2hh12SelfTest(psDev, &sST);
+	hostCheck(iRV == erFAILURE && sST.Done && sST.Fail == 0x3F, "STmG=0 fails, Fail=x%02X", sST.Fail);
+	hostCheck(lis2hh12VerifyCfg(psDev, &Cfg) == erSUCCESS, "device profile unchanged after a failure");
+
+	// beyond the upper limit
+	Sim.STmG = lis2hh12ST_MAX_MG + 100;
+	iRV = lis2hh12SelfTest(psDev, &sST);
+	hostCheck(iRV == erFAILURE && sST.Fail, "STmG=%dmG fails, Fail=x%02X", Sim.STmG, sST.Fail);
+	return hostResult();
+}
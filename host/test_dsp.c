@@ -0,0 +1,156 @@
+// test_dsp.c - DC removal over the full i16 range, biquad response & decimation, timestamps through Deliver
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+#define	FS							800.0				// Hz, ODR
+#define	AMP							8000.0				// LSb, test tone
+#define	TRUE_SIZE					4096				// power of 2, > samples in flight
+
+static lis2hh12_dsp_t sDsp;
+static lis2hh12_sim_t Sim;
+static i2c_di_t I2C;
+static lis2hh12_xyz_t Blk[lis2hh12FIFO_DEPTH];
+static u64_t TrueTS[TRUE_SIZE];							// model sample time by sequence number
+static u16_t Seq;
+
+static lis2hh12_xyz_t SimGen(lis2hh12_sim_t * psSim, u64_t TS) {	// raw X is the sequence number
+	TrueTS[Seq % TRUE_SIZE] = TS;
+	lis2hh12_xyz_t XYZ = { .X = (i16_t) Seq++, .Y = 0, .Z = 16384 };
+	return XYZ;
+}
+
+static void SimIRQ(void * Arg) { hostGPIOraise(lis2hh12IRQ_PIN); }
+
+/**
+ * @brief		|H(f)| of the unquantised RBJ design
+ */
+static f64_t RefGain(lis2hh12_bq_type_t Type, f64_t Fc, f64_t Q, f64_t F) {
+	f64_t W0 = 2.0 * M_PI * Fc / FS, C = cos(W0), Alpha = sin(W0) / (2.0 * Q), b0, b1, b2;
+	switch (Type) {
+	case lis2hh12_bqLOPASS:		b1 = 1.0 - C;	b0 = b2 = b1 / 2.0;			break;
+	case lis2hh12_bqHIPASS:		b1 = -(1.0 + C); b0 = b2 = -b1 / 2.0;		break;
+	case lis2hh12_bqBANDPASS:	b0 = Alpha;	b1 = 0.0;	b2 = -Alpha;		break;
+	default:					b0 = b2 = 1.0;	b1 = -2.0 * C;				break;
+	}
+	f64_t W = 2.0 * M_PI * F / FS, a0 = 1.0 + Alpha, a1 = -2.0 * C, a2 = 1.0 - Alpha;
+	f64_t NumR = b0 + b1 * cos(W) + b2 * cos(2 * W), NumI = -b1 * sin(W) - b2 * sin(2 * W);
+	f64_t DenR = a0 + a1 * cos(W) + a2 * cos(2 * W), DenI = -a1 * sin(W) - a2 * sin(2 * W);
+	return sqrt((NumR * NumR + NumI * NumI) / (DenR * DenR + DenI * DenI));
+}
+
+/**
+ * @brief		steady state gain of a single biquad at F Hz, tone correlated over a whole number of cycles
+ */
+static f64_t Gain(lis2hh12_bq_type_t Type, f64_t Fc, f64_t Q, f64_t F) {
+	lis2hh12DspInit(&sDsp, 1, 0);
+	lis2hh12DspAddFilter(&sDsp, Type, FS, Fc, Q);
+	f64_t I = 0.0, IQ = 0.0;
+	for (int n = 0; n < 4000; ++n) {					// 2400 settling, 1600 = 2 seconds measured
+		f64_t Ph = 2.0 * M_PI * F * n / FS;
+		lis2hh12_xyz_t T = { .X = (i16_t) lround(AMP * sin(Ph)) };
+		lis2hh12DspRun(&sDsp, &T, 1);
+		if (n < 2400) continue;
+		I += T.X * sin(Ph);
+		IQ += T.X * cos(Ph);
+	}
+	return 2.0 * sqrt(I * I + IQ * IQ) / 1600.0 / AMP;
+}
+
+int main(void) {
+	for (u8_t Shift = 1; Shift <= 15; Shift += 7) {
+		lis2hh12DspInit(&sDsp, 1, Shift);
+		lis2hh12_xyz_t XYZ = { .X = INT16_MIN, .Y = INT16_MAX, .Z = 0 };
+		for (int i = 0; i < (1 << 20); ++i) {				// settle on the negative rail
+			lis2hh12_xyz_t T = XYZ;
+			lis2hh12DspRun(&sDsp, &T, 1);
+		}
+		u32_t Wrong = 0;
+		i32_t Last = 0;
+		XYZ = (lis2hh12_xyz_t) { .X = INT16_MAX, .Y = INT16_MIN, .Z = 0 };
+		for (int i = 0; i < (1 << 20); ++i) {				// step to the positive rail, output decays to 0 from +
+			lis2hh12_xyz_t T = XYZ;
+			lis2hh12DspRun(&sDsp, &T, 1);
+			Wrong += (T.X < 0 || T.Y > 0);
+			Last = T.X;
+		}
+		hostCheck(Wrong == 0 && Last <= 1, "DCshift %d: rail to rail step, %lu outputs of the wrong sign, settled at %ld", Shift, Wrong, Last);
+	}
+
+	// Butterworth low pass 50Hz & notch 50Hz Q5 at 800Hz, Q14 response within 1% of the design
+	static const struct { lis2hh12_bq_type_t Type; f64_t Fc, Q, F; const char * pcName; } Tone[] = {
+		{ lis2hh12_bqLOPASS, 50, 0.7071, 10, "LP" }, { lis2hh12_bqLOPASS, 50, 0.7071, 50, "LP" }, { lis2hh12_bqLOPASS, 50, 0.7071, 200, "LP" },
+		{ lis2hh12_bqNOTCH, 50, 5, 10, "notch" }, { lis2hh12_bqNOTCH, 50, 5, 45, "notch" }, { lis2hh12_bqNOTCH, 50, 5, 100, "notch" },
+	};
+	for (size_t t = 0; t < sizeof(Tone) / sizeof(Tone[0]); ++t) {
+		f64_t G = Gain(Tone[t].Type, Tone[t].Fc, Tone[t].Q, Tone[t].F), Ref = RefGain(Tone[t].Type, Tone[t].Fc, Tone[t].Q, Tone[t].F);
+		hostCheck(fabs(G - Ref) <= 0.01, "%s %.0fHz at %.0fHz: gain %.4f, design %.4f", Tone[t].pcName, Tone[t].Fc, Tone[t].F, G, Ref);
+	}
+	f64_t G = Gain(lis2hh12_bqLOPASS, 50, 0.7071, 50);
+	hostCheck(fabs(20.0 * log10(G) + 3.01) <= 0.1, "LP corner %.2fdB", 20.0 * log10(G));
+	G = Gain(lis2hh12_bqNOTCH, 50, 5, 50);
+	hostCheck(G <= 0.01, "notch centre %.1fdB", 20.0 * log10(G));
+
+	// decimation by 4 over blocks of 1..13 samples: 1 output per 4 inputs, phase carried across blocks
+	lis2hh12DspInit(&sDsp, 4, 0);
+	u32_t In = 0, Out = 0, Wrong = 0;
+	for (int b = 0; b < 100; ++b) {
+		size_t Count = b % 13 + 1;
+		lis2hh12_xyz_t T[13];
+		for (size_t i = 0; i < Count; ++i) T[i] = (lis2hh12_xyz_t) { .X = (i16_t) (In + i) };
+		In += Count;
+		size_t N = lis2hh12DspRun(&sDsp, T, Count);
+		for (size_t i = 0; i < N; ++i, ++Out) Wrong += (T[i].X != (i16_t) (4 * Out + 3));
+		Wrong += (sDsp.Phase != In % 4);
+	}
+	hostCheck(Out == In / 4 && Wrong == 0, "decimate by 4: %lu inputs, %lu outputs, %lu wrong", In, Out, Wrong);
+
+	// Deliver: FTH 10 at 800Hz decimated by 4, blocks end mid phase. Each output carries the time of
+	// the input that completed it, Period scaled by Decim
+	hostTime = 0;
+	lis2hh12SimInit(&Sim, &I2C);
+	Sim.Gen = SimGen;
+	Sim.GenRaw = 1;
+	Sim.cbIRQ = SimIRQ;
+	lis2hh12Identify(&I2C);
+	lis2hh12_t * psDev = lis2hh12GetDev(&I2C);
+	hostCheck(lis2hh12Config(&I2C) == erSUCCESS, "Config");
+	lis2hh12_cfg_t Cfg = lis2hh12CfgDefault;
+	Cfg.CTRL[0] = makeCTRL1(1,lis2hh12_odr800,1,1,1,1);
+	Cfg.CTRL[2] = makeCTRL3(1,0,0,0,0,0,1,0);
+	Cfg.FIFO_CTRL = makeFIFOC(fmSTREAM, 10);
+	hostCheck(lis2hh12ApplyCfg(psDev, &Cfg) == erSUCCESS, "FIFO stream FTH 10 at 800Hz");
+	lis2hh12SetFIFOBlock(psDev, Blk, lis2hh12FIFO_DEPTH, NULL);
+	lis2hh12DspInit(&sDsp, 4, 0);
+	psDev->psDsp = &sDsp;
+	u32_t Samples = 0, Skips = 0;
+	i64_t ErrMax = 0, StepMax = 0, StepMin = INT64_MAX;
+	u64_t LastTS = 0;
+	i16_t LastX = 0;
+	for (u32_t Step = 0; Step < 4000 * 40; ++Step) {		// 4 seconds in 25uS steps, timed after 2
+		hostTime += 25;
+		lis2hh12SimTick(&Sim, hostTime);
+		lis2hh12_sample_t * psS;
+		size_t Count;
+		while ((Count = lis2hh12RingPeek(&psDev->Ring, &psS))) {
+			for (size_t i = 0; i < Count; ++i) {
+				if (Step >= 2000 * 40) {
+					i64_t Err = (i64_t) psS[i].TS - (i64_t) TrueTS[(u16_t) psS[i].XYZ.X % TRUE_SIZE];
+					i64_t Dt = (i64_t) (psS[i].TS - LastTS);
+					ErrMax = (Err < 0 ? -Err : Err) > ErrMax ? (Err < 0 ? -Err : Err) : ErrMax;
+					if (Dt > StepMax) StepMax = Dt;
+					if (Dt < StepMin) StepMin = Dt;
+					Skips += (psS[i].XYZ.X != (i16_t) (LastX + 4));
+					++Samples;
+				}
+				LastTS = psS[i].TS;
+				LastX = psS[i].XYZ.X;
+			}
+			lis2hh12RingRelease(&psDev->Ring, Count);
+		}
+	}
+	hostCheck(INRANGE(395, Samples, 400) && Skips == 0 && (LastX & 3) == 3, "%lu outputs at 200Hz, %lu skipped", Samples, Skips);
+	hostCheck(ErrMax <= 125, "timestamp error max %duS against the completing input", (i32_t) ErrMax);
+	hostCheck(INRANGE(5000 - 250, StepMin, StepMax) && StepMax <= 5000 + 250, "output spacing %d..%duS, 4 x 1250", (i32_t) StepMin, (i32_t) StepMax);
+	return hostResult();
+}
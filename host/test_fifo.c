@@ -0,0 +1,71 @@
+// test_fifo.c - FIFO drain over the I2C transport, transactions per sample counted by the halI2C_Queue() stub
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+static lis2hh12_sim_t Sim;
+static i2c_di_t I2C;
+static lis2hh12_xyz_t Blk[lis2hh12FIFO_DEPTH];
+
+static lis2hh12_xyz_t SimGen(lis2hh12_sim_t * psSim, u64_t TS) {	// raw X counts samples at 800Hz
+	lis2hh12_xyz_t XYZ = { .X = (i16_t) (TS / 1250), .Y = 0, .Z = 16384 };
+	return XYZ;
+}
+
+static void SimIRQ(void * Arg) { hostGPIOraise(lis2hh12IRQ_PIN); }
+
+/**
+ * @brief		run 1s at 800Hz, FTH 16, with or without a block buffer
+ * @return		halI2C_Queue() transactions per 1000 samples
+ */
+static u32_t Drain(lis2hh12_t * psDev, bool Burst) {
+	lis2hh12SetFIFOBlock(psDev, Burst ? Blk : NULL, lis2hh12FIFO_DEPTH, NULL);
+	u32_t Samples = 0, Skips = 0, Trans0 = hostI2Ctrans;
+	i16_t Last = 0;
+	for (int ms = 0; ms < 1000; ++ms) {
+		hostTime += 1000;
+		lis2hh12SimTick(&Sim, hostTime);
+		lis2hh12_sample_t * psS;
+		size_t Count;
+		while ((Count = lis2hh12RingPeek(&psDev->Ring, &psS))) {
+			for (size_t i = 0; i < Count; ++i, ++Samples) {
+				if (Samples && psS[i].XYZ.X != (i16_t) (Last + 1)) ++Skips;
+				Last = psS[i].XYZ.X;
+			}
+			lis2hh12RingRelease(&psDev->Ring, Count);
+		}
+	}
+	u32_t Trans = hostI2Ctrans - Trans0;
+	u32_t TpKS = Samples ? (Trans * 1000) / Samples : 0;
+	hostCheck(INRANGE(784, Samples, 800) && Skips == 0, "%s: %lu samples in sequence, %lu skipped", Burst ? "burst" : "single", Samples, Skips);
+	hostCheck(psDev->Inst.Overrun == 0 && psDev->Inst.IRQlost == 0, "%s: no overrun or lost IRQ", Burst ? "burst" : "single");
+	printf("\t%s: %lu transactions, %lu bytes, %lu.%03lu transactions/sample\n", Burst ? "burst" : "single",
+		Trans, hostI2Cbytes, TpKS / 1000, TpKS % 1000);
+	return TpKS;
+}
+
+int main(void) {
+	hostTime = 0;
+	lis2hh12SimInit(&Sim, &I2C);
+	Sim.Gen = SimGen;
+	Sim.GenRaw = 1;
+	Sim.cbIRQ = SimIRQ;
+	hostI2Cattach(&I2C, &Sim);
+	lis2hh12Identify(&I2C);
+	lis2hh12_t * psDev = lis2hh12GetDev(&I2C);
+	psDev->psBus = &lis2hh12BusI2C;						// through halI2C_Queue() from here on
+	hostCheck(lis2hh12Config(&I2C) == erSUCCESS, "Config over I2C");
+	lis2hh12_cfg_t Cfg = lis2hh12CfgDefault;
+	Cfg.CTRL[0] = makeCTRL1(1,lis2hh12_odr800,1,1,1,1);
+	Cfg.CTRL[2] = makeCTRL3(1,0,0,0,0,0,1,0);
+	Cfg.FIFO_CTRL = makeFIFOC(fmSTREAM, 16);
+	hostCheck(lis2hh12ApplyCfg(psDev, &Cfg) == erSUCCESS, "FIFO stream FTH 16 at 800Hz");
+
+	// status burst + 1 FIFO burst per 16 samples, against status burst + 16 single reads
+	u32_t Burst = Drain(psDev, true);
+	hostCheck(Burst == 125, "burst %lu transactions/1000 samples, 2 per FTH", Burst);
+	hostI2Cbytes = 0;
+	u32_t Single = Drain(psDev, false);
+	hostCheck(INRANGE(1062, Single, 1063), "single %lu transactions/1000 samples, 1 + FTH per FTH", Single);
+	return hostResult();
+}
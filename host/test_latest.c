@@ -0,0 +1,17 @@
+// test_latest.c - latest sample sequence lock, writer against reader threads
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+int main(void) {
+	lis2hh12_latest_t sL = { 0 }, sOut;
+	hostCheck(lis2hh12LatestGet(&sL, &sOut) == erINV_STATE, "nothing published yet");
+	lis2hh12_xyz_t XYZ = { .X = 1, .Y = -2, .Z = 3 };
+	lis2hh12LatestPut(&sL, &XYZ, 1234, 0x0F, 0x10);
+	hostCheck(lis2hh12LatestGet(&sL, &sOut) == erSUCCESS && sOut.Seq == 2 && sOut.TS == 1234 &&
+		!memcmp(&sOut.XYZ, &XYZ, sizeof(XYZ)) && sOut.STATUS == 0x0F && sOut.FIFO_SRC == 0x10, "single snapshot");
+	for (u32_t Readers = 1; Readers <= 4; Readers *= 2) {	// reader tasks are threads on any core
+		hostCheck(lis2hh12LatestStress(NULL, Readers, 500) == erSUCCESS, "%lu readers, no torn or backward snapshot", Readers);
+	}
+	return hostResult();
+}
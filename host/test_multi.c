@@ -0,0 +1,69 @@
+// test_multi.c - lis2hh12MAX_DEV devices, each on its own chip model and INTx pin, serviced together
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+static const u8_t ODR[lis2hh12MAX_DEV] = { lis2hh12_odr800, lis2hh12_odr400, lis2hh12_odr100, lis2hh12_odr800 };
+static const u8_t FTH[lis2hh12MAX_DEV] = { 16, 8, 0, 24 };	// 0 = DRDY, FIFO bypassed
+static const i8_t Pin[lis2hh12MAX_DEV] = lis2hh12IRQ_PINS;
+
+static lis2hh12_sim_t Sim[lis2hh12MAX_DEV];
+static i2c_di_t I2C[lis2hh12MAX_DEV];
+static lis2hh12_xyz_t Blk[lis2hh12MAX_DEV][lis2hh12FIFO_DEPTH];
+static lis2hh12_t * psDev[lis2hh12MAX_DEV];
+static u32_t Samples[lis2hh12MAX_DEV], Foreign[lis2hh12MAX_DEV];
+
+static lis2hh12_xyz_t SimGen(lis2hh12_sim_t * psSim, u64_t TS) {	// raw X identifies the model
+	lis2hh12_xyz_t XYZ = { .X = (i16_t) (1000 * (psSim - Sim) + 1), .Y = (i16_t) (TS / 1000), .Z = 16384 };
+	return XYZ;
+}
+
+static void SimIRQ(void * Arg) { hostGPIOraise(((lis2hh12_t *) Arg)->IRQpin); }
+
+int main(void) {
+	hostTime = 0;
+	for (int i = 0; i < lis2hh12MAX_DEV; ++i) {
+		lis2hh12SimInit(&Sim[i], &I2C[i]);
+		Sim[i].Gen = SimGen;
+		Sim[i].GenRaw = 1;
+		Sim[i].cbIRQ = SimIRQ;
+	}
+	for (int i = 0; i < lis2hh12MAX_DEV; ++i) {
+		hostCheck(lis2hh12Identify(&I2C[i]) == erSUCCESS && lis2hh12Config(&I2C[i]) == erSUCCESS, "device %d identified & configured", i);
+		psDev[i] = lis2hh12GetDev(&I2C[i]);
+		hostCheck(psDev[i] == &sLIS2HH12[i] && psDev[i]->psSim == &Sim[i] && psDev[i]->IRQpin == Pin[i],
+			"device %d handle, model & INTx pin %d", i, Pin[i]);
+		lis2hh12_cfg_t Cfg = lis2hh12CfgDefault;
+		Cfg.CTRL[0] = makeCTRL1(1,ODR[i],1,1,1,1);
+		Cfg.CTRL[2] = FTH[i] ? makeCTRL3(1,0,0,0,0,0,1,0) : makeCTRL3(0,0,0,0,0,0,0,1);
+		Cfg.FIFO_CTRL = FTH[i] ? makeFIFOC(fmSTREAM, FTH[i]) : makeFIFOC(fmBYPASS, 0);
+		hostCheck(lis2hh12ApplyCfg(psDev[i], &Cfg) == erSUCCESS, "device %d profile applied", i);
+		lis2hh12SetFIFOBlock(psDev[i], Blk[i], lis2hh12FIFO_DEPTH, NULL);
+	}
+	i2c_di_t sExtra = { 0 };
+	hostCheck(lis2hh12Identify(&sExtra) == erFAILURE, "no handle beyond lis2hh12MAX_DEV");
+	for (int i = 0; i < lis2hh12MAX_DEV; ++i) lis2hh12InstSnapshot(psDev[i], NULL, true);
+
+	for (int ms = 0; ms < 2000; ++ms) {					// all models stepped together, 1mS service
+		hostTime += 1000;
+		for (int i = 0; i < lis2hh12MAX_DEV; ++i) lis2hh12SimTick(&Sim[i], hostTime);
+		for (int i = 0; i < lis2hh12MAX_DEV; ++i) {
+			lis2hh12_sample_t * psS;
+			size_t Count;
+			while ((Count = lis2hh12RingPeek(&psDev[i]->Ring, &psS))) {
+				for (size_t j = 0; j < Count; ++j) if (psS[j].XYZ.X != 1000 * i + 1) ++Foreign[i];
+				Samples[i] += Count;
+				lis2hh12RingRelease(&psDev[i]->Ring, Count);
+			}
+		}
+	}
+	for (int i = 0; i < lis2hh12MAX_DEV; ++i) {
+		lis2hh12_inst_t * psI = &psDev[i]->Inst;
+		u32_t Expect = 2 * odr_scale[ODR[i]];
+		hostCheck(Samples[i] + lis2hh12FIFO_DEPTH >= Expect && Samples[i] <= Expect && Foreign[i] == 0,
+			"device %d %luHz delivered %lu/%lu own samples, %lu foreign", i, odr_scale[ODR[i]], Samples[i], Expect, Foreign[i]);
+		hostCheck(psI->IRQok == Sim[i].IRQs && psI->IRQlost == 0 && psI->Overrun == 0,
+			"device %d IRQok=%lu model IRQs=%lu", i, psI->IRQok, Sim[i].IRQs);
+	}
+	return hostResult();
+}
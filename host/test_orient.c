@@ -0,0 +1,116 @@
+// test_orient.c - integer arc tangent & tilt against libm, IGx 6D/4D positions on the chip model
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+#define	CD(r)						((r) * 18000.0 / M_PI)	// radians to centidegrees
+
+static lis2hh12_sim_t Sim;
+static i2c_di_t I2C;
+static lis2hh12_orient_t O;
+static lis2hh12_xyz_t Gravity;							// mG, model output
+static u32_t Seed = 1;
+
+static lis2hh12_xyz_t SimGen(lis2hh12_sim_t * psSim, u64_t TS) { return Gravity; }
+
+static void SimIRQ(void * Arg) { hostGPIOraise(lis2hh12IRQ_PIN); }
+
+static i32_t Rand(void) {
+	Seed = Seed * 1664525 + 1013904223;
+	return (i32_t) Seed;
+}
+
+/**
+ * @brief		centidegree difference, wrapped at +-180 degrees
+ */
+static f64_t Diff(i32_t CD, f64_t Ref) {
+	f64_t D = fabs(CD - Ref);
+	return (D > 18000.0) ? 36000.0 - D : D;
+}
+
+/**
+ * @brief		hold a gravity direction for 100mS at 100Hz
+ */
+static u8_t Hold(i16_t X, i16_t Y, i16_t Z) {
+	Gravity = (lis2hh12_xyz_t) { .X = X, .Y = Y, .Z = Z };
+	for (int ms = 0; ms < 100; ++ms) {
+		hostTime += 1000;
+		lis2hh12SimTick(&Sim, hostTime);
+	}
+	return O.Pos;
+}
+
+int main(void) {
+	// arc tangent: every radius from 1 LSb to the i32 limits, all angles, plus random pairs
+	f64_t Err = 0.0;
+	static const f64_t Radius[] = { 1, 3, 10, 100, 1000, 16384, 65535, 65536 * 3.0, 1e6, 65536000.0, 2147483647.0 };
+	for (size_t r = 0; r < sizeof(Radius) / sizeof(Radius[0]); ++r) {
+		for (int cd = -18000; cd < 18000; cd += 7) {
+			i32_t Y = (i32_t) lround(Radius[r] * sin(cd * M_PI / 18000.0));
+			i32_t X = (i32_t) lround(Radius[r] * cos(cd * M_PI / 18000.0));
+			if (X || Y) Err = fmax(Err, Diff(lis2hh12Atan2CD(Y, X), CD(atan2(Y, X))));
+		}
+	}
+	for (int i = 0; i < 1000000; ++i) {
+		i32_t Y = Rand() >> (Rand() & 31), X = Rand() >> (Rand() & 31);
+		if (X || Y) Err = fmax(Err, Diff(lis2hh12Atan2CD(Y, X), CD(atan2(Y, X))));
+	}
+	static const i32_t Edge[][2] = { { INT32_MIN, INT32_MIN }, { INT32_MIN, INT32_MAX }, { INT32_MAX, INT32_MIN }, { 0, INT32_MIN }, { INT32_MIN, 0 }, { -1, INT32_MIN } };
+	for (size_t i = 0; i < sizeof(Edge) / sizeof(Edge[0]); ++i) Err = fmax(Err, Diff(lis2hh12Atan2CD(Edge[i][0], Edge[i][1]), CD(atan2(Edge[i][0], Edge[i][1]))));
+	hostCheck(Err <= 10.0, "Atan2CD within %.2f centidegrees of atan2 over the i32 range", Err);
+	hostCheck(lis2hh12Atan2CD(0, 0) == 0, "Atan2CD(0,0) = 0");
+
+	// tilt: directions over the sphere at LSb, mG & Q16 mG scales
+	f64_t ErrP = 0.0, ErrR = 0.0;
+	static const f64_t Scale[] = { 1000.0, 16384.0, 65536000.0, 1.0e9 };
+	for (size_t s = 0; s < sizeof(Scale) / sizeof(Scale[0]); ++s) {
+		for (int k = 0; k < 20000; ++k) {
+			f64_t Z = 1.0 - (2.0 * k + 1.0) / 20000.0, R = sqrt(1.0 - Z * Z), Az = 2.39996 * k;
+			i32_t V[3] = { (i32_t) lround(Scale[s] * R * cos(Az)), (i32_t) lround(Scale[s] * R * sin(Az)), (i32_t) lround(Scale[s] * Z) };
+			i16_t Pitch, Roll;
+			lis2hh12Tilt(V[0], V[1], V[2], &Pitch, &Roll);
+			ErrP = fmax(ErrP, Diff(Pitch, CD(atan2(-(f64_t) V[0], sqrt((f64_t) V[1] * V[1] + (f64_t) V[2] * V[2])))));
+			if (V[1] || V[2]) ErrR = fmax(ErrR, Diff(Roll, CD(atan2(V[1], V[2]))));
+		}
+	}
+	hostCheck(ErrP <= 10.0 && ErrR <= 10.0, "Tilt pitch within %.2f, roll within %.2f centidegrees of atan2", ErrP, ErrR);
+
+	// IG1 6D movement, 700mG threshold: rotate through all 6 faces, between zones keeps the last
+	hostTime = 0;
+	lis2hh12SimInit(&Sim, &I2C);
+	Sim.Gen = SimGen;
+	Sim.cbIRQ = SimIRQ;
+	Gravity = (lis2hh12_xyz_t) { .Z = 1000 };
+	hostI2Cattach(&I2C, &Sim);
+	lis2hh12Identify(&I2C);
+	lis2hh12_t * psDev = lis2hh12GetDev(&I2C);
+	hostCheck(lis2hh12Config(&I2C) == erSUCCESS && lis2hh12SetODR(psDev, lis2hh12_odr100) == erSUCCESS, "Config 100Hz");
+	Hold(0, 0, 1000);
+	hostCheck(lis2hh12OrientInit(psDev, &O, 1, 0, 700, 0, NULL) == erSUCCESS && O.Pos == lis2hh12_posZH, "IG1 6D, initial position %hhu Z+", O.Pos);
+	static const struct { i16_t X, Y, Z; u8_t Pos; const char * pcName; } Face[] = {
+		{ 1000, 0, 0, lis2hh12_posXH, "X+" }, { 600, 0, 600, lis2hh12_posXH, "X+ (between)" }, { 0, 0, -1000, lis2hh12_posZL, "Z-" },
+		{ -1000, 0, 0, lis2hh12_posXL, "X-" }, { 0, 1000, 0, lis2hh12_posYH, "Y+" }, { 0, -1000, 0, lis2hh12_posYL, "Y-" },
+		{ 0, 0, 1000, lis2hh12_posZH, "Z+" },
+	};
+	u32_t Events = O.Events;
+	for (size_t f = 0; f < sizeof(Face) / sizeof(Face[0]); ++f) {
+		u8_t Pos = Hold(Face[f].X, Face[f].Y, Face[f].Z);
+		hostCheck(Pos == Face[f].Pos, "gravity %d/%d/%dmG: position %hhu %s", Face[f].X, Face[f].Y, Face[f].Z, Pos, Face[f].pcName);
+	}
+	hostCheck(O.Changes == 6 && O.Events - Events >= 6, "%lu changes from %lu IG1 events", O.Changes, O.Events - Events);
+
+	// IG2 4D: Z faces ignored, X/Y still tracked
+	hostCheck(lis2hh12OrientInit(psDev, &O, 2, 1, 700, 0, NULL) == erSUCCESS, "IG2 4D");
+	hostCheck(Hold(0, 1000, 0) == lis2hh12_posYH, "4D Y+");
+	hostCheck(Hold(0, 0, -1000) == lis2hh12_posYH, "4D Z- keeps Y+");
+	hostCheck(Hold(-1000, 0, 0) == lis2hh12_posXL, "4D X-");
+	// computed mode: block mean of raw 2G samples, empty block ignored
+	hostCheck(lis2hh12OrientInit(psDev, &O, 0, 0, 0, 0, NULL) == erSUCCESS, "computed 6D");
+	lis2hh12_xyz_t Blk[4] = { { .X = 16384 }, { .X = 16380 }, { .X = 16388 }, { .X = 16384 } };
+	lis2hh12OrientFeed(psDev, Blk, 0);
+	hostCheck(O.Blocks == 0 && O.Pos == lis2hh12_posNONE, "empty block ignored");
+	lis2hh12OrientFeed(psDev, Blk, 4);
+	hostCheck(O.Blocks == 1 && O.Pos == lis2hh12_posXH && O.Pitch == -9000, "X+ block: position %hhu pitch %d", O.Pos, O.Pitch);
+	lis2hh12ReportOrient(NULL, &O);
+	return hostResult();
+}
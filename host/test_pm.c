@@ -0,0 +1,44 @@
+// test_pm.c - power manager profile switches reach the chip with the shadow cache on, FIFO mode kept
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+static lis2hh12_sim_t Sim;
+static i2c_di_t I2C;
+static lis2hh12_pm_t Pm;
+
+static void Check(lis2hh12_t * psDev, lis2hh12_pm_state_t State, e_fm_t Mode) {
+	lis2hh12_pm_prof_t * psProf = &Pm.Prof[State];
+	u8_t ODR = (Sim.Reg[lis2hh12CTRL1] >> 4) & 0x07, FIFO = Sim.Reg[lis2hh12FIFO_CTRL];
+	hostCheck(Pm.State == State && ODR == psProf->ODR && (FIFO & 0x1F) == psProf->FTH && (FIFO >> 5) == Mode && psDev->Dirty == 0,
+		"state %d: chip ODR=%d FTH=%d mode=%d, dirty %llx", Pm.State, ODR, FIFO & 0x1F, FIFO >> 5, psDev->Dirty);
+}
+
+int main(void) {
+	hostTime = 0;
+	lis2hh12SimInit(&Sim, &I2C);
+	lis2hh12Identify(&I2C);
+	lis2hh12_t * psDev = lis2hh12GetDev(&I2C);
+	lis2hh12Config(&I2C);
+	lis2hh12_cfg_t Cfg = lis2hh12CfgDefault;
+	Cfg.CTRL[0] = makeCTRL1(1,lis2hh12_odr100,1,1,1,1);
+	Cfg.CTRL[2] = makeCTRL3(1,0,0,0,0,0,1,0);
+	Cfg.FIFO_CTRL = makeFIFOC(fmFIFO, 8);					// not the stream mode the manager used to force
+	hostCheck(lis2hh12ApplyCfg(psDev, &Cfg) == erSUCCESS, "FIFO mode FTH 8 at 100Hz");
+	hostCheck(lis2hh12PmInit(&Pm, lis2hh12_odr10, 24, lis2hh12_odr400, 12, 500) == erSUCCESS, "idle 10Hz/24, active 400Hz/12");
+	psDev->psPm = &Pm;
+	hostCheck(lis2hh12CacheEnable(psDev, 1) == erSUCCESS, "shadow cache on");
+
+	hostTime += 100000;
+	hostCheck(lis2hh12Service(psDev) == lis2hh12_pmIDLE, "idle requested");
+	Check(psDev, lis2hh12_pmIDLE, fmFIFO);
+	++psDev->Inst.IRQig1;									// motion
+	hostTime += 100000;
+	hostCheck(lis2hh12Service(psDev) == lis2hh12_pmACTIVE, "active requested");
+	Check(psDev, lis2hh12_pmACTIVE, fmFIFO);
+	hostTime += 600000;
+	lis2hh12Service(psDev);
+	Check(psDev, lis2hh12_pmIDLE, fmFIFO);
+	hostCheck(Pm.Switches == 3, "%lu switches", Pm.Switches);
+	return hostResult();
+}
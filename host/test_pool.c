@@ -0,0 +1,101 @@
+// test_pool.c - block pool fan out: subBLOCK backpressure held in the sensor FIFO, unsubscribe against a publisher
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+static lis2hh12_sim_t Sim;
+static i2c_di_t I2C;
+static lis2hh12_xyz_t Blk[lis2hh12FIFO_DEPTH];
+static lis2hh12_pool_t Pool;
+static u32_t Delays;
+static volatile int Run, Done;
+
+static void SimIRQ(void * Arg) { hostGPIOraise(lis2hh12IRQ_PIN); }
+
+static void DelayCount(void) { ++Delays; }
+
+static u32_t PoolFree(void) {
+	u32_t Free = 0;
+	for (int i = 0; i < lis2hh12POOL_BLOCKS; ++i) Free += (__atomic_load_n(&Pool.Blk[i].Ref, __ATOMIC_ACQUIRE) == 0);
+	return Free;
+}
+
+/**
+ * @brief		I2C task stand in, publishes copied blocks as fast as the pool allows
+ */
+static void Publisher(void * pv) {
+	lis2hh12_xyz_t XYZ[lis2hh12FIFO_DEPTH] = { 0 };
+	while (__atomic_load_n(&Run, __ATOMIC_ACQUIRE)) lis2hh12PoolPublish(&Pool, XYZ, lis2hh12FIFO_DEPTH, 0, 1250, 0);
+	__atomic_store_n(&Done, 1, __ATOMIC_RELEASE);
+	vTaskDelete(NULL);
+}
+
+int main(void) {
+	hostTime = 0;
+	lis2hh12SimInit(&Sim, &I2C);
+	Sim.cbIRQ = SimIRQ;
+	lis2hh12Identify(&I2C);
+	lis2hh12_t * psDev = lis2hh12GetDev(&I2C);
+	lis2hh12Config(&I2C);
+	lis2hh12_cfg_t Cfg = lis2hh12CfgDefault;
+	Cfg.CTRL[0] = makeCTRL1(1,lis2hh12_odr800,1,1,1,1);
+	Cfg.CTRL[2] = makeCTRL3(1,0,0,0,0,0,1,0);
+	Cfg.FIFO_CTRL = makeFIFOC(fmSTREAM, 16);
+	hostCheck(lis2hh12ApplyCfg(psDev, &Cfg) == erSUCCESS, "FIFO stream FTH 16 at 800Hz");
+	lis2hh12PoolInit(&Pool);
+	psDev->psPool = &Pool;
+	lis2hh12SetFIFOBlock(psDev, Blk, lis2hh12FIFO_DEPTH, NULL);
+	int Slow = lis2hh12Subscribe(&Pool, lis2hh12_subBLOCK, NULL);
+	int Fast = lis2hh12Subscribe(&Pool, lis2hh12_subDROP_NEWEST, NULL);
+	hostCheck(Slow >= 0 && Fast >= 0, "subscribed %d & %d", Slow, Fast);
+
+	// slow consumer takes a block every 25mS, the 20mS FIFO bursts wait in the sensor for it
+	hostDelayHook = DelayCount;
+	u32_t Got[2] = { 0 };
+	lis2hh12_blk_t * psB;
+	for (int ms = 1; ms <= 1000; ++ms) {
+		hostTime += 1000;
+		lis2hh12SimTick(&Sim, hostTime);
+		if ((ms % 25) == 0 && (psB = lis2hh12SubGet(&Pool, Slow))) { Got[0] += psB->Count; lis2hh12BlkRelease(psB); }
+		while ((psB = lis2hh12SubGet(&Pool, Fast))) { Got[1] += psB->Count; lis2hh12BlkRelease(psB); }
+		lis2hh12RingRelease(&psDev->Ring, lis2hh12RingPeek(&psDev->Ring, &(lis2hh12_sample_t *) { NULL }));
+	}
+	hostDelayHook = NULL;
+	while ((psB = lis2hh12SubGet(&Pool, Slow))) { Got[0] += psB->Count; lis2hh12BlkRelease(psB); }
+	lis2hh12_sub_t * psS = &Pool.Sub[Slow];
+	hostCheck(Delays == 0, "I2C task never delayed, %lu", Delays);
+	hostCheck(psS->Stalls > 0 && psS->DropNew == 0 && psDev->Inst.Overrun == 0,
+		"held %lu interrupts, dropped %lu, overruns %lu", psS->Stalls, psS->DropNew, psDev->Inst.Overrun);
+	hostCheck(Got[0] == Got[1] && Got[0] > 0 && Pool.Sub[Fast].DropNew == 0, "BLOCK %lu & NEWEST %lu samples, held for both", Got[0], Got[1]);
+
+	// stalled consumer, the sensor FIFO fills and the burst is dropped for it only
+	u32_t Fast0 = Got[1], Drop0 = psS->DropNew;
+	for (int ms = 1; ms <= 200; ++ms) {
+		hostTime += 1000;
+		lis2hh12SimTick(&Sim, hostTime);
+		while ((psB = lis2hh12SubGet(&Pool, Fast))) { Got[1] += psB->Count; lis2hh12BlkRelease(psB); }
+		lis2hh12RingRelease(&psDev->Ring, lis2hh12RingPeek(&psDev->Ring, &(lis2hh12_sample_t *) { NULL }));
+	}
+	hostCheck(psS->DropNew > Drop0 && Got[1] - Fast0 >= 100, "stalled BLOCK dropped %lu, NEWEST still got %lu samples",
+		psS->DropNew - Drop0, Got[1] - Fast0);
+	lis2hh12Unsubscribe(&Pool, Slow);
+	lis2hh12Unsubscribe(&Pool, Fast);
+	hostCheck(PoolFree() == lis2hh12POOL_BLOCKS, "all blocks free after unsubscribe");
+
+	// subscribe / unsubscribe churn against a free running publisher, no block may leak
+	psDev->psPool = NULL;
+	hostTime = -1;
+	__atomic_store_n(&Run, 1, __ATOMIC_RELEASE);
+	xTaskCreate(Publisher, "pub", 4096, NULL, 5, NULL);
+	u32_t Cycles = 0;
+	for (i64_t Tend = esp_timer_get_time() + 500000; esp_timer_get_time() < Tend; ++Cycles) {
+		int Sub = lis2hh12Subscribe(&Pool, (lis2hh12_sub_policy_t) (Cycles % 3), NULL);
+		for (int i = 0; i < (Cycles % 8); ++i) if ((psB = lis2hh12SubGet(&Pool, Sub))) lis2hh12BlkRelease(psB);
+		lis2hh12Unsubscribe(&Pool, Sub);
+	}
+	__atomic_store_n(&Run, 0, __ATOMIC_RELEASE);
+	while (__atomic_load_n(&Done, __ATOMIC_ACQUIRE) == 0) vTaskDelay(1);
+	hostCheck(Pool.Published > 0 && PoolFree() == lis2hh12POOL_BLOCKS, "%lu cycles, %lu published, %lu/%d blocks free",
+		Cycles, Pool.Published, PoolFree(), lis2hh12POOL_BLOCKS);
+	return hostResult();
+}
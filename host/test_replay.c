@@ -0,0 +1,75 @@
+// test_replay.c - recording replayed through the chip model and the complete driver at 100x real time
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+#define RECORD						8000				// 10s at 800Hz
+
+static lis2hh12_sim_t Sim;
+static i2c_di_t I2C;
+static lis2hh12_xyz_t Blk[lis2hh12FIFO_DEPTH];
+static lis2hh12_sample_t Rec[RECORD], Out[RECORD + 64];
+static lis2hh12_replay_t Rep;
+static lis2hh12_t * psDev;
+static size_t Count, Gaps;
+
+static void Drain(lis2hh12_replay_t * psRep) {
+	lis2hh12_sample_t * psS;
+	size_t N;
+	while ((N = lis2hh12RingPeek(&psDev->Ring, &psS))) {
+		for (size_t i = 0; i < N; ++i) {
+			if (psS[i].Gap) ++Gaps;
+			if (Count < RECORD + 64) Out[Count++] = psS[i];
+		}
+		lis2hh12RingRelease(&psDev->Ring, N);
+	}
+}
+
+int main(void) {
+	for (int i = 0; i < RECORD; ++i) {					// raw LSb, distinct in every sample
+		Rec[i].TS = 1000000ULL + i * 1250ULL;
+		Rec[i].XYZ.X = (i16_t) (i * 7);
+		Rec[i].XYZ.Y = (i16_t) (1000 - i);
+		Rec[i].XYZ.Z = (i16_t) (16384 + (i & 0xFF));
+	}
+	lis2hh12SimInit(&Sim, &I2C);
+	lis2hh12Identify(&I2C);
+	lis2hh12Config(&I2C);
+	psDev = lis2hh12GetDev(&I2C);
+	lis2hh12_cfg_t Cfg = lis2hh12CfgDefault;
+	Cfg.CTRL[0] = makeCTRL1(1,lis2hh12_odr800,1,1,1,1);
+	Cfg.CTRL[2] = makeCTRL3(1,0,0,0,0,0,1,0);
+	Cfg.FIFO_CTRL = makeFIFOC(fmSTREAM, 16);
+	hostCheck(lis2hh12ApplyCfg(psDev, &Cfg) == erSUCCESS, "FIFO profile applied");
+	lis2hh12SetFIFOBlock(psDev, Blk, lis2hh12FIFO_DEPTH, NULL);
+	hostCheck(lis2hh12ReplayInit(&Rep, &Sim, Rec, RECORD, false) == erSUCCESS, "ReplayInit");
+	Rep.cbStep = Drain;
+
+	// 10s of recording at 100x real time, 1mS model steps
+	lis2hh12ReplayRun(&Rep, 10000000ULL, 100, 1000);
+	lis2hh12ReportReplay(NULL, &Rep);
+	printf("\t100x paced, %lumS wall\n", (u32_t) (Rep.Twall / 1000ULL));	// host load dependent, not checked
+	hostCheck(Rep.Trun == 10000000ULL && Rep.Tsim - Rep.T0sim >= 9990000ULL, "10s model time run, %llumS replayed", (Rep.Tsim - Rep.T0sim) / 1000ULL);
+	size_t Off = 0;
+	while (Off < 8 && memcmp(&Out[Off].XYZ, &Rec[0].XYZ, sizeof(lis2hh12_xyz_t))) ++Off;
+	size_t Bad = 0, N = Count - Off;
+	for (size_t i = 0; i < N && i < RECORD; ++i) {
+		if (memcmp(&Out[Off + i].XYZ, &Rec[i].XYZ, sizeof(lis2hh12_xyz_t))) ++Bad;
+	}
+	hostCheck(Off < 8 && N >= RECORD - 32 && Bad == 0, "bit exact replay, %lu of %d samples, %lu mismatched",
+		(u32_t) N, RECORD, (u32_t) Bad);
+	hostCheck(Gaps == 0 && psDev->Inst.Overrun == 0, "no gaps or overruns when serviced every 1mS");
+
+	// same recording looped, serviced every 100mS (> 32 samples), unpaced: FIFO_SRC ovr and gaps
+	lis2hh12ReplayInit(&Rep, &Sim, Rec, RECORD, true);
+	Rep.cbStep = Drain;
+	Rep.Tsim = lis2hh12SimNow;
+	Count = Gaps = 0;
+	lis2hh12InstSnapshot(psDev, NULL, true);
+	lis2hh12ReplayRun(&Rep, 20000000ULL, 0, 100000);
+	lis2hh12ReportReplay(NULL, &Rep);
+	hostCheck(psDev->Inst.Overrun > 0 && Gaps > 0 && Rep.Loops == 1, "overruns=%lu gaps=%lu loops=%lu",
+		psDev->Inst.Overrun, (u32_t) Gaps, Rep.Loops);
+	lis2hh12ReportSim(NULL, &Sim);
+	return hostResult();
+}
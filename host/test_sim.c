@@ -0,0 +1,76 @@
+// test_sim.c - lis2hh12Identify/Config and the INTx chain run unmodified against the chip model
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+static lis2hh12_sim_t Sim;
+static i2c_di_t I2C;
+static lis2hh12_xyz_t Blk[lis2hh12FIFO_DEPTH];
+
+static void SimIRQ(void * Arg) { hostGPIOraise(lis2hh12IRQ_PIN); }	// INTx via the pin Config() set up
+
+static u32_t Run(lis2hh12_t * psDev, u32_t MS) {
+	u32_t Samples = 0;
+	for (u32_t i = 0; i < MS; ++i) {
+		hostTime += 1000;
+		lis2hh12SimTick(&Sim, hostTime);
+		lis2hh12_sample_t * psS;
+		size_t Count;
+		while ((Count = lis2hh12RingPeek(&psDev->Ring, &psS))) {
+			Samples += Count;
+			lis2hh12RingRelease(&psDev->Ring, Count);
+		}
+	}
+	return Samples;
+}
+
+int main(void) {
+	hostTime = 0;
+	lis2hh12SimInit(&Sim, &I2C);
+	Sim.cbIRQ = SimIRQ;
+	Sim.AmpX = 500;
+	Sim.FreqX = 50;
+	hostCheck(lis2hh12Identify(&I2C) == erSUCCESS && I2C.IDok, "Identify");
+	hostCheck(lis2hh12Config(&I2C) == erSUCCESS && I2C.CFGok, "Config");
+	lis2hh12_t * psDev = lis2hh12GetDev(&I2C);
+	hostCheck(psDev && psDev->psSim == &Sim && psDev->IRQpin == lis2hh12IRQ_PIN, "device bound to model, INTx pin %d", lis2hh12IRQ_PIN);
+
+	// DRDY at 100Hz, one status burst per sample
+	lis2hh12_cfg_t Cfg = lis2hh12CfgDefault;
+	Cfg.CTRL[0] = makeCTRL1(1,lis2hh12_odr100,1,1,1,1);
+	Cfg.CTRL[2] = makeCTRL3(0,0,0,0,0,0,0,1);
+	hostCheck(lis2hh12ApplyCfg(psDev, &Cfg) == erSUCCESS && lis2hh12VerifyCfg(psDev, &Cfg) == erSUCCESS, "DRDY profile applied");
+	lis2hh12InstSnapshot(psDev, NULL, true);
+	u32_t Samples = Run(psDev, 1000);
+	hostCheck(INRANGE(99, Samples, 100), "DRDY 100Hz delivered %lu/s", Samples);
+	hostCheck(psDev->Inst.IRQlost == 0 && psDev->Inst.IRQok == Sim.IRQs, "DRDY IRQok=%lu model IRQs=%lu lost=%lu",
+		psDev->Inst.IRQok, Sim.IRQs, psDev->Inst.IRQlost);
+	hostCheck(psDev->Inst.BusTrans == Samples, "DRDY bus transactions %lu", psDev->Inst.BusTrans);
+
+	// FIFO stream at 800Hz, FTH 16, status burst + sample burst per threshold
+	Cfg.CTRL[0] = makeCTRL1(1,lis2hh12_odr800,1,1,1,1);
+	Cfg.CTRL[2] = makeCTRL3(1,0,0,0,0,0,1,0);
+	Cfg.FIFO_CTRL = makeFIFOC(fmSTREAM, 16);
+	hostCheck(lis2hh12ApplyCfg(psDev, &Cfg) == erSUCCESS && lis2hh12VerifyCfg(psDev, &Cfg) == erSUCCESS, "FIFO profile applied");
+	lis2hh12SetFIFOBlock(psDev, Blk, lis2hh12FIFO_DEPTH, NULL);
+	Run(psDev, 100);									// settle
+	lis2hh12InstSnapshot(psDev, NULL, true);
+	Samples = Run(psDev, 1000);
+	lis2hh12_inst_t * psI = &psDev->Inst;
+	hostCheck(INRANGE(784, Samples, 816), "FIFO 800Hz delivered %lu/s", Samples);
+	hostCheck(psI->Overrun == 0 && psI->IRQlost == 0, "FIFO no overrun or lost IRQ");
+	hostCheck(psI->BusTrans * 1000 <= Samples * 130, "FIFO %lu transactions, %lu bytes for %lu samples",
+		psI->BusTrans, psI->BusBytes, Samples);
+
+	// model bus time advances virtual time rather than waiting on it
+	Sim.LatencyUS = 250;
+	i64_t T0 = hostTime;
+	u8_t WhoAmI = 0;
+	int iRV = lis2hh12ReadRegs(psDev, lis2hh12WHO_AM_I, &WhoAmI, 1);
+	u32_t dT = (u32_t) (hostTime - T0);
+	hostCheck(iRV == erSUCCESS && WhoAmI == lis2hh12WHOAMI_NUM && dT == 250, "bus latency %luuS of virtual time", dT);
+	Sim.LatencyUS = 0;
+	lis2hh12ReportDev(NULL, psDev);
+	lis2hh12ReportSim(NULL, &Sim);
+	return hostResult();
+}
@@ -0,0 +1,67 @@
+// test_spec.c - FFT & Goertzel amplitude accuracy on known tones, Hann window normalisation
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+static lis2hh12_spec_t Spec;
+static lis2hh12_t Dev = { .psSpec = &Spec };
+static f32_t Mag[lis2hh12SPEC_NMAX / 2 + 1];
+static u16_t Count;
+static f32_t BinHz;
+
+static void SpecCB(lis2hh12_t * psDev, f32_t * pMag, u16_t Num, f32_t Hz) {
+	memcpy(Mag, pMag, Num * sizeof(f32_t));
+	Count = Num;
+	BinHz = Hz;
+}
+
+/**
+ * @brief		feed one block of A LSb peak at Freq Hz on X, plus DC LSb
+ */
+static void Tone(f32_t A, f32_t Freq, i16_t DC) {
+	for (u16_t n = 0; n < Spec.N; ++n) {
+		lis2hh12_xyz_t XYZ = { .X = DC + (i16_t) lroundf(A * sinf(2.0f * (f32_t) M_PI * Freq * n / Spec.Fs)) };
+		lis2hh12SpecFeed(&Dev, &XYZ, 1);
+	}
+}
+
+static bool Near(f32_t Val, f32_t Ref, f32_t Tol) { return fabsf(Val - Ref) <= Tol; }
+
+int main(void) {
+	// FFT, 400Hz N=128 3.125Hz bins, 1000 LSb at 50Hz = bin 16 plus 200 LSb DC
+	int iRV = lis2hh12SpecInit(&Spec, lis2hh12_odr400, lis2hh12_specFFT, 0, 0, SpecCB);
+	hostCheck(iRV == erSUCCESS && Spec.N == 128, "FFT N=%hu", Spec.N);
+	Tone(1000.0f, 50.0f, 200);
+	hostCheck(Spec.Blocks == 1 && Count == 65 && BinHz == 3.125f, "1 block, %hu bins of %.3fHz", Count, BinHz);
+	hostCheck(Near(Mag[16], 1000.0f, 5.0f), "bin 16 (50Hz) %.2f LSb, 1000 fed", Mag[16]);
+	hostCheck(Near(Mag[15], 500.0f, 5.0f) && Near(Mag[17], 500.0f, 5.0f), "Hann leakage bins 15/17 %.2f/%.2f LSb", Mag[15], Mag[17]);
+	hostCheck(Near(Mag[0], 200.0f, 2.0f), "DC %.2f LSb, 200 fed", Mag[0]);
+	f32_t Far = 0.0f;
+	for (u16_t k = 2; k < Count; ++k) {
+		if (k < 14 || k > 18) Far = fmaxf(Far, Mag[k]);
+	}
+	hostCheck(Far < 2.0f, "other bins below %.2f LSb", Far);
+	f32_t Band = lis2hh12SpecBand(&Spec, 45.0f, 55.0f);
+	hostCheck(Near(Band, 1000.0f * 1000.0f * 1.5f, 15000.0f), "band 45..55Hz %.0f LSb^2, 1.5 A^2 with Hann", Band);
+	f32_t FFT16 = Mag[16];
+
+	// Goertzel on the same tone, bin centred, half a bin off and at an empty frequency
+	iRV = lis2hh12SpecInit(&Spec, lis2hh12_odr400, lis2hh12_specGOERTZEL, 0, 0, SpecCB);
+	hostCheck(iRV == erSUCCESS, "Goertzel N=%hu", Spec.N);
+	lis2hh12SpecAddBin(&Spec, 50.0f);
+	lis2hh12SpecAddBin(&Spec, 50.0f + 3.125f / 2.0f);
+	lis2hh12SpecAddBin(&Spec, 100.0f);
+	Tone(1000.0f, 50.0f, 200);
+	hostCheck(Spec.Blocks == 1 && Count == 3 && BinHz == 0.0f, "1 block, %hu frequencies", Count);
+	hostCheck(Near(Mag[0], 1000.0f, 5.0f) && Near(Mag[0], FFT16, 0.5f), "50Hz %.2f LSb, FFT bin %.2f LSb", Mag[0], FFT16);
+	hostCheck(Near(Mag[1], 1000.0f * 0.849f, 10.0f), "half bin off %.2f LSb, Hann scalloping -1.42dB", Mag[1]);
+	hostCheck(Mag[2] < 2.0f, "100Hz %.2f LSb, no tone", Mag[2]);
+
+	// overlapped blocks, hop of N/2 gives a block per 64 samples after the first
+	iRV = lis2hh12SpecInit(&Spec, lis2hh12_odr400, lis2hh12_specFFT, 0, 50, SpecCB);
+	hostCheck(iRV == erSUCCESS && Spec.Hop == 64, "50%% overlap, hop %hu", Spec.Hop);
+	for (int b = 0; b < 4; ++b) Tone(1000.0f, 50.0f, 0);
+	hostCheck(Spec.Blocks == 7 && Near(Mag[16], 1000.0f, 5.0f), "%lu blocks, bin 16 %.2f LSb", Spec.Blocks, Mag[16]);
+	lis2hh12ReportSpec(NULL, &Spec);
+	return hostResult();
+}
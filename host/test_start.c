@@ -0,0 +1,55 @@
+// test_start.c - cold & warm start against the chip model, CTRL6 boot polling in virtual time
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+static lis2hh12_sim_t Sim;
+static i2c_di_t I2C;
+
+int main(void) {
+	hostTime = 0;
+	lis2hh12SimInit(&Sim, &I2C);
+
+	// cold: boot takes 5mS, polled once per tick until CTRL6 boot clears
+	Sim.BootUS = 5000;
+	Sim.Reg[lis2hh12CTRL1] ^= 0x10;						// default profile is the power on state, differ from it
+	hostCheck(lis2hh12Identify(&I2C) == erSUCCESS, "cold Identify");
+	lis2hh12_t * psDev = lis2hh12GetDev(&I2C);
+	lis2hh12_start_t * psS = &psDev->Start;
+	hostCheck(psS->Warm == 0 && psS->BootUS == 5000 && psS->Polls == 6, "boot %luuS in %hhu polls", psS->BootUS, psS->Polls);
+	u32_t Trans = psDev->Inst.BusTrans;
+	hostCheck(lis2hh12Config(&I2C) == erSUCCESS && psDev->Inst.BusTrans - Trans == 5, "cold Config, 3 bursts written & 2 verified");
+
+	// warm: profile in place, neither rebooted nor rewritten
+	Trans = psDev->Inst.BusTrans;
+	hostCheck(lis2hh12Identify(&I2C) == erSUCCESS && psS->Warm && psS->BootUS == 0 && psS->Polls == 0, "warm Identify, no reboot");
+	hostCheck(psDev->Inst.BusTrans - Trans == 3, "warm Identify, WHO_AM_I & 2 verify bursts");
+	Trans = psDev->Inst.BusTrans;
+	hostCheck(lis2hh12Config(&I2C) == erSUCCESS && psDev->Inst.BusTrans == Trans, "warm Config, no bus traffic");
+	hostCheck(psS->Warm == 0, "warm start consumed by Config");
+	Trans = psDev->Inst.BusTrans;
+	hostCheck(lis2hh12Config(&I2C) == erSUCCESS && psDev->Inst.BusTrans - Trans == 5, "second Config reapplies the profile");
+
+	// bus error between Identify & Config, profile rewritten
+	hostCheck(lis2hh12Identify(&I2C) == erSUCCESS && psS->Warm, "warm Identify");
+	psDev->psBus = &lis2hh12BusI2C;						// no halI2C_Queue() model attached, transaction fails
+	u8_t U8;
+	hostCheck(lis2hh12ReadRegs(psDev, lis2hh12STATUS, &U8, sizeof(U8)) < erSUCCESS && psS->Warm == 0, "bus error clears warm");
+	psDev->psBus = &lis2hh12BusSim;
+	Trans = psDev->Inst.BusTrans;
+	hostCheck(lis2hh12Config(&I2C) == erSUCCESS && psDev->Inst.BusTrans - Trans == 5, "Config after bus error reapplies the profile");
+
+	// profile changed behind the driver's back, cold again
+	Sim.Reg[lis2hh12CTRL1] ^= 0x10;
+	hostCheck(lis2hh12Identify(&I2C) == erSUCCESS && psS->Warm == 0 && psS->BootUS == 5000, "profile mismatch reboots");
+	hostCheck(lis2hh12Config(&I2C) == erSUCCESS, "cold Config");
+
+	// boot never completes within lis2hh12BOOT_MS
+	Sim.BootUS = (lis2hh12BOOT_MS + 10) * 1000;
+	Sim.Reg[lis2hh12CTRL1] ^= 0x10;
+	i64_t T0 = hostTime;
+	int iRV = lis2hh12Identify(&I2C);
+	u32_t dT = (u32_t) (hostTime - T0);
+	hostCheck(iRV == erFAILURE && dT == lis2hh12BOOT_MS * 1000 && psS->Polls == lis2hh12BOOT_MS + 1, "boot timeout after %luuS, %hhu polls", dT, psS->Polls);
+	return hostResult();
+}
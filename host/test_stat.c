@@ -0,0 +1,73 @@
+// test_stat.c - window mean/RMS/min/max/crest/kurtosis against a double reference, windows across blocks & gaps
+
+#include "hal_platform.h"
+#include "lis2hh12.h"
+
+#define	WINDOW						8
+
+static lis2hh12_stat_t Stat;
+static lis2hh12_t sDev = { .psStat = &Stat };
+static lis2hh12_sum_t Sum[8];
+static int Sums;
+
+static void cbSum(lis2hh12_t * psDev, lis2hh12_sum_t * psSum) { if (Sums < 8) Sum[Sums++] = *psSum; }
+
+static lis2hh12_xyz_t Sample(int i) {	// ramp, +-1 about 1G, squares with a -1G offset
+	return (lis2hh12_xyz_t) { .X = (i16_t) (100 * (i % WINDOW + 1)), .Y = (i16_t) (16384 + ((i & 1) ? 1 : -1)), .Z = (i16_t) (-16000 + (i % WINDOW) * (i % WINDOW)) };
+}
+
+/**
+ * @brief		check one record against a two pass double reference of samples First..First+WINDOW-1
+ */
+static void Check(lis2hh12_sum_t * psSum, int First) {
+	for (int a = 0; a < 3; ++a) {
+		f64_t Mean = 0.0, M2 = 0.0, M4 = 0.0;
+		i16_t Min = INT16_MAX, Max = INT16_MIN;
+		for (int i = First; i < First + WINDOW; ++i) {
+			i16_t V = Sample(i).Axis[a];
+			Mean += V / (f64_t) WINDOW;
+			if (V < Min) Min = V;
+			if (V > Max) Max = V;
+		}
+		for (int i = First; i < First + WINDOW; ++i) {
+			f64_t D = Sample(i).Axis[a] - Mean;
+			M2 += D * D;
+			M4 += D * D * D * D;
+		}
+		f64_t RMS = sqrt(M2 / WINDOW), Peak = fmax(Max - Mean, Mean - Min);
+		i32_t Crest = lround(Peak / RMS * 256.0), Kurt = lround(WINDOW * M4 / (M2 * M2) * 256.0);
+		lis2hh12_axsum_t * psA = &psSum->Axis[a];
+		hostCheck(psA->Mean == lround(Mean) && psA->RMS == lround(RMS) && psA->Min == Min && psA->Max == Max &&
+			abs(psA->Crest - Crest) <= 1 && abs(psA->Kurt - Kurt) <= 1,
+			"%c Mean=%d/%.1f RMS=%u/%.2f Min=%d Max=%d Crest=%u/%d Kurt=%u/%d", 'X' + a, psA->Mean, Mean, psA->RMS, RMS,
+			psA->Min, psA->Max, psA->Crest, Crest, psA->Kurt, Kurt);
+	}
+}
+
+int main(void) {
+	lis2hh12_xyz_t Blk[24];
+	for (int i = 0; i < 24; ++i) Blk[i] = Sample(i);
+	hostCheck(lis2hh12StatInit(&Stat, 1, cbSum) == erINV_PARA, "window of 1 refused");
+	hostCheck(lis2hh12StatInit(&Stat, WINDOW, cbSum) == erSUCCESS, "window of %d", WINDOW);
+
+	// 2 windows from blocks of 5, 7 & 4: boundaries inside blocks, TS of each window's last sample
+	lis2hh12StatFeed(&sDev, &Blk[0], 5, 5000, 1000, 0);
+	lis2hh12StatFeed(&sDev, &Blk[5], 7, 12000, 1000, 0);
+	lis2hh12StatFeed(&sDev, &Blk[12], 4, 16000, 1000, 0);
+	hostCheck(Sums == 2 && Stat.Count == 0, "%d records, %u pending", Sums, Stat.Count);
+	hostCheck(Sum[0].Seq == 0 && Sum[0].Count == WINDOW && Sum[0].TS == 8000 && Sum[1].Seq == 1 && Sum[1].TS == 16000, "Seq & TS");
+	Check(&Sum[0], 0);
+	Check(&Sum[1], 8);
+
+	// gap 5 samples into a window: partial window discarded, Seq skipped, next window only after the gap
+	lis2hh12StatFeed(&sDev, &Blk[16], 5, 21000, 1000, 0);
+	lis2hh12StatFeed(&sDev, &Blk[0], 8, 40000, 1000, 11);
+	hostCheck(Sums == 3 && Sum[2].Seq == 3 && Sum[2].TS == 40000, "after gap record Seq %u, TS %llu", Sum[2].Seq, Sum[2].TS);
+	Check(&Sum[2], 0);
+
+	// gap on a window boundary loses nothing
+	lis2hh12StatFeed(&sDev, &Blk[8], 8, 60000, 1000, 3);
+	hostCheck(Sums == 4 && Sum[3].Seq == 4, "gap at window boundary, Seq %u", Sum[3].Seq);
+	lis2hh12ReportSum(NULL, &Sum[3]);
+	return hostResult();
+}
@@ -13,6 +13,9 @@
 #include "systiming.h"
 #include "errors_events.h"
 
+#include "esp_cpu.h"
+#include "esp_timer.h"
+
 // ############################################# Macros ############################################
 
 #define	debugFLAG					0xF000
@@ -25,19 +28,120 @@
 
 const u16_t fs_scale[4] = { 2000, -1, 4000, 8000 };
 const u16_t odr_scale[8] = { 0, 10, 50, 100, 200, 400, 800, -1 };
+// fs=1 is reserved, converted at 8G as lis2hh12ConvCoord() always has
+const i32_t fs_q16[4] = { 3998, 15991, 7995, 15991 };			// 0.061/0.122/0.244 mG/LSb * 65536
+static const f32_t fs_g[4] = { 0.000061, 0.000244, 0.000122, 0.000244 };
+
+#define lis2hh12REG_BIT(r)			(1ULL << lis2hh12REG_IDX(r))
+
+// Registers changed by the device, never cached
+#define lis2hh12VOLATILE			(lis2hh12REG_BIT(lis2hh12TEMP_L) | lis2hh12REG_BIT(lis2hh12TEMP_H) |		\
+	lis2hh12REG_BIT(lis2hh12STATUS) | lis2hh12REG_BIT(lis2hh12OUT_X_L) | lis2hh12REG_BIT(lis2hh12OUT_X_H) |		\
+	lis2hh12REG_BIT(lis2hh12OUT_Y_L) | lis2hh12REG_BIT(lis2hh12OUT_Y_H) | lis2hh12REG_BIT(lis2hh12OUT_Z_L) |	\
+	lis2hh12REG_BIT(lis2hh12OUT_Z_H) | lis2hh12REG_BIT(lis2hh12FIFO_SRC) | lis2hh12REG_BIT(lis2hh12IG_SRC1) |	\
+	lis2hh12REG_BIT(lis2hh12IG_SRC2))
+
+// Config register ranges read to synchronise the shadow, skipping OUT (FIFO pop) and IG_SRCx (latch clear)
+static const u8_t CacheRange[][2] = {
+	{ lis2hh12ACT_THS, lis2hh12CTRL7 }, { lis2hh12FIFO_CTRL, lis2hh12FIFO_CTRL }, { lis2hh12IG_CFG1, lis2hh12IG_CFG1 },
+	{ lis2hh12IG_THS_X1, lis2hh12IG_CFG2 }, { lis2hh12IG_THS2, lis2hh12ZH_REF },
+};
+
+const lis2hh12_cfg_t lis2hh12CfgDefault = {
+#if (0)
+	.CTRL = {
+		makeCTRL1(0,1,1,1,1,1),					// x80=HR	x70=ODR		x08=BDU		x04=Zen		x02=Yen		x01=Xen
+		makeCTRL2(0,0,0,0,0),					// x80=RSVD	x60=DFC		x18=HPM		x04=FDS		x02=HPIS1	x01=HPIS2
+		makeCTRL3(1,0,1,1,1,1,1,1),				// 0x80=Fen	x40=STOP	x20=INACT	x10=IG2		x08=IG1		x04=OVR		x02=FTH		x01=DRDY
+		makeCTRL4(0,0,0,1,0,0),					// xC0=BW	x30=FS		x08=BWman	x04=INCR	x02=I2Cdis	x01=SIM
+		makeCTRL5(0,0,0,0,1,1),					// x80=DGB	x40=RST		x30=DEC		x0C=TST		x02=HLact	x01=ODen
+		makeCTRL6(0,1,1,1,1,1,1),				// x80=BOOT	x40=RSVD	x20=I1Boot	x10=I2IG2	x08=I2IG1	x04=I2EMPTY	x02=I2FTH	x01=I2DRDY
+		makeCTRL7(0,0,0,0,0,0),					// xC0=RSVD	x20=I2DCRM	x10=I1DCRM	x08=I2LIR	x04=I1LIR	x02=I2_4D	x01=I1_4D
+	},
+	.FIFO_CTRL = makeFIFOC(fmSTREAM,8),			// xE0=FMode	x1F=FTH
+	.IG_CFG1 = makeIGxCFG(0,0,1,1,1,1,1,1),		// x80=AOI	x40=D6		x20=ZH		x10=ZL		x08=YH		x04=YL		x02=XH		x01=XL
+	.IG_CFG2 = makeIGxCFG(0,0,0,0,0,0,0,0),
+#else											// power on defaults with address auto increment
+	.CTRL = {
+		makeCTRL1(0,0,0,1,1,1), makeCTRL2(0,0,0,0,0), makeCTRL3(0,0,0,0,0,0,0,0), makeCTRL4(0,0,0,1,0,0),
+		makeCTRL5(0,0,0,0,0,0), makeCTRL6(0,0,0,0,0,0,0), makeCTRL7(0,0,0,0,0,0),
+	},
+	.FIFO_CTRL = makeFIFOC(fmBYPASS,0),
+	.IG_CFG1 = makeIGxCFG(0,0,0,0,0,0,0,0),
+	.IG_CFG2 = makeIGxCFG(0,0,0,0,0,0,0,0),
+#endif
+};
+
+const lis2hh12_cfg_t * lis2hh12Profile = &lis2hh12CfgDefault;	// applied by lis2hh12Config(), warm start reference
 
 // ###################################### Local variables ##########################################
 
-lis2hh12_t sLIS2HH12 = { 0 };
-u32_t lis2hh12IRQok, lis2hh12IRQlost, lis2hh12IRQfifo, lis2hh12IRQig1, lis2hh12IRQig2, lis2hh12IRQinact, lis2hh12IRQboot;
-u32_t lis2hh12IRQdrdy, lis2hh12IRQdrdyErr;
+lis2hh12_t sLIS2HH12[lis2hh12MAX_DEV] = { 0 };
+u8_t lis2hh12Num = 0;
+static const i8_t lis2hh12IRQpin[] = lis2hh12IRQ_PINS;
+DUMB_STATIC_ASSERT(sizeof(lis2hh12IRQpin) == lis2hh12MAX_DEV);	// else missing devices get GPIO0
 
 // #################################### Local ONLY functions #######################################
 
-int lis2hh12WriteReg(u8_t reg, u8_t * pU8, u8_t val) {
+/**
+ * @brief		lock free log2 histogram update, safe against concurrent snapshot/reset
+ */
+static inline void lis2hh12HistAdd(lis2hh12_hist_t * psH, u32_t Val) {
+	int Idx = Val ? 32 - __builtin_clz(Val) : 0;
+	if (Idx >= lis2hh12HIST_BINS) Idx = lis2hh12HIST_BINS - 1;
+	__atomic_fetch_add(&psH->Bin[Idx], 1, __ATOMIC_RELAXED);
+	u32_t Max = __atomic_load_n(&psH->Max, __ATOMIC_RELAXED);
+	while (Val > Max && !__atomic_compare_exchange_n(&psH->Max, &Max, Val, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static int lis2hh12QueueI2C(lis2hh12_t * psDev, int eCmd, u8_t * pTx, size_t TxSize, u8_t * pRx, size_t RxSize, i2cq_p1_t p1, i2cq_p2_t p2) {
+	return halI2C_Queue(psDev->psI2C, eCmd, pTx, TxSize, pRx, RxSize, p1, p2);
+}
+
+const lis2hh12_bus_t lis2hh12BusI2C = {
+	.pcName = "I2C", .Queue = lis2hh12QueueI2C, .Hz = 400000, .BitsPerByte = 9, .AddrBytes = 1, .FrameBits = 2,
+};
+
+/**
+ * @brief		single point of access to the bus, counts transactions and bytes (device address bytes included)
+ * @note		parameters as for halI2C_Queue(), routed to the transport selected at identification
+ */
+int lis2hh12Queue(lis2hh12_t * psDev, int eCmd, u8_t * pTx, size_t TxSize, u8_t * pRx, size_t RxSize, i2cq_p1_t p1, i2cq_p2_t p2) {
+	const lis2hh12_bus_t * psBus = psDev->psBus ? psDev->psBus : &lis2hh12BusI2C;
+	u32_t Trans = 1, Bytes = psBus->AddrBytes + TxSize + (RxSize ? psBus->AddrBytes + RxSize : 0);
+	if (eCmd == i2cWRMW) {								// read then write back
+		Trans = 2;
+		Bytes += psBus->AddrBytes + TxSize + RxSize;
+	}
+	lis2hh12INST_ADD(psDev->Inst.BusTrans, Trans);
+	lis2hh12INST_ADD(psDev->Inst.BusBytes, Bytes);
+	int iRV = psBus->Queue(psDev, eCmd, pTx, TxSize, pRx, RxSize, p1, p2);
+	if (iRV < erSUCCESS) {
+		lis2hh12INST_ADD(psDev->Inst.BusErr, 1);
+		psDev->Start.Warm = 0;							// device state unknown, next lis2hh12Config() rewrites it
+	}
+	return iRV;
+}
+
+/**
+ * @brief		bits on the wire for one register write/read transaction, framing included
+ * @note		I2C: START+addr, register, [RESTART+addr], data, STOP with ACK per byte
+ * 				SPI: CS framing, command byte with register address, data
+ */
+u32_t lis2hh12BusBits(const lis2hh12_bus_t * psBus, size_t TxSize, size_t RxSize) {
+	u32_t Bytes = psBus->AddrBytes + TxSize + (RxSize ? psBus->AddrBytes + RxSize : 0);
+	return Bytes * psBus->BitsPerByte + psBus->FrameBits * (RxSize && psBus->AddrBytes ? 2 : 1);
+}
+
+int lis2hh12WriteReg(lis2hh12_t * psDev, u8_t reg, u8_t * pU8, u8_t val) {
 	IF_myASSERT(debugPARAM, INRANGE(lis2hh12TEMP_L, reg, lis2hh12ZH_REF));
+	if (pU8 && psDev->Cached && (lis2hh12REG_BIT(reg) & lis2hh12VOLATILE) == 0) {
+		if (*pU8 != val) psDev->Dirty |= lis2hh12REG_BIT(reg);
+		*pU8 = val;										// shadow only, written by lis2hh12Commit()
+		return erSUCCESS;
+	}
 	u8_t u8Buf[2] = { reg, val };
-	int iRV = halI2C_Queue(sLIS2HH12.psI2C, i2cW_B, u8Buf, sizeof(u8Buf), NULL, 0, (i2cq_p1_t) NULL, (i2cq_p2_t) NULL);
+	int iRV = lis2hh12Queue(psDev, i2cW_B, u8Buf, sizeof(u8Buf), NULL, 0, (i2cq_p1_t) NULL, (i2cq_p2_t) NULL);
 	if (pU8) {
  		IF_myASSERT(debugPARAM, halMemoryRAM(pU8));
  		*pU8 = val;										// Optionally, store data at location...
@@ -45,85 +149,484 @@ int lis2hh12WriteReg(u8_t reg, u8_t * pU8, u8_t val) {
 	return iRV;
 }
 
-int lis2hh12ReadRegs(u8_t reg, u8_t * pU8, size_t size) {
+/**
+ * @brief		write consecutive registers in a single auto-increment transaction
+ * @note		shadow registers are NOT updated, caller to do so if required
+ */
+int lis2hh12WriteRegs(lis2hh12_t * psDev, u8_t reg, const u8_t * pU8, size_t size) {
+	IF_myASSERT(debugPARAM, INRANGE(lis2hh12TEMP_L, reg, lis2hh12ZH_REF) && size && (reg + size - 1) <= lis2hh12ZH_REF);
+	u8_t u8Buf[1 + sizeof(lis2hh12_reg_t)];
+	u8Buf[0] = reg;
+	memcpy(&u8Buf[1], pU8, size);
+	return lis2hh12Queue(psDev, i2cW_B, u8Buf, size + 1, NULL, 0, (i2cq_p1_t) NULL, (i2cq_p2_t) NULL);
+}
+
+int lis2hh12ReadRegs(lis2hh12_t * psDev, u8_t reg, u8_t * pU8, size_t size) {
 	IF_myASSERT(debugPARAM, INRANGE(lis2hh12TEMP_L, reg, lis2hh12ZH_REF) && halMemoryRAM(pU8) && size);
-	return halI2C_Queue(sLIS2HH12.psI2C, i2cWR_B, &reg, sizeof(reg), pU8, size, (i2cq_p1_t) NULL, (i2cq_p2_t) NULL);
+	return lis2hh12Queue(psDev, i2cWR_B, &reg, sizeof(reg), pU8, size, (i2cq_p1_t) NULL, (i2cq_p2_t) NULL);
 }
 
 /**
  * @brief		perform a Write-Read-Modify-Write transaction, also updates local register value
+ * @param[in]	psDev - device handle
  * @param[in]	reg - register to be addressed
  * @param[in]	pU8 - pointer to u8_t buffer location to be updated
  * @param[in]	_and - mask to AND value read with (Step 1)
  * @param[in]	_or - mask to OR value read with (Step 2) before writing back to device
- * @return		result from halI2C_Queue()
+ * @return		result from lis2hh12Queue()
  */
-int lis2hh12UpdateReg(u8_t reg, u8_t * pU8, u8_t _and, u8_t _or) {
+int lis2hh12ModifyReg(lis2hh12_t * psDev, u8_t reg, u8_t * pU8, u8_t _and, u8_t _or) {
 	IF_myASSERT(debugPARAM, INRANGE(lis2hh12TEMP_L, reg, lis2hh12ZH_REF) && halMemoryRAM(pU8));
-	return halI2C_Queue(sLIS2HH12.psI2C, i2cWRMW, &reg, sizeof(reg), pU8, 1, (i2cq_p1_t) (u32_t) _and, (i2cq_p2_t) (u32_t) _or);
+	return lis2hh12Queue(psDev, i2cWRMW, &reg, sizeof(reg), pU8, 1, (i2cq_p1_t) (uintptr_t) _and, (i2cq_p2_t) (uintptr_t) _or);
 }
 
-f32_t lis2hh12ConvCoord(i32_t Val) {
-	return (float) Val * (sLIS2HH12.Reg.ctrl4.fs == 0 ? 0.000061 : (sLIS2HH12.Reg.ctrl4.fs == 2) ? 0.000122 : 0.000244);
+/**
+ * @brief		update register field, in RAM only if the shadow cache is enabled else using lis2hh12ModifyReg()
+ * @return		erSUCCESS if cached, else result from lis2hh12ModifyReg()
+ */
+int lis2hh12UpdateReg(lis2hh12_t * psDev, u8_t reg, u8_t * pU8, u8_t _and, u8_t _or) {
+	IF_myASSERT(debugPARAM, INRANGE(lis2hh12TEMP_L, reg, lis2hh12ZH_REF) && halMemoryRAM(pU8));
+	if (psDev->Cached == 0 || (lis2hh12REG_BIT(reg) & lis2hh12VOLATILE))
+		return lis2hh12ModifyReg(psDev, reg, pU8, _and, _or);
+	u8_t New = (*pU8 & _and) | _or;
+	if (New != *pU8) {
+		*pU8 = New;
+		psDev->Dirty |= lis2hh12REG_BIT(reg);
+	}
+	return erSUCCESS;
+}
+
+// ################################### Shadow register cache #######################################
+
+/**
+ * @brief		enable/disable shadow register cache, on enable shadow is first read from the device
+ * @return		erSUCCESS or bus error code
+ * @note		while enabled setters only change the shadow, lis2hh12Commit() writes the changes
+ */
+int lis2hh12CacheEnable(lis2hh12_t * psDev, bool State) {
+	int iRV = erSUCCESS;
+	if (State == 0) {
+		if (psDev->Cached) iRV = lis2hh12Commit(psDev);
+		psDev->Cached = 0;
+		return iRV;
+	}
+	for (size_t i = 0; i < sizeof(CacheRange) / sizeof(CacheRange[0]); ++i) {
+		u8_t First = CacheRange[i][0];
+		iRV = lis2hh12ReadRegs(psDev, First, &psDev->Reg.Regs[lis2hh12REG_IDX(First)], CacheRange[i][1] - First + 1);
+		if (iRV < erSUCCESS)						return iRV;
+	}
+	psDev->Dirty = 0;
+	psDev->Cached = 1;
+	return iRV;
 }
 
+/**
+ * @brief		write all dirty shadow registers to the device, each contiguous run in a single burst
+ * @return		erSUCCESS or bus error code, unwritten registers remain dirty
+ */
+int lis2hh12Commit(lis2hh12_t * psDev) {
+	int iRV = erSUCCESS;
+	u8_t reg = lis2hh12ACT_THS;
+	while (psDev->Dirty && reg <= lis2hh12ZH_REF) {
+		if ((psDev->Dirty & lis2hh12REG_BIT(reg)) == 0) { ++reg; continue; }
+		u8_t Last = reg;
+		u64_t Mask = 0;
+		while (Last <= lis2hh12ZH_REF && (psDev->Dirty & lis2hh12REG_BIT(Last))) {
+			Mask |= lis2hh12REG_BIT(Last);				// macro evaluates its argument twice
+			++Last;
+		}
+		iRV = lis2hh12WriteRegs(psDev, reg, &psDev->Reg.Regs[lis2hh12REG_IDX(reg)], Last - reg);
+		if (iRV < erSUCCESS)						break;
+		psDev->Dirty &= ~Mask;
+		reg = Last;
+	}
+	return iRV;
+}
+
+/**
+ * @brief		profile image of x1E-26 with the CTRL4 bits the transport requires, e.g. SPI i2c_disable
+ */
+static void lis2hh12CfgCTRL(lis2hh12_t * psDev, const lis2hh12_cfg_t * psCfg, u8_t * pImg) {
+	memcpy(pImg, &psCfg->ACT_THS, lis2hh12CTRL7 - lis2hh12ACT_THS + 1);
+	pImg[lis2hh12CTRL4 - lis2hh12ACT_THS] |= psDev->psBus->CTRL4;
+}
+
+/**
+ * @brief		write a configuration profile using 3 bursts: x1E-26, x2E and x30-39
+ * @return		erSUCCESS or bus error code
+ * @note		IG_SRC1/2 (x31/37) are read only and ignore the filler byte written
+ * @note		CTRL4 must have if_add_inc set, as it has after boot, for the bursts to work
+ */
+int lis2hh12ApplyCfg(lis2hh12_t * psDev, const lis2hh12_cfg_t * psCfg) {
+	u8_t IGx[lis2hh12IG_DUR2 - lis2hh12IG_CFG1 + 1] = {
+		psCfg->IG_CFG1, 0, psCfg->IG_THS1[0], psCfg->IG_THS1[1], psCfg->IG_THS1[2], psCfg->IG_DUR1,
+		psCfg->IG_CFG2, 0, psCfg->IG_THS2, psCfg->IG_DUR2,
+	};
+	u8_t CTRL[lis2hh12CTRL7 - lis2hh12ACT_THS + 1];
+	lis2hh12CfgCTRL(psDev, psCfg, CTRL);
+	int iRV = lis2hh12WriteRegs(psDev, lis2hh12ACT_THS, CTRL, sizeof(CTRL));
+	if (iRV < erSUCCESS)							return iRV;
+	iRV = lis2hh12WriteRegs(psDev, lis2hh12FIFO_CTRL, &psCfg->FIFO_CTRL, sizeof(psCfg->FIFO_CTRL));
+	if (iRV < erSUCCESS)							return iRV;
+	iRV = lis2hh12WriteRegs(psDev, lis2hh12IG_CFG1, IGx, sizeof(IGx));
+	if (iRV < erSUCCESS)							return iRV;
+	lis2hh12ShadowCfg(psDev, psCfg);
+	return iRV;
+}
+
+/**
+ * @brief		set the shadow to a profile the device holds, after writing or verifying it
+ */
+void lis2hh12ShadowCfg(lis2hh12_t * psDev, const lis2hh12_cfg_t * psCfg) {
+	lis2hh12CfgCTRL(psDev, psCfg, &psDev->Reg.ACT_THS);
+	psDev->Reg.FIFO_CTRL = psCfg->FIFO_CTRL;
+	psDev->Reg.IG_CFG1 = psCfg->IG_CFG1;
+	memcpy(&psDev->Reg.IG_THS_X1, psCfg->IG_THS1, sizeof(psCfg->IG_THS1));
+	psDev->Reg.IG_DUR1 = psCfg->IG_DUR1;
+	psDev->Reg.IG_CFG2 = psCfg->IG_CFG2;
+	psDev->Reg.IG_THS2 = psCfg->IG_THS2;
+	psDev->Reg.IG_DUR2 = psCfg->IG_DUR2;
+	psDev->Dirty &= ~((lis2hh12REG_BIT(lis2hh12IG_DUR2 + 1) - 1) ^ (lis2hh12REG_BIT(lis2hh12ACT_THS) - 1));
+}
+
+/**
+ * @brief		read x1E-27 and x2E-39 back and compare with the profile
+ * @return		erSUCCESS if identical, erFAILURE if not, else bus error code
+ * @note		OUT_x is skipped, with the FIFO enabled auto increment wraps OUT_Z_H back to OUT_X_L
+ * @note		reading IG_SRCx clears latched events
+ */
+int lis2hh12VerifyCfg(lis2hh12_t * psDev, const lis2hh12_cfg_t * psCfg) {
+	u8_t Img[lis2hh12IG_DUR2 - lis2hh12ACT_THS + 1];
+	#define IMG(r)	Img[(r) - lis2hh12ACT_THS]
+	int iRV = lis2hh12ReadRegs(psDev, lis2hh12ACT_THS, Img, lis2hh12STATUS - lis2hh12ACT_THS + 1);
+	if (iRV < erSUCCESS)							return iRV;
+	iRV = lis2hh12ReadRegs(psDev, lis2hh12FIFO_CTRL, &IMG(lis2hh12FIFO_CTRL), lis2hh12IG_DUR2 - lis2hh12FIFO_CTRL + 1);
+	if (iRV < erSUCCESS)							return iRV;
+	IMG(lis2hh12CTRL5) &= 0xBF;						// soft_reset self clearing
+	IMG(lis2hh12CTRL6) &= 0x7F;						// boot self clearing
+	u8_t CTRL[lis2hh12CTRL7 - lis2hh12ACT_THS + 1];
+	lis2hh12CfgCTRL(psDev, psCfg, CTRL);
+	if (memcmp(&IMG(lis2hh12ACT_THS), CTRL, sizeof(CTRL)) ||
+		IMG(lis2hh12FIFO_CTRL) != psCfg->FIFO_CTRL || IMG(lis2hh12IG_CFG1) != psCfg->IG_CFG1 ||
+		memcmp(&IMG(lis2hh12IG_THS_X1), psCfg->IG_THS1, sizeof(psCfg->IG_THS1)) || IMG(lis2hh12IG_DUR1) != psCfg->IG_DUR1 ||
+		IMG(lis2hh12IG_CFG2) != psCfg->IG_CFG2 || IMG(lis2hh12IG_THS2) != psCfg->IG_THS2 || IMG(lis2hh12IG_DUR2) != psCfg->IG_DUR2)
+		return erFAILURE;
+	return erSUCCESS;
+	#undef IMG
+}
+
+/**
+ * @brief		refresh conversion scale factors if the full scale setting changed
+ * @note		single compare per call, no matter which path (setter, profile, cache) changed CTRL4
+ */
+static inline void lis2hh12UpdateScale(lis2hh12_t * psDev) {
+	u8_t FS = psDev->Reg.ctrl4.fs;
+	if (FS == psDev->ScaleFS)						return;
+	IF_myASSERT(debugPARAM, FS != 1);					// reserved
+	psDev->ScaleQ16 = fs_q16[FS];
+	psDev->ScaleG = fs_g[FS];
+	psDev->ScaleFS = FS;
+	if (psDev->psCal) lis2hh12CalFuse(psDev);
+}
+
+f32_t lis2hh12ConvCoord(lis2hh12_t * psDev, i32_t Val) {
+	lis2hh12UpdateScale(psDev);
+	return (f32_t) Val * psDev->ScaleG;
+}
+
+/**
+ * @brief		convert a block of XYZ samples to mG in Q16.16, interleaved X,Y,Z
+ * @param[out]	pDst - Count * 3 values
+ * @note		with a calibration attached scale, gain, cross axis & offset are one 3x3 MAC pass
+ */
+void lis2hh12ConvBlockQ16(lis2hh12_t * psDev, const lis2hh12_xyz_t * psSrc, i32_t * pDst, size_t Count) {
+	lis2hh12UpdateScale(psDev);
+	if (psDev->psCal) {
+		const i32_t * K = psDev->CalK;
+		const i32_t O0 = psDev->CalO[0], O1 = psDev->CalO[1], O2 = psDev->CalO[2];
+		for (size_t i = 0; i < Count; ++i, pDst += 3) {
+			i32_t X = psSrc[i].X, Y = psSrc[i].Y, Z = psSrc[i].Z;
+			pDst[0] = K[0] * X + K[1] * Y + K[2] * Z + O0;
+			pDst[1] = K[3] * X + K[4] * Y + K[5] * Z + O1;
+			pDst[2] = K[6] * X + K[7] * Y + K[8] * Z + O2;
+		}
+		return;
+	}
+	const i16_t * pS = psSrc->Axis;
+	const i32_t K = psDev->ScaleQ16;
+	size_t N = Count * 3;
+#if defined(__XTENSA__)									// no SIMD, unroll for the MUL pipeline
+	for (; N >= 4; N -= 4, pS += 4, pDst += 4) {
+		pDst[0] = pS[0] * K;
+		pDst[1] = pS[1] * K;
+		pDst[2] = pS[2] * K;
+		pDst[3] = pS[3] * K;
+	}
+#endif
+	for (size_t i = 0; i < N; ++i) pDst[i] = pS[i] * K;	// vectorised on host
+}
+
+/**
+ * @brief		convert a block of XYZ samples to G, interleaved X,Y,Z
+ * @param[out]	pDst - Count * 3 values
+ */
+void lis2hh12ConvBlockF32(lis2hh12_t * psDev, const lis2hh12_xyz_t * psSrc, f32_t * pDst, size_t Count) {
+	lis2hh12UpdateScale(psDev);
+	if (psDev->psCal) {
+		const f32_t * K = psDev->CalKF;
+		for (size_t i = 0; i < Count; ++i, pDst += 3) {
+			f32_t X = psSrc[i].X, Y = psSrc[i].Y, Z = psSrc[i].Z;
+			pDst[0] = K[0] * X + K[1] * Y + K[2] * Z + psDev->CalOF[0];
+			pDst[1] = K[3] * X + K[4] * Y + K[5] * Z + psDev->CalOF[1];
+			pDst[2] = K[6] * X + K[7] * Y + K[8] * Z + psDev->CalOF[2];
+		}
+		return;
+	}
+	const i16_t * pS = psSrc->Axis;
+	const f32_t K = psDev->ScaleG;
+	size_t N = Count * 3;
+#if defined(__XTENSA__)
+	for (; N >= 4; N -= 4, pS += 4, pDst += 4) {
+		pDst[0] = (f32_t) pS[0] * K;
+		pDst[1] = (f32_t) pS[1] * K;
+		pDst[2] = (f32_t) pS[2] * K;
+		pDst[3] = (f32_t) pS[3] * K;
+	}
+#endif
+	for (size_t i = 0; i < N; ++i) pDst[i] = (f32_t) pS[i] * K;
+}
+
+/**
+ * @brief		Period in uSec of a single sample at the current ODR, 0 if powered down
+ */
+u32_t lis2hh12PeriodUS(lis2hh12_t * psDev) {
+	return psDev->Reg.ctrl1.odr ? 1000000UL / odr_scale[psDev->Reg.ctrl1.odr] : 0;
+}
+
+// ####################################### Sample ring #############################################
+
+/**
+ * @brief		add samples to ring, producer side only (I2C completion callbacks)
+ * @param[in]	psXYZ - first of Count consecutive samples, oldest first
+ * @param[in]	TS - time of the LAST (newest) sample in uSec
+ * @param[in]	Period - sample period in uSec, used to back date older samples
+ * @param[in]	Gap - samples lost before psXYZ[0], samples this ring dropped earlier are added
+ * @return		number of samples added, remainder counted as overflow and marked on the next put
+ */
+size_t lis2hh12RingPut(lis2hh12_ring_t * psRing, const lis2hh12_xyz_t * psXYZ, size_t Count, u64_t TS, u32_t Period, u16_t Gap) {
+	u32_t Head = psRing->Head;
+	u32_t Free = lis2hh12RING_SIZE - (Head - __atomic_load_n(&psRing->Tail, __ATOMIC_ACQUIRE));
+	size_t Put = (Count > Free) ? Free : Count;
+	u32_t Lost = psRing->Pend + Gap;
+	for (size_t i = 0; i < Put; ++i, ++Head) {
+		lis2hh12_sample_t * psS = &psRing->Buf[Head & (lis2hh12RING_SIZE - 1)];
+		psS->TS = TS - (u64_t) (Count - 1 - i) * Period;
+		psS->XYZ = psXYZ[i];
+		psS->Gap = (i > 0) ? 0 : (Lost > 0xFFFF) ? 0xFFFF : Lost;
+	}
+	__atomic_store_n(&psRing->Head, Head, __ATOMIC_RELEASE);
+	psRing->Pend = Put ? Count - Put : Lost + Count;
+	psRing->Overflow += Count - Put;
+	u32_t Used = lis2hh12RING_SIZE - Free + Put;
+	if (Used > psRing->HiWater) psRing->HiWater = Used;
+	return Put;
+}
+
+size_t lis2hh12RingCount(lis2hh12_ring_t * psRing) {
+	return __atomic_load_n(&psRing->Head, __ATOMIC_ACQUIRE) - psRing->Tail;
+}
+
+/**
+ * @brief		consumer side, zero copy access to the oldest samples
+ * @param[out]	ppsS - set to first available sample
+ * @return		number of contiguous samples available at *ppsS (ring wrap ends a batch)
+ */
+size_t lis2hh12RingPeek(lis2hh12_ring_t * psRing, lis2hh12_sample_t ** ppsS) {
+	u32_t Tail = psRing->Tail;
+	u32_t Avail = __atomic_load_n(&psRing->Head, __ATOMIC_ACQUIRE) - Tail;
+	u32_t Index = Tail & (lis2hh12RING_SIZE - 1);
+	if (Avail > lis2hh12RING_SIZE - Index) Avail = lis2hh12RING_SIZE - Index;
+	*ppsS = &psRing->Buf[Index];
+	if (Avail && psRing->psAge) {						// age of oldest sample
+		i64_t Age = (i64_t) lis2hh12TIME() - (i64_t) psRing->Buf[Index].TS;
+		lis2hh12HistAdd(psRing->psAge, Age > 0 ? (u32_t) Age : 0);
+	}
+	return Avail;
+}
+
+/**
+ * @brief		consumer side, return samples obtained with lis2hh12RingPeek() to the producer
+ */
+void lis2hh12RingRelease(lis2hh12_ring_t * psRing, size_t Count) {
+	IF_myASSERT(debugPARAM, Count <= lis2hh12RingCount(psRing));
+	__atomic_store_n(&psRing->Tail, psRing->Tail + Count, __ATOMIC_RELEASE);
+}
+
+// ###################################### Latest sample ############################################
+
+/**
+ * @brief		publish the newest sample, writer side only (I2C completion callbacks)
+ * @note		never waits, readers seeing an odd or changed Seq simply retry
+ */
+void lis2hh12LatestPut(lis2hh12_latest_t * psL, const lis2hh12_xyz_t * psXYZ, u64_t TS, u8_t STATUS, u8_t FIFO_SRC) {
+	u32_t Seq = psL->Seq;
+	__atomic_store_n(&psL->Seq, Seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);			// odd Seq visible before any data changes
+	psL->STATUS = STATUS;
+	psL->FIFO_SRC = FIFO_SRC;
+	psL->XYZ = *psXYZ;
+	psL->TS = TS;
+	__atomic_store_n(&psL->Seq, Seq + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief		consistent copy of the newest sample, any task or ISR, never blocks the writer
+ * @return		erSUCCESS, erINV_STATE if nothing published yet or erFAILURE if the writer was busy
+ * 				for all lis2hh12SEQ_TRIES attempts (a preempted writer on the same core)
+ */
+int lis2hh12LatestGet(lis2hh12_latest_t * psL, lis2hh12_latest_t * psOut) {
+	for (int i = 0; i < lis2hh12SEQ_TRIES; ++i) {
+		u32_t Seq = __atomic_load_n(&psL->Seq, __ATOMIC_ACQUIRE);
+		if (Seq == 0)								return erINV_STATE;
+		if (Seq & 1)								continue;
+		psOut->STATUS = psL->STATUS;
+		psOut->FIFO_SRC = psL->FIFO_SRC;
+		psOut->XYZ = psL->XYZ;
+		psOut->TS = psL->TS;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);		// data read before Seq is checked again
+		if (__atomic_load_n(&psL->Seq, __ATOMIC_RELAXED) == Seq) {
+			psOut->Seq = Seq;
+			return erSUCCESS;
+		}
+	}
+	return erFAILURE;
+}
+
+int lis2hh12Latest(lis2hh12_t * psDev, lis2hh12_latest_t * psOut) { return lis2hh12LatestGet(&psDev->Latest, psOut); }
+
 // ################################### Configuration support #######################################
 
-int lis2hh12EnableAxis(lis2hh12_axis_t Axis) { return lis2hh12UpdateReg(lis2hh12CTRL1, &sLIS2HH12.Reg.CTRL1, 0xF8, Axis); }
+int lis2hh12EnableAxis(lis2hh12_t * psDev, lis2hh12_axis_t Axis) { return lis2hh12UpdateReg(psDev, lis2hh12CTRL1, &psDev->Reg.CTRL1, 0xF8, Axis); }
 
-int lis2hh12SetBDU(bool State) { return lis2hh12UpdateReg(lis2hh12CTRL1, &sLIS2HH12.Reg.CTRL1, 0xF7, State << 3); }
+int lis2hh12SetBDU(lis2hh12_t * psDev, bool State) { return lis2hh12UpdateReg(psDev, lis2hh12CTRL1, &psDev->Reg.CTRL1, 0xF7, State << 3); }
 
-int lis2hh12SetODR(lis2hh12_odr_t Rate) { return lis2hh12UpdateReg(lis2hh12CTRL1, &sLIS2HH12.Reg.CTRL1, 0x8F, Rate << 4); }
+int lis2hh12SetODR(lis2hh12_t * psDev, lis2hh12_odr_t Rate) { return lis2hh12UpdateReg(psDev, lis2hh12CTRL1, &psDev->Reg.CTRL1, 0x8F, Rate << 4); }
 
-int lis2hh12SetHR(bool State) { return lis2hh12UpdateReg(lis2hh12CTRL1, &sLIS2HH12.Reg.CTRL1, 0x7F, State << 7); }
+int lis2hh12SetHR(lis2hh12_t * psDev, bool State) { return lis2hh12UpdateReg(psDev, lis2hh12CTRL1, &psDev->Reg.CTRL1, 0x7F, State << 7); }
 
-int lis2hh12SetScale(lis2hh12_fs_t Scale) { return lis2hh12UpdateReg(lis2hh12CTRL4, &sLIS2HH12.Reg.CTRL4, 0xCF, Scale << 4); }
+int lis2hh12SetScale(lis2hh12_t * psDev, lis2hh12_fs_t Scale) { return lis2hh12UpdateReg(psDev, lis2hh12CTRL4, &psDev->Reg.CTRL4, 0xCF, Scale << 4); }
 
-int lis2hh12SetDecimation(lis2hh12_deci_t Samples) { return lis2hh12UpdateReg(lis2hh12CTRL5, &sLIS2HH12.Reg.CTRL5, 0xCF, Samples << 4); }
+int lis2hh12SetDecimation(lis2hh12_t * psDev, lis2hh12_deci_t Samples) { return lis2hh12UpdateReg(psDev, lis2hh12CTRL5, &psDev->Reg.CTRL5, 0xCF, Samples << 4); }
 
-int lis2hh12GetDRDY(void) { return lis2hh12ReadRegs(lis2hh12STATUS, &sLIS2HH12.Reg.STATUS, sizeof(lis2hh12_status_t)); }
+int lis2hh12GetDRDY(lis2hh12_t * psDev) { return lis2hh12ReadRegs(psDev, lis2hh12STATUS, &psDev->Reg.STATUS, sizeof(lis2hh12_status_t)); }
 
 // ######################################## Utility APIs ###########################################
 
-int lis2hh12SoftReset(void) { return lis2hh12UpdateReg(lis2hh12CTRL5, &sLIS2HH12.Reg.CTRL5, 0xBF, 1 << 6); }
+int lis2hh12SoftReset(lis2hh12_t * psDev) {
+	psDev->Cached = 0;									// registers revert to defaults, shadow invalid
+	return lis2hh12ModifyReg(psDev, lis2hh12CTRL5, &psDev->Reg.CTRL5, 0xBF, 1 << 6);
+}
 
-int lis2hh12SetBoot(void) { return lis2hh12UpdateReg(lis2hh12CTRL6, &sLIS2HH12.Reg.CTRL6, 0x7F, 1 << 7); }
+int lis2hh12SetBoot(lis2hh12_t * psDev) {
+	psDev->Cached = 0;									// registers reloaded, shadow invalid
+	return lis2hh12ModifyReg(psDev, lis2hh12CTRL6, &psDev->Reg.CTRL6, 0x7F, 1 << 7);
+}
+
+/**
+ * @brief		reload trimming & defaults, return as soon as CTRL6 boot clears
+ * @return		erSUCCESS, erFAILURE if still booting after lis2hh12BOOT_MS, else bus error code
+ * @note		polled at tick granularity, never longer than the fixed worst case delay it replaces
+ */
+int lis2hh12Reboot(lis2hh12_t * psDev) {
+	u64_t T0 = lis2hh12TIME();
+	psDev->Cached = 0;
+	int iRV = lis2hh12WriteReg(psDev, lis2hh12CTRL6, NULL, 1 << 7);
+	if (iRV < erSUCCESS)							return iRV;
+	psDev->Start.Polls = 0;
+	while (1) {
+		iRV = lis2hh12ReadRegs(psDev, lis2hh12CTRL6, &psDev->Reg.CTRL6, sizeof(psDev->Reg.CTRL6));
+		if (iRV < erSUCCESS)						return iRV;
+		++psDev->Start.Polls;
+		u32_t dT = (u32_t) (lis2hh12TIME() - T0);
+		if (psDev->Reg.ctrl6.boot == 0) {
+			psDev->Start.BootUS = dT ? dT : 1;
+			return erSUCCESS;
+		}
+		if (dT >= lis2hh12BOOT_MS * 1000UL)			return erFAILURE;
+		vTaskDelay(1);
+	}
+}
+
+/**
+ * @brief		write recording header from the shadow registers, must be first in the buffer
+ * @param[in]	TS - uSec, time of the first sample to be recorded
+ * @return		erSUCCESS or erINV_STATE if the buffer has no space
+ */
+int lis2hh12EncHeader(lis2hh12_enc_t * psEnc, lis2hh12_t * psDev, u64_t TS) {
+	u8_t ODR = psDev->Reg.ctrl1.odr;
+	lis2hh12_enc_hdr_t sHdr = {
+		.CTRL1 = psDev->Reg.CTRL1, .CTRL4 = psDev->Reg.CTRL4, .CTRL5 = psDev->Reg.CTRL5, .FIFO_CTRL = psDev->Reg.FIFO_CTRL,
+		.ScaleQ16 = fs_q16[psDev->Reg.ctrl4.fs], .PeriodQ8 = ODR ? (1000000UL << 8) / odr_scale[ODR] : 0,
+		.REF = { psDev->Reg.u16REF_X, psDev->Reg.u16REF_Y, psDev->Reg.u16REF_Z }, .TS = TS,
+	};
+	return (lis2hh12EncStart(psEnc, &sHdr) == lis2hh12_codecOK) ? erSUCCESS : erINV_STATE;
+}
 
 // ################################# Filter configuration support ###################################
 
-int lis2hh12SetFilterIntPath(lis2hh12_intpath_t IntPath) { return lis2hh12UpdateReg(lis2hh12CTRL2, &sLIS2HH12.Reg.CTRL2, 0xFC, IntPath); }
+int lis2hh12SetFilterIntPath(lis2hh12_t * psDev, lis2hh12_intpath_t IntPath) { return lis2hh12UpdateReg(psDev, lis2hh12CTRL2, &psDev->Reg.CTRL2, 0xFC, IntPath); }
 
-int lis2hh12SetFilterOutPath(lis2hh12_outpath_t OutPath) {	// logic to be checked...
-	int iRV = lis2hh12UpdateReg(lis2hh12CTRL1, &sLIS2HH12.Reg.CTRL1, 0x7F, (OutPath == lis2hh12_outpathLOPASS) ? 0x01 : 0x00);
+int lis2hh12SetFilterOutPath(lis2hh12_t * psDev, lis2hh12_outpath_t OutPath) {	// logic to be checked...
+	int iRV = lis2hh12UpdateReg(psDev, lis2hh12CTRL1, &psDev->Reg.CTRL1, 0x7F, (OutPath == lis2hh12_outpathLOPASS) ? 0x01 : 0x00);
 	if (iRV > erFAILURE)
-		iRV = lis2hh12UpdateReg(lis2hh12CTRL2, &sLIS2HH12.Reg.CTRL2, 0xFB, (OutPath == lis2hh12_outpathHIPASS) ? 0x01 : 0x00); 
+		iRV = lis2hh12UpdateReg(psDev, lis2hh12CTRL2, &psDev->Reg.CTRL2, 0xFB, (OutPath == lis2hh12_outpathHIPASS) ? 0x01 : 0x00); 
 	return iRV;
 }
 
-int lis2hh12SetFilterHiPassBW(lis2hh12_hp_bw_t HiPassBW) { return lis2hh12UpdateReg(lis2hh12CTRL2, &sLIS2HH12.Reg.CTRL2, 0x87, HiPassBW); }
+int lis2hh12SetFilterHiPassBW(lis2hh12_t * psDev, lis2hh12_hp_bw_t HiPassBW) { return lis2hh12UpdateReg(psDev, lis2hh12CTRL2, &psDev->Reg.CTRL2, 0x87, HiPassBW); }
 
-int lis2hh12SetFilterLoPassBW(lis2hh12_lp_bw_t LoPassBW) { return lis2hh12UpdateReg(lis2hh12CTRL2, &sLIS2HH12.Reg.CTRL2, 0x9F, LoPassBW); }
+int lis2hh12SetFilterLoPassBW(lis2hh12_t * psDev, lis2hh12_lp_bw_t LoPassBW) { return lis2hh12UpdateReg(psDev, lis2hh12CTRL2, &psDev->Reg.CTRL2, 0x9F, LoPassBW); }
 
-int lis2hh12SetFilterAAliasBW(lis2hh12_aa_bw_t AAliasBW) { return lis2hh12UpdateReg(lis2hh12CTRL4, &sLIS2HH12.Reg.CTRL4, 0x37, AAliasBW); }
+int lis2hh12SetFilterAAliasBW(lis2hh12_t * psDev, lis2hh12_aa_bw_t AAliasBW) { return lis2hh12UpdateReg(psDev, lis2hh12CTRL4, &psDev->Reg.CTRL4, 0x37, AAliasBW); }
 
-int lis2hh12SetFilterReference(i16_t RefVal) {
+int lis2hh12SetFilterReference(lis2hh12_t * psDev, i16_t RefVal) {
 	i16_t i16Array[3] = { RefVal, RefVal, RefVal };
-	return halI2C_Queue(sLIS2HH12.psI2C, i2cW, (u8_t *)&i16Array[0], sizeof(i16Array), NULL, 0, (i2cq_p1_t) NULL, (i2cq_p2_t) NULL);
+	int iRV = lis2hh12WriteRegs(psDev, lis2hh12XL_REF, (u8_t *) &i16Array[0], sizeof(i16Array));
+	if (iRV < erSUCCESS)							return iRV;
+	psDev->Reg.u16REF_X = psDev->Reg.u16REF_Y = psDev->Reg.u16REF_Z = RefVal;
+	return iRV;
 }
 
-int lis2hh12SetInactivity(u8_t ths, u8_t dur) {
-	int iRV = lis2hh12WriteReg(lis2hh12ACT_THS, &sLIS2HH12.Reg.ACT_THS, ths);	// #of FSD/128 mG
+int lis2hh12SetInactivity(lis2hh12_t * psDev, u8_t ths, u8_t dur) {
+	int iRV = lis2hh12WriteReg(psDev, lis2hh12ACT_THS, &psDev->Reg.ACT_THS, ths);	// #of FSD/128 mG
 	if (iRV < erSUCCESS)							return iRV;
-	iRV = lis2hh12WriteReg(lis2hh12ACT_DUR, &sLIS2HH12.Reg.ACT_DUR, dur);	// # of (8/ODR) sec
+	iRV = lis2hh12WriteReg(psDev, lis2hh12ACT_DUR, &psDev->Reg.ACT_DUR, dur);	// # of (8/ODR) sec
 	if (iRV < erSUCCESS)							return iRV;
 	u8_t stat = (ths > 0 || dur > 0) ? 0x20 : 0x00;		// INT1_INACT en/disable?
-	return lis2hh12UpdateReg(lis2hh12CTRL3, &sLIS2HH12.Reg.CTRL3, 0xDF, stat);
+	return lis2hh12UpdateReg(psDev, lis2hh12CTRL3, &psDev->Reg.CTRL3, 0xDF, stat);
 }
 
-int lis2hh12SetBW(e_bw_t bw) { return lis2hh12UpdateReg(lis2hh12CTRL4, &sLIS2HH12.Reg.CTRL4, 0x3F, bw << 6); }
+int lis2hh12SetBW(lis2hh12_t * psDev, e_bw_t bw) { return lis2hh12UpdateReg(psDev, lis2hh12CTRL4, &psDev->Reg.CTRL4, 0x3F, bw << 6); }
+
+/**
+ * @brief		enable burst FIFO drain, all available samples read in a single auto-increment transaction
+ * @param[in]	psBlk - caller provided block buffer, NULL to revert to per sample drain
+ * @param[in]	Size - capacity of psBlk in samples, max lis2hh12FIFO_DEPTH
+ * @param[in]	cbBlk - optional callback with each drained block
+ * @return		erSUCCESS or erINV_PARA
+ */
+int lis2hh12SetFIFOBlock(lis2hh12_t * psDev, lis2hh12_xyz_t * psBlk, u8_t Size, lis2hh12_blk_cb_t cbBlk) {
+	IF_myASSERT(debugPARAM, psBlk == NULL || halMemoryRAM(psBlk));
+	if (psBlk && (Size == 0 || Size > lis2hh12FIFO_DEPTH))	return erINV_PARA;
+	psDev->psBlk = NULL;							// disable while changing
+	psDev->BlkSize = psBlk ? Size : 0;
+	psDev->cbBlk = cbBlk;
+	psDev->psBlk = psBlk;
+	return erSUCCESS;
+}
 
-int lis2hh12ConfigFIFO(e_fm_t mode, u8_t thres) {
-	int iRV = lis2hh12WriteReg(lis2hh12FIFO_CTRL, &sLIS2HH12.Reg.FIFO_CTRL, (mode << 5) | (thres & 0x1F));
+int lis2hh12ConfigFIFO(lis2hh12_t * psDev, e_fm_t mode, u8_t thres) {
+	int iRV = lis2hh12WriteReg(psDev, lis2hh12FIFO_CTRL, &psDev->Reg.FIFO_CTRL, (mode << 5) | (thres & 0x1F));
 	if (iRV < erSUCCESS)							return iRV;
 	u8_t mask, flag;
 	if (mode > fmBYPASS && thres > 0) {				// AMM verify logic below, untested!!!
@@ -133,329 +636,626 @@ int lis2hh12ConfigFIFO(e_fm_t mode, u8_t thres) {
 		mask = 0x7F;
 		flag = 0x80;
 	}
-	return lis2hh12UpdateReg(lis2hh12CTRL3, &sLIS2HH12.Reg.CTRL3, mask, flag);
+	return lis2hh12UpdateReg(psDev, lis2hh12CTRL3, &psDev->Reg.CTRL3, mask, flag);
+}
+
+/**
+ * @brief		one watermark adaptation window, call periodically (~1 second) from a task
+ * @param[in]	Margin - samples kept free beyond the worst FIFO lag seen at decode
+ * @return		FTH now in use or erINV_STATE if the FIFO is not active
+ * @note		deepest FTH is DEPTH-1 - worst lag - Margin. On overrun FTH is halved, when the lag grows
+ * 				FTH drops straight to the new depth, after lis2hh12WM_CLEAN clean windows it is probed one
+ * 				deeper. With a power manager attached the active profile learns the value.
+ */
+int lis2hh12AdaptFIFO(lis2hh12_t * psDev, u8_t Margin) {
+	lis2hh12_wm_t * psWM = &psDev->WM;
+	if (psDev->Reg.ctrl3.fifo_en == 0 || psDev->Reg.fifo_ctrl.fmode == fmBYPASS)	return erINV_STATE;
+	u8_t Lag = __atomic_exchange_n(&psWM->Lag, 0, __ATOMIC_RELAXED);
+	u8_t Ovr = __atomic_exchange_n(&psWM->Ovr, 0, __ATOMIC_RELAXED);
+	int FTH = psDev->Reg.fifo_ctrl.fth;
+	if (psDev->Reg.ctrl1.odr != psWM->ODR) {				// lag in samples measured at another rate
+		psWM->ODR = psDev->Reg.ctrl1.odr;
+		psWM->Clean = 0;
+		return FTH;
+	}
+	int Deep = lis2hh12FIFO_DEPTH - 1 - Lag - Margin;
+	int New = FTH;
+	if (Ovr) {
+		New = FTH / 2;
+		psWM->Clean = 0;
+	} else if (Deep < FTH) {
+		New = Deep;
+		psWM->Clean = 0;
+	} else if (++psWM->Clean >= lis2hh12WM_CLEAN) {
+		if (FTH < Deep) New = FTH + 1;
+		psWM->Clean = 0;
+	}
+	if (New < 1) New = 1;
+	if (New > lis2hh12FIFO_DEPTH - 1) New = lis2hh12FIFO_DEPTH - 1;
+	if (New == FTH)									return FTH;
+	int iRV = lis2hh12ConfigFIFO(psDev, psDev->Reg.fifo_ctrl.fmode, New);
+	if (iRV >= erSUCCESS && psDev->Cached) iRV = lis2hh12Commit(psDev);	// else only the shadow has the new FTH
+	if (iRV < erSUCCESS)							return iRV;
+	++psWM->Changes;
+	if (psDev->psPm) psDev->psPm->Prof[psDev->psPm->State].FTH = New;
+	return New;
 }
 
 // #################################### Reporting support ##########################################
 
-int lis2hh12ReportTEMP(report_t * psR) {
-	return xReport(psR, "\tTEMP: (x%04X) Val=%d" strNL, sLIS2HH12.Reg.i16TEMP, sLIS2HH12.Reg.i16TEMP);
+int lis2hh12ReportTEMP(report_t * psR, lis2hh12_t * psDev) {
+	return xReport(psR, "\tTEMP: (x%04X) Val=%d" strNL, psDev->Reg.i16TEMP, psDev->Reg.i16TEMP);
 }
 
-int lis2hh12ReportActDur(report_t * psR) {
-	i32_t Val = sLIS2HH12.Reg.ctrl1.odr ? (sLIS2HH12.Reg.ACT_DUR * 8) / odr_scale[sLIS2HH12.Reg.ctrl1.odr] : 0;
-	return xReport(psR, "\tACT_DUR: (x%02X) %ds " strNL, sLIS2HH12.Reg.ACT_DUR, Val);
+int lis2hh12ReportActDur(report_t * psR, lis2hh12_t * psDev) {
+	i32_t Val = psDev->Reg.ctrl1.odr ? (psDev->Reg.ACT_DUR * 8) / odr_scale[psDev->Reg.ctrl1.odr] : 0;
+	return xReport(psR, "\tACT_DUR: (x%02X) %ds " strNL, psDev->Reg.ACT_DUR, Val);
 }
 
-int lis2hh12ReportActThr(report_t * psR) {
-	i32_t Val = (sLIS2HH12.Reg.ACT_THS * fs_scale[sLIS2HH12.Reg.ctrl4.fs]) / 128;
-	return xReport(psR, "\tACT_THS: (x%02X) %dmg " strNL, sLIS2HH12.Reg.ACT_THS, Val);
+int lis2hh12ReportActThr(report_t * psR, lis2hh12_t * psDev) {
+	i32_t Val = (psDev->Reg.ACT_THS * fs_scale[psDev->Reg.ctrl4.fs]) / 128;
+	return xReport(psR, "\tACT_THS: (x%02X) %dmg " strNL, psDev->Reg.ACT_THS, Val);
 }
 
-int li2hh12ReportCTRL1(report_t * psR) {
+int li2hh12ReportCTRL1(report_t * psR, lis2hh12_t * psDev) {
 	return xReport(psR, "\tCTRL1: (x%02X)  hr=%d  odr=%d/%dHz  bdu=%d  Zen=%d  Yen=%d  Xen=%d" strNL,
-		sLIS2HH12.Reg.CTRL1, sLIS2HH12.Reg.ctrl1.hr, sLIS2HH12.Reg.ctrl1.odr, odr_scale[sLIS2HH12.Reg.ctrl1.odr],
-		sLIS2HH12.Reg.ctrl1.bdu, sLIS2HH12.Reg.ctrl1.zen, sLIS2HH12.Reg.ctrl1.yen, sLIS2HH12.Reg.ctrl1.xen);
+		psDev->Reg.CTRL1, psDev->Reg.ctrl1.hr, psDev->Reg.ctrl1.odr, odr_scale[psDev->Reg.ctrl1.odr],
+		psDev->Reg.ctrl1.bdu, psDev->Reg.ctrl1.zen, psDev->Reg.ctrl1.yen, psDev->Reg.ctrl1.xen);
 }
 
-int li2hh12ReportCTRL2(report_t * psR) {
+int li2hh12ReportCTRL2(report_t * psR, lis2hh12_t * psDev) {
 	return xReport(psR, "\tCTRL2: (x%02X)  dfc=%d  hpm=%d  fds=%d  hpis1=%d  hpis2=%d" strNL,
-		sLIS2HH12.Reg.CTRL2, sLIS2HH12.Reg.ctrl2.dfc, sLIS2HH12.Reg.ctrl2.hpm,
-		sLIS2HH12.Reg.ctrl2.fds, sLIS2HH12.Reg.ctrl2.hpis1, sLIS2HH12.Reg.ctrl2.hpis2);
+		psDev->Reg.CTRL2, psDev->Reg.ctrl2.dfc, psDev->Reg.ctrl2.hpm,
+		psDev->Reg.ctrl2.fds, psDev->Reg.ctrl2.hpis1, psDev->Reg.ctrl2.hpis2);
 }
 
-int li2hh12ReportCTRL3(report_t * psR) {
+int li2hh12ReportCTRL3(report_t * psR, lis2hh12_t * psDev) {
 	return xReport(psR, "\tCTRL3: (x%02X)  fifo_en=%d  stop_fth=%d  I1inact=%d  I1ig2=%d  I1ig1=%d  I1ovr=%d  I1fth=%d  I1drdy=%d" strNL,
-		sLIS2HH12.Reg.CTRL3, sLIS2HH12.Reg.ctrl3.fifo_en, sLIS2HH12.Reg.ctrl3.stop_fth, sLIS2HH12.Reg.ctrl3.int1_inact,
-		sLIS2HH12.Reg.ctrl3.int1_ig2, sLIS2HH12.Reg.ctrl3.int1_ig1, sLIS2HH12.Reg.ctrl3.int1_ovr, sLIS2HH12.Reg.ctrl3.int1_fth, sLIS2HH12.Reg.ctrl3.int1_drdy);
+		psDev->Reg.CTRL3, psDev->Reg.ctrl3.fifo_en, psDev->Reg.ctrl3.stop_fth, psDev->Reg.ctrl3.int1_inact,
+		psDev->Reg.ctrl3.int1_ig2, psDev->Reg.ctrl3.int1_ig1, psDev->Reg.ctrl3.int1_ovr, psDev->Reg.ctrl3.int1_fth, psDev->Reg.ctrl3.int1_drdy);
 }
 
-int li2hh12ReportCTRL4(report_t * psR) {
+int li2hh12ReportCTRL4(report_t * psR, lis2hh12_t * psDev) {
 	return xReport(psR, "\tCTRL4: (x%02X)  bw=%d  fs=%d/%dG  bws_odr=%d  IAInc=%d  I2cdis=%d  sim=%d" strNL,
-		sLIS2HH12.Reg.CTRL4, sLIS2HH12.Reg.ctrl4.bw, sLIS2HH12.Reg.ctrl4.fs, fs_scale[sLIS2HH12.Reg.ctrl4.fs]/1000,
-		sLIS2HH12.Reg.ctrl4.bw_scale_odr, sLIS2HH12.Reg.ctrl4.if_add_inc, sLIS2HH12.Reg.ctrl4.i2c_disable, sLIS2HH12.Reg.ctrl4.sim);
+		psDev->Reg.CTRL4, psDev->Reg.ctrl4.bw, psDev->Reg.ctrl4.fs, fs_scale[psDev->Reg.ctrl4.fs]/1000,
+		psDev->Reg.ctrl4.bw_scale_odr, psDev->Reg.ctrl4.if_add_inc, psDev->Reg.ctrl4.i2c_disable, psDev->Reg.ctrl4.sim);
 }
 
-int li2hh12ReportCTRL5(report_t * psR) {
+int li2hh12ReportCTRL5(report_t * psR, lis2hh12_t * psDev) {
 	return xReport(psR, "\tCTRL5: (x%02X)  dbg=%d  rst=%d  dec=%d  st=%d  HLactive=%d  pp_od=%d" strNL,
-		sLIS2HH12.Reg.CTRL5, sLIS2HH12.Reg.ctrl5.debug, sLIS2HH12.Reg.ctrl5.soft_reset, sLIS2HH12.Reg.ctrl5.dec,
-		sLIS2HH12.Reg.ctrl5.st, sLIS2HH12.Reg.ctrl5.h_lactive, sLIS2HH12.Reg.ctrl5.pp_od);
+		psDev->Reg.CTRL5, psDev->Reg.ctrl5.debug, psDev->Reg.ctrl5.soft_reset, psDev->Reg.ctrl5.dec,
+		psDev->Reg.ctrl5.st, psDev->Reg.ctrl5.h_lactive, psDev->Reg.ctrl5.pp_od);
 }
 
-int li2hh12ReportCTRL6(report_t * psR) {
+int li2hh12ReportCTRL6(report_t * psR, lis2hh12_t * psDev) {
 	return xReport(psR, "\tCTRL6: (x%02X)  boot=%d  I2boot=%d  I2ig2=%d  I2ig1=%d  I2empty=%d  I2fth=%d  I2drdy=%d" strNL,
-		sLIS2HH12.Reg.CTRL6, sLIS2HH12.Reg.ctrl6.boot, sLIS2HH12.Reg.ctrl6.int2_boot, sLIS2HH12.Reg.ctrl6.int2_ig2,
-		sLIS2HH12.Reg.ctrl6.int2_ig1, sLIS2HH12.Reg.ctrl6.int2_empty, sLIS2HH12.Reg.ctrl6.int2_fth, sLIS2HH12.Reg.ctrl6.int2_drdy);
+		psDev->Reg.CTRL6, psDev->Reg.ctrl6.boot, psDev->Reg.ctrl6.int2_boot, psDev->Reg.ctrl6.int2_ig2,
+		psDev->Reg.ctrl6.int2_ig1, psDev->Reg.ctrl6.int2_empty, psDev->Reg.ctrl6.int2_fth, psDev->Reg.ctrl6.int2_drdy);
 }
 
-int li2hh12ReportCTRL7(report_t * psR) {
+int li2hh12ReportCTRL7(report_t * psR, lis2hh12_t * psDev) {
 	return xReport(psR, "\tCTRL7: (x%02X)  I2dcrm=%d  I1dcrm=%d  I2lir=%d  I1lir=%d  IG2_4d=%d  IG1_4d=%d" strNL,
-		sLIS2HH12.Reg.CTRL7, sLIS2HH12.Reg.ctrl7.dcrm2, sLIS2HH12.Reg.ctrl7.dcrm1, sLIS2HH12.Reg.ctrl7.lir2,
-		sLIS2HH12.Reg.ctrl7.lir1, sLIS2HH12.Reg.ctrl7._4d_ig2, sLIS2HH12.Reg.ctrl7._4d_ig1);
+		psDev->Reg.CTRL7, psDev->Reg.ctrl7.dcrm2, psDev->Reg.ctrl7.dcrm1, psDev->Reg.ctrl7.lir2,
+		psDev->Reg.ctrl7.lir1, psDev->Reg.ctrl7._4d_ig2, psDev->Reg.ctrl7._4d_ig1);
 }
 
-int li2hh12ReportSTATUS(report_t * psR) {
+int li2hh12ReportSTATUS(report_t * psR, lis2hh12_t * psDev) {
 	return xReport(psR, "\tSTATUS: (x%02X)  ZYXor=%d  Zor=%d  Yor=%d  Xor=%d  ZYXda=%d  Zda=%d  Yda=%d  Xda=%d" strNL,
-		sLIS2HH12.Reg.STATUS, sLIS2HH12.Reg.status.ZYXor, sLIS2HH12.Reg.status.Zor, sLIS2HH12.Reg.status.Yor, sLIS2HH12.Reg.status.Xor,
-		sLIS2HH12.Reg.status.ZYXda, sLIS2HH12.Reg.status.Zda, sLIS2HH12.Reg.status.Yda, sLIS2HH12.Reg.status.Xda);
+		psDev->Reg.STATUS, psDev->Reg.status.ZYXor, psDev->Reg.status.Zor, psDev->Reg.status.Yor, psDev->Reg.status.Xor,
+		psDev->Reg.status.ZYXda, psDev->Reg.status.Zda, psDev->Reg.status.Yda, psDev->Reg.status.Xda);
 }
 
-int lis2hh12ReportOUTxyz(report_t * psR) {
-	return xReport(psR, "\tOUT_X=%hd  OUT_Y=%hd  OUT_Z=%hd" strNL, sLIS2HH12.Reg.i16OUT_X, sLIS2HH12.Reg.i16OUT_Y, sLIS2HH12.Reg.i16OUT_Z);
+int lis2hh12ReportOUTxyz(report_t * psR, lis2hh12_t * psDev) {
+	lis2hh12_latest_t sL = { 0 };							// Reg.OUT_x is rewritten by bus callbacks
+	lis2hh12LatestGet(&psDev->Latest, &sL);
+	return xReport(psR, "\tOUT_X=%hd  OUT_Y=%hd  OUT_Z=%hd  TS=%llu  Seq=%lu" strNL, sL.XYZ.X, sL.XYZ.Y, sL.XYZ.Z, sL.TS, sL.Seq >> 1);
 }
 
-int lis2hh12ReportFIFO_CTRL(report_t * psR) {
+int lis2hh12ReportFIFO_CTRL(report_t * psR, lis2hh12_t * psDev) {
 	static char * fifoMode[] = { "Bypass", "FIFO", "Stream", "StoF", "BtoS", "5=inv", "6=inv", "BtoF" };
-	return xReport(psR, "\tFIFO_CTRL: (x%02X)  mode=%s(%hhu)  thres=%hhu" strNL, sLIS2HH12.Reg.FIFO_CTRL,
-		fifoMode[sLIS2HH12.Reg.fifo_ctrl.fmode], sLIS2HH12.Reg.fifo_ctrl.fmode, sLIS2HH12.Reg.fifo_ctrl.fth);
+	return xReport(psR, "\tFIFO_CTRL: (x%02X)  mode=%s(%hhu)  thres=%hhu" strNL, psDev->Reg.FIFO_CTRL,
+		fifoMode[psDev->Reg.fifo_ctrl.fmode], psDev->Reg.fifo_ctrl.fmode, psDev->Reg.fifo_ctrl.fth);
 }
 
-int lis2hh12ReportFIFO_SRC(report_t * psR) {
-	return xReport(psR, "\tFIFO_SRC: (x%02X)  fth=%d  ovr=%d  empty=%d  fss=%d" strNL, sLIS2HH12.Reg.FIFO_SRC,
-		sLIS2HH12.Reg.fifo_src.fth, sLIS2HH12.Reg.fifo_src.ovr, sLIS2HH12.Reg.fifo_src.empty, sLIS2HH12.Reg.fifo_src.fss);
+int lis2hh12ReportFIFO_SRC(report_t * psR, lis2hh12_t * psDev) {
+	return xReport(psR, "\tFIFO_SRC: (x%02X)  fth=%d  ovr=%d  empty=%d  fss=%d" strNL, psDev->Reg.FIFO_SRC,
+		psDev->Reg.fifo_src.fth, psDev->Reg.fifo_src.ovr, psDev->Reg.fifo_src.empty, psDev->Reg.fifo_src.fss);
 }
 
-int lis2hh12ReportIGx(report_t * psR, bool X) {
-	lis2hh12_ig_cfg_t CfgX = X ? sLIS2HH12.Reg.ig_cfg2 : sLIS2HH12.Reg.ig_cfg1;
-	lis2hh12_ig_src_t SrcX = X ? sLIS2HH12.Reg.ig_src2 : sLIS2HH12.Reg.ig_src1;
-	lis2hh12_ig_dur_t DurX = X ? sLIS2HH12.Reg.ig_dur2 : sLIS2HH12.Reg.ig_dur1;
+int lis2hh12ReportIGx(report_t * psR, lis2hh12_t * psDev, bool X) {
+	lis2hh12_ig_cfg_t CfgX = X ? psDev->Reg.ig_cfg2 : psDev->Reg.ig_cfg1;
+	lis2hh12_ig_src_t SrcX = X ? psDev->Reg.ig_src2 : psDev->Reg.ig_src1;
+	lis2hh12_ig_dur_t DurX = X ? psDev->Reg.ig_dur2 : psDev->Reg.ig_dur1;
 	int iRV = xReport(psR, "\tIG_CFG%d: (x%02X)  aoi=%d  d6=%d  Zh=%d  Zl=%d  Yh=%d  Yl=%d  Xh=%d  Xl=%d" strNL,
 		X, CfgX, CfgX.aoi, CfgX.d6, CfgX.zh, CfgX.zl, CfgX.yh, CfgX.yl, CfgX.xh, CfgX.xl);
 	iRV += xReport(psR, "\tIG_SRC%d: (x%02X)  ia=%d  Zh=%d  Zl=%d  Yh=%d  Yl=%d  Xh=%d  Xl=%d" strNL,
 		X, SrcX, SrcX.ia, SrcX.zh, SrcX.zl, SrcX.yh, SrcX.yl, SrcX.xh, SrcX.xl);
 	iRV += xReport(psR, "\tIG%d: (x%02X)  wait=%d  dur=%d  ths", X, DurX, DurX.wait, DurX.ths);
-	if (X) iRV += xReport(psR, "=%d" strNL, sLIS2HH12.Reg.IG_THS2);
-	else iRV += xReport(psR, ": X=%d  Y=%d  Z=%d" strNL, sLIS2HH12.Reg.IG_THS_X1, sLIS2HH12.Reg.IG_THS_Y1, sLIS2HH12.Reg.IG_THS_Z1);
+	if (X) iRV += xReport(psR, "=%d" strNL, psDev->Reg.IG_THS2);
+	else iRV += xReport(psR, ": X=%d  Y=%d  Z=%d" strNL, psDev->Reg.IG_THS_X1, psDev->Reg.IG_THS_Y1, psDev->Reg.IG_THS_Z1);
 	return iRV;
 }
 
-int lis2hh12ReportREFxyz(report_t * psR) {
-	return xReport(psR, "\tREF_X=%d  REF_Y=%d  REF_Z=%d" strNL, sLIS2HH12.Reg.u16REF_X, sLIS2HH12.Reg.u16REF_Y, sLIS2HH12.Reg.u16REF_Z);
+int lis2hh12ReportREFxyz(report_t * psR, lis2hh12_t * psDev) {
+	return xReport(psR, "\tREF_X=%d  REF_Y=%d  REF_Z=%d" strNL, psDev->Reg.u16REF_X, psDev->Reg.u16REF_Y, psDev->Reg.u16REF_Z);
 }
 
-int lis2hh12ReportCounters(report_t * psR) {
-	return xReport(psR, "\tIRQs OK=%lu  Lost=%lu  DRDY=%lu  DRDYerr=%lu  FIFO=%lu  IG1=%lu  IG2=%lu  INACT=%lu  BOOT=%lu" strNL, lis2hh12IRQok,
-		lis2hh12IRQlost, lis2hh12IRQdrdy, lis2hh12IRQdrdyErr, lis2hh12IRQfifo, lis2hh12IRQig1, lis2hh12IRQig2, lis2hh12IRQinact, lis2hh12IRQboot);
+/**
+ * @brief		copy instrumentation block, optionally zeroing it, word by word without locking
+ * @param[out]	psSnap - destination, NULL to just reset
+ * @note		each word is exchanged atomically, the block as a whole is not a single instant
+ */
+void lis2hh12InstSnapshot(lis2hh12_t * psDev, lis2hh12_inst_t * psSnap, bool Reset) {
+	u32_t * pSrc = (u32_t *) &psDev->Inst;
+	u32_t * pDst = (u32_t *) psSnap;
+	for (size_t i = 0; i < sizeof(lis2hh12_inst_t) / sizeof(u32_t); ++i) {
+		u32_t Val = Reset ? __atomic_exchange_n(&pSrc[i], 0, __ATOMIC_RELAXED) : __atomic_load_n(&pSrc[i], __ATOMIC_RELAXED);
+		if (pDst) pDst[i] = Val;
+	}
+}
+
+int lis2hh12ReportHist(report_t * psR, const char * pcName, lis2hh12_hist_t * psH) {
+	int iRV = xReport(psR, "\t%s Max=%lu ", pcName, psH->Max);
+	for (int i = 0; i < lis2hh12HIST_BINS; ++i) {
+		if (psH->Bin[i]) iRV += xReport(psR, " <%lu:%lu", i < 31 ? 1UL << i : 0, psH->Bin[i]);
+	}
+	return iRV + xReport(psR, strNL);
+}
+
+int lis2hh12ReportCounters(report_t * psR, lis2hh12_t * psDev) {
+	static const char * const HistName[lis2hh12_hNUM] = { "IRQ0 cyc", "BUS uS", "IRQ1 cyc", "DATA uS", "POP uS" };
+	lis2hh12_inst_t sI;
+	lis2hh12InstSnapshot(psDev, &sI, false);
+	int iRV = xReport(psR, "\tIRQs OK=%lu  Lost=%lu  DRDY=%lu  DRDYerr=%lu  FIFO=%lu  IG1=%lu  IG2=%lu  INACT=%lu  BOOT=%lu" strNL, sI.IRQok,
+		sI.IRQlost, sI.IRQdrdy, sI.IRQdrdyErr, sI.IRQfifo, sI.IRQig1, sI.IRQig2, sI.IRQinact, sI.IRQboot);
+	u32_t TpS = sI.FIFOsamples ? (sI.FIFOtrans * 1000) / sI.FIFOsamples : 0;
+	iRV += xReport(psR, "\tFIFO Trans=%lu  Samples=%lu  Trans/Sample=%lu.%03lu  Fill", sI.FIFOtrans,
+		sI.FIFOsamples, TpS / 1000, TpS % 1000);
+	for (int i = 0; i <= lis2hh12FIFO_DEPTH; ++i) {
+		if (sI.Fill[i]) iRV += xReport(psR, " %d:%lu", i, sI.Fill[i]);
+	}
+	iRV += xReport(psR, strNL "\tOVR Events=%lu  Lost=%lu  FTH changes=%lu" strNL, sI.Overrun, sI.Lost, psDev->WM.Changes);
+	lis2hh12_start_t * psS = &psDev->Start;
+	iRV += xReport(psR, "\tSTART %s Boot=%luuS (%hhu polls)  Identify=%luuS  Config=%luuS  First sample=%luuS" strNL,
+		psS->BootUS ? "COLD" : "WARM", psS->BootUS, psS->Polls, psS->IdentUS, psS->ConfigUS, psS->FirstUS);
+	iRV += xReport(psR, "\tBUS %s Trans=%lu  Bytes=%lu  Err=%lu" strNL, psDev->psBus ? psDev->psBus->pcName : "-",
+		sI.BusTrans, sI.BusBytes, sI.BusErr);
+	for (int i = 0; i < lis2hh12_hNUM; ++i) iRV += lis2hh12ReportHist(psR, HistName[i], &sI.Hist[i]);
+	iRV += xReport(psR, "\tRING Used=%u/%d  HiWater=%lu  Overflow=%lu" strNL, lis2hh12RingCount(&psDev->Ring),
+		lis2hh12RING_SIZE, psDev->Ring.HiWater, psDev->Ring.Overflow);
+	lis2hh12_clk_t * psClk = &psDev->Clk;
+	i32_t PPM = psClk->Nominal ? (i32_t) (((i64_t) (psClk->Period - psClk->Nominal) * 1000000) / (i64_t) psClk->Nominal) : 0;
+	iRV += xReport(psR, "\tCLK Period=%.3fuS  Drift=%ldppm  Err=%.1fuS  Refs=%lu  Resync=%lu" strNL, (f32_t) psClk->Period / 65536.0f,
+		PPM, (f32_t) psClk->Err / 65536.0f, psClk->Refs, psClk->Resync);
+	return iRV;
 }
 
 // #################################### Interrupt support ##########################################
 
+/**
+ *	@brief	timestamp a block of raw samples from the tracked sensor clock
+ *	@param[out]	pPeriod - estimated sample period in uSec
+ *	@return	time of the newest sample in the block, uSec
+ *	@note	IRQ_1 marks which coming sample was the newest when INTx fired (DRDY or FIFO threshold).
+ *			When that sample is delivered its IRQ time is compared to the prediction and the phase
+ *			and period nudged, a PLL in effect, so the internal oscillator drift (few %) is tracked
+ *			and samples between references get sub period timestamps without per sample IRQs.
+ */
+static u64_t lis2hh12ClkStamp(lis2hh12_t * psDev, size_t Count, u32_t * pPeriod) {
+	lis2hh12_clk_t * psClk = &psDev->Clk;
+	u8_t ODR = psDev->Reg.ctrl1.odr;
+	if (ODR != psClk->ODR || psClk->Nominal == 0) {				// (re)start at nominal rate
+		psClk->ODR = ODR;
+		psClk->Nominal = ODR ? ((u64_t) 1000000 << 16) / odr_scale[ODR] : (u64_t) 1 << 16;
+		psClk->Period = psClk->Nominal;
+		psClk->Next = 0;
+	}
+	psClk->Span += Count;
+	if (psClk->RefIdx && psClk->RefIdx <= Count) {				// block holds the reference sample
+		u64_t Ref = psClk->RefTS << 16;
+		i64_t Err = (i64_t) (Ref - (psClk->Next + (psClk->RefIdx - 1) * psClk->Period));
+		i64_t Lim = (i64_t) psClk->Period * 2;
+		if (psClk->Next == 0 || Err > Lim || Err < -Lim) {		// not locked or samples lost
+			psClk->Next = Ref - (psClk->RefIdx - 1) * psClk->Period;
+			++psClk->Resync;
+		} else {
+			psClk->Next += Err / (1 << lis2hh12CLK_KP);
+			psClk->Period += Err / (i64_t) psClk->Span / (1 << lis2hh12CLK_KI);
+			u64_t Dev = psClk->Nominal / 8;						// clamp to +-12.5% of nominal
+			if (psClk->Period > psClk->Nominal + Dev) psClk->Period = psClk->Nominal + Dev;
+			if (psClk->Period < psClk->Nominal - Dev) psClk->Period = psClk->Nominal - Dev;
+		}
+		psClk->Err = Err;
+		psClk->Span = 0;
+		psClk->RefIdx = 0;
+		++psClk->Refs;
+	} else if (psClk->RefIdx) {
+		psClk->RefIdx -= Count;
+	}
+	if (psClk->Next == 0) psClk->Next = (lis2hh12TIME() << 16) - (Count - 1) * psClk->Period;
+	if (psClk->Last && psClk->Next < psClk->Last + psClk->Period / 2) psClk->Next = psClk->Last + psClk->Period / 2;
+	u64_t Newest = psClk->Next + (Count - 1) * psClk->Period;
+	psClk->Last = Newest;
+	psClk->Next = Newest + psClk->Period;
+	*pPeriod = (psClk->Period + 0x8000) >> 16;
+	return (Newest + 0x8000) >> 16;
+}
+
+/**
+ *	@brief	mark the Idx'th (1 based) sample still to be delivered as the newest at INTx time
+ */
+static void lis2hh12ClkRef(lis2hh12_t * psDev, u8_t Idx) {
+	psDev->Clk.RefTS = psDev->Clk.IrqTS;
+	psDev->Clk.RefIdx = psDev->Clk.IrqTS ? Idx : 0;
+}
+
+/**
+ *	@brief	common sink for DRDY, per sample FIFO and burst FIFO paths: DSP, statistics, spectral, then
+ *			latest sample, block subscribers and ring
+ *	@param[in]	psXYZ - consecutive raw samples, oldest first. Processed in place
+ *	@return	number of samples left in psXYZ after processing
+ */
+size_t lis2hh12Deliver(lis2hh12_t * psDev, lis2hh12_xyz_t * psXYZ, size_t Count) {
+	if (psDev->Clk.IrqTS) lis2hh12HistAdd(&psDev->Inst.Hist[lis2hh12_hDATA], (u32_t) (lis2hh12TIME() - psDev->Clk.IrqTS));
+	u64_t Prev = (psDev->Clk.Last + 0x8000) >> 16;
+	u32_t Period;
+	u64_t TS = lis2hh12ClkStamp(psDev, Count, &Period);
+	if (psDev->WM.Pend) {									// overrun, lost samples from elapsed time
+		psDev->WM.Pend = 0;
+		u64_t First = TS - (u64_t) (Count - 1) * Period;
+		u32_t Span = (Prev && Period && First > Prev) ? (u32_t) ((First - Prev + Period / 2) / Period) : 0;
+		u32_t Lost = (Span > 1) ? Span - 1 : 1;				// at least the one overwritten
+		psDev->WM.Gap += Lost;
+		lis2hh12INST_ADD(psDev->Inst.Lost, Lost);
+		if (psDev->psDsp) lis2hh12DspReset(psDev->psDsp);	// filter history is not contiguous
+	}
+	if (psDev->psDsp) {
+		Count = lis2hh12DspRun(psDev->psDsp, psXYZ, Count);
+		TS -= (u64_t) psDev->psDsp->Phase * Period;		// inputs consumed since the last output
+		Period *= psDev->psDsp->Decim;
+	}
+	if (Count == 0)									return 0;
+	if (psDev->Start.FirstUS == 0 && psDev->Start.T0) psDev->Start.FirstUS = (u32_t) (lis2hh12TIME() - psDev->Start.T0);
+	u16_t Gap = 0;
+	if (psDev->WM.Gap) {									// in output samples if decimating
+		u32_t Decim = psDev->psDsp ? psDev->psDsp->Decim : 1;
+		u32_t Lost = (psDev->WM.Gap + Decim - 1) / Decim;
+		Gap = (Lost > 0xFFFF) ? 0xFFFF : Lost;
+		psDev->WM.Gap = 0;
+	}
+	if (psDev->psStat) lis2hh12StatFeed(psDev, psXYZ, Count, TS, Period, Gap);
+	if (psDev->psSpec) lis2hh12SpecFeed(psDev, psXYZ, Count);
+	if (psDev->psOrient && psDev->psOrient->IG == 0) lis2hh12OrientFeed(psDev, psXYZ, Count);
+	lis2hh12LatestPut(&psDev->Latest, &psXYZ[Count - 1], TS, psDev->Reg.STATUS, psDev->Reg.FIFO_SRC);
+	if (psDev->psPool) lis2hh12PoolPublish(psDev->psPool, psXYZ, Count, TS, Period, Gap);
+	lis2hh12RingPut(&psDev->Ring, psXYZ, Count, TS, Period, Gap);
+	return Count;
+}
+
 /**
  *	@brief	DRDY IRQ handling
  */
 void lis2hh12IntDRDY(void * Arg) {
 	lis2hh12_t * psDev = (lis2hh12_t *) Arg;
-	PX("(x%02X)  X=%hd  Y=%hd  Z=%hd" strNL, psDev->Reg.STATUS, psDev->Reg.i16OUT_X, psDev->Reg.i16OUT_Y, psDev->Reg.i16OUT_Z);
 	if (psDev->Reg.STATUS & 0x0F) {										// Data Available?
-		++lis2hh12IRQdrdy;
+		lis2hh12_xyz_t XYZ;
+		memcpy(&XYZ, psDev->Reg.u8OUT_X, sizeof(XYZ));
+		lis2hh12Deliver(psDev, &XYZ, 1);
+		lis2hh12INST_ADD(psDev->Inst.IRQdrdy, 1);
 	} else {
-		++lis2hh12IRQdrdyErr;
+		lis2hh12INST_ADD(psDev->Inst.IRQdrdyErr, 1);
 	}
 }
 
+/**
+ *	@brief	FIFO burst read completion, hand the block to the consumer and release the buffer
+ */
+void lis2hh12IntBLK(void * Arg) {
+	lis2hh12_t * psDev = (lis2hh12_t *) Arg;
+	lis2hh12INST_ADD(psDev->Inst.FIFOsamples, psDev->BlkCount);
+	u8_t Count = lis2hh12Deliver(psDev, psDev->psFill, psDev->BlkCount);
+	if (psDev->cbBlk && Count) psDev->cbBlk(psDev, psDev->psFill, Count);
+	if (psDev->psPool) {											// drop the drain's own reference
+		lis2hh12_blk_t * psB = lis2hh12PoolOwner(psDev->psPool, psDev->psFill);
+		if (psB) lis2hh12BlkRelease(psB);
+	}
+	psDev->BlkCount = 0;
+}
+
 /**
  *	@brief	FIFO IRQ handling
+ *	@note	In burst mode OUT_X_L..OUT_Z_H are read fss times in one transaction, with CTRL4
+ *			if_add_inc set the address wraps from OUT_Z_H back to OUT_X_L while the FIFO is enabled.
  */
 void lis2hh12IntFIFO(void * Arg) {
 	lis2hh12_t * psDev = (lis2hh12_t *) Arg;
-	lis2hh12ReportFIFO_SRC(NULL);
-	#define SO_FIFO_BLK (SO_MEM(lis2hh12_reg_t, i16OUT) + sizeof(lis2hh12_fifo_ctrl_t) + sizeof(lis2hh12_fifo_src_t))
-	volatile u8_t Count = psDev->Reg.fifo_src.fss;
-	while (Count) {
-		lis2hh12ReadRegs(lis2hh12OUT_X_L, &psDev->Reg.u8OUT_X[0], SO_FIFO_BLK);
-		Count = psDev->Reg.fifo_src.fss;
-		PX("#%d: X=%hd  Y=%hd  Z=%hd" strNL, Count, psDev->Reg.i16OUT_X, psDev->Reg.i16OUT_Y, psDev->Reg.i16OUT_Z);
+	lis2hh12INST_ADD(psDev->Inst.IRQfifo, 1);
+	u8_t Count = psDev->Reg.fifo_src.fss;
+	if (Count && psDev->psPool && lis2hh12PoolHold(psDev->psPool, Count)) {
+		psDev->Clk.RefIdx = 0;							// INTx edge not for the samples drained later
+		return;											// level INTx repeats until drained
+	}
+	if (psDev->psBlk) {
+		if (Count == 0 || psDev->BlkCount)			return;		// nothing to read or previous burst still busy
+		if (Count > psDev->BlkSize) Count = psDev->BlkSize;
+		lis2hh12_blk_t * psB = psDev->psPool ? lis2hh12PoolAlloc(psDev->psPool) : NULL;
+		psDev->psFill = psB ? psB->XYZ : psDev->psBlk;			// pool block is published without a copy
+		psDev->BlkCount = Count;
+		u8_t Reg = lis2hh12OUT_X_L;
+		lis2hh12INST_ADD(psDev->Inst.FIFOtrans, 1);
+		if (lis2hh12Queue(psDev, i2cWRC, &Reg, sizeof(Reg), (u8_t *) psDev->psFill, Count * sizeof(lis2hh12_xyz_t), (i2cq_p1_t) lis2hh12IntBLK, (i2cq_p2_t) Arg) < erSUCCESS) {
+			if (psB) lis2hh12BlkRelease(psB);
+			psDev->BlkCount = 0;
+		}
+		return;
+	}
+	while (Count--) {									// no block buffer, one sample per transaction
+		lis2hh12_xyz_t XYZ;
+		lis2hh12INST_ADD(psDev->Inst.FIFOtrans, 1);
+		if (lis2hh12ReadRegs(psDev, lis2hh12OUT_X_L, (u8_t *) &XYZ, sizeof(XYZ)) < erSUCCESS) break;
+		lis2hh12INST_ADD(psDev->Inst.FIFOsamples, 1);
+		lis2hh12Deliver(psDev, &XYZ, 1);
 	}
-	++lis2hh12IRQfifo;
 }
 
 /**
  *	@brief	IG1 IRQ handling
  */
-void lis2hh12IntIG1(void * Arg) { ++lis2hh12IRQig1; }
+void lis2hh12IntIG1(void * Arg) {
+	lis2hh12_t * psDev = (lis2hh12_t *) Arg;
+	lis2hh12INST_ADD(psDev->Inst.IRQig1, 1);
+	if (psDev->psOrient) lis2hh12OrientEvent(psDev, 1, psDev->Reg.IG_SRC1);
+}
 
 /**
  *	@brief	IG2 IRQ handling
  */
-void lis2hh12IntIG2(void * Arg) { ++lis2hh12IRQig2; }
+void lis2hh12IntIG2(void * Arg) {
+	lis2hh12_t * psDev = (lis2hh12_t *) Arg;
+	lis2hh12INST_ADD(psDev->Inst.IRQig2, 1);
+	if (psDev->psOrient) lis2hh12OrientEvent(psDev, 2, psDev->Reg.IG_SRC2);
+}
 
 /**
- * @brief		Stage 1 CTRLx/INTx decoder handler (not running in ISR level)
+ * @brief		Stage 1 INTx decoder, dispatches all sources from the single STATUS..IG_SRC2 snapshot
  * @param[in]	pointer to device config/status structure
- * 
+ * @note		running in I2C task context, CTRL3/CTRL6 from shadow as written by the driver
  */
 void IRAM_ATTR lis2hh12IRQ_1(void * Arg) {
-	u8_t Reg = 0;
 	lis2hh12_t * psDev = (lis2hh12_t *) Arg;
-	if (psDev->Reg.ctrl3.int1_drdy || psDev->Reg.ctrl6.int2_drdy) {			// DRDY on INTx enabled?
-		Reg = lis2hh12STATUS;
-		halI2C_Queue(psDev->psI2C, i2cWRC, &Reg, sizeof(Reg), &psDev->Reg.STATUS, SO_MEM(lis2hh12_reg_t, STATUS)+SO_MEM(lis2hh12_reg_t, i16OUT), (i2cq_p1_t) lis2hh12IntDRDY, (i2cq_p2_t) Arg);
-	}
-	if ((psDev->Reg.ctrl3.int1_fth && psDev->Reg.ctrl6.int2_fth) ||			// FIFO threshold on INTx?
-		(psDev->Reg.ctrl3.int1_ovr || psDev->Reg.ctrl6.int2_empty)) {		// FIFO overflow on INT1 or empty on INT2?
-		Reg = lis2hh12FIFO_SRC;
-		halI2C_Queue(psDev->psI2C, i2cWRC, &Reg, sizeof(Reg), &psDev->Reg.FIFO_SRC, SO_MEM(lis2hh12_reg_t, FIFO_SRC), (i2cq_p1_t)lis2hh12IntFIFO, (i2cq_p2_t) Arg);
+	u32_t Cyc = esp_cpu_get_cycle_count();
+	lis2hh12HistAdd(&psDev->Inst.Hist[lis2hh12_hBUS], (u32_t) (lis2hh12TIME() - psDev->Clk.IrqTS));
+	#define SNAP(r)	psDev->Snap[(r) - lis2hh12STATUS]
+	u8_t Found = 0;
+	if (psDev->SnapReg == lis2hh12STATUS)					// STATUS & OUT_x only read if FIFO not active
+		memcpy(&psDev->Reg.STATUS, &SNAP(lis2hh12STATUS), lis2hh12OUT_Z_H - lis2hh12STATUS + 1);
+	psDev->Reg.FIFO_SRC = SNAP(lis2hh12FIFO_SRC);
+	psDev->Reg.IG_SRC1 = SNAP(lis2hh12IG_SRC1);
+	psDev->Reg.IG_SRC2 = SNAP(lis2hh12IG_SRC2);
+	if (psDev->SnapReg == lis2hh12STATUS) {
+		if (psDev->Reg.ctrl3.int1_drdy || psDev->Reg.ctrl6.int2_drdy) {		// DRDY on INTx enabled?
+			if (psDev->Reg.status.ZYXor) {									// previous sample overwritten unread
+				psDev->WM.Pend = psDev->WM.Ovr = 1;
+				lis2hh12INST_ADD(psDev->Inst.Overrun, 1);
+			}
+			lis2hh12ClkRef(psDev, 1);
+			lis2hh12IntDRDY(Arg);
+			Found |= psDev->Reg.status.ZYXda;
+		}
+	} else if (psDev->Reg.fifo_src.fss || psDev->Reg.fifo_src.ovr) {		// FIFO data available?
+		u8_t FTH = psDev->Reg.fifo_ctrl.fth;
+		lis2hh12INST_ADD(psDev->Inst.Fill[psDev->Reg.fifo_src.ovr ? lis2hh12FIFO_DEPTH : psDev->Reg.fifo_src.fss], 1);
+		if (psDev->Reg.fifo_src.ovr) {
+			psDev->Clk.Next = 0;										// samples lost, relock
+			psDev->WM.Pend = psDev->WM.Ovr = 1;
+			lis2hh12INST_ADD(psDev->Inst.Overrun, 1);
+		} else if (FTH && psDev->Reg.fifo_src.fth && psDev->Reg.fifo_src.fss >= FTH && psDev->BlkCount == 0 &&
+				(psDev->Reg.ctrl3.int1_fth || psDev->Reg.ctrl6.int2_fth)) {
+			lis2hh12ClkRef(psDev, FTH);									// INTx edge as count reached FTH
+		}
+		u8_t Lag = psDev->Reg.fifo_src.ovr ? lis2hh12FIFO_DEPTH : (FTH && psDev->Reg.fifo_src.fss > FTH) ? psDev->Reg.fifo_src.fss - FTH : 0;
+		if (Lag > psDev->WM.Lag) psDev->WM.Lag = Lag;					// service latency in samples
+		lis2hh12IntFIFO(Arg);
+		Found = 1;
 	}
-	if (psDev->Reg.ctrl3.int1_ig1 || psDev->Reg.ctrl6.int2_ig1) {
-		Reg = lis2hh12IG_SRC1;
-		halI2C_Queue(psDev->psI2C, i2cWRC, &Reg, sizeof(Reg), &psDev->Reg.IG_SRC1, SO_MEM(lis2hh12_reg_t, IG_SRC1), (i2cq_p1_t)lis2hh12IntIG1, (i2cq_p2_t) Arg);
+	if (psDev->Reg.ig_src1.ia && (psDev->Reg.ctrl3.int1_ig1 || psDev->Reg.ctrl6.int2_ig1)) {
+		lis2hh12IntIG1(Arg);
+		Found = 1;
 	}
-	if (psDev->Reg.ctrl3.int1_ig2 || psDev->Reg.ctrl6.int2_ig2) {
-		Reg = lis2hh12IG_SRC2;
-		halI2C_Queue(psDev->psI2C, i2cWRC, &Reg, sizeof(Reg), &psDev->Reg.IG_SRC2, SO_MEM(lis2hh12_reg_t, IG_SRC2), (i2cq_p1_t)lis2hh12IntIG2, (i2cq_p2_t) Arg);
+	if (psDev->Reg.ig_src2.ia && (psDev->Reg.ctrl3.int1_ig2 || psDev->Reg.ctrl6.int2_ig2)) {
+		lis2hh12IntIG2(Arg);
+		Found = 1;
 	}
-	if (psDev->Reg.ctrl3.int1_inact) {										// INACT on INT1 enabled
-		Reg = 1;															// only used for counter below....
-		++lis2hh12IRQinact;
+	if (Found == 0) {												// INACT & BOOT have no status bit, only by elimination
+		if (psDev->Reg.ctrl3.int1_inact) lis2hh12INST_ADD(psDev->Inst.IRQinact, 1);
+		if (psDev->Reg.ctrl6.int2_boot) lis2hh12INST_ADD(psDev->Inst.IRQboot, 1);
 	}
-	if (psDev->Reg.ctrl6.int2_boot) {										// BOOT on INT2 enabled
-		Reg = 1;															// only used for counter below....
-		++lis2hh12IRQboot;
-	}
-	if (Reg) ++lis2hh12IRQok; else ++lis2hh12IRQlost;
+	if (Found) lis2hh12INST_ADD(psDev->Inst.IRQok, 1);
+	else lis2hh12INST_ADD(psDev->Inst.IRQlost, 1);
+	lis2hh12HistAdd(&psDev->Inst.Hist[lis2hh12_hIRQ1], esp_cpu_get_cycle_count() - Cyc);
+	#undef SNAP
 }
 
 /**
- * @brief		Stage 0 INTx CTRLx IRQ handler
+ * @brief		Stage 0 INTx IRQ handler, queue a single burst read of STATUS..IG_SRC2
  * @param[in]	pointer to device config/status structure
- * @note		
+ * @note		with the FIFO active the burst starts at FIFO_SRC since reading OUT_x pops a FIFO entry
  */
 void IRAM_ATTR lis2hh12IRQ_0(void * Arg) {
 	#define pcf8574REQ_TASKS	(taskI2C_MASK)
+	lis2hh12_t * psDev = (lis2hh12_t *) Arg;
+	u32_t Cyc = esp_cpu_get_cycle_count();
+	psDev->Clk.IrqTS = lis2hh12TIME();
 	EventBits_t xEBrun = xEventGroupGetBitsFromISR(TaskRunState);
-	if ((xEBrun & pcf8574REQ_TASKS) != pcf8574REQ_TASKS) {
-		++lis2hh12IRQlost;
+	if (psDev->psBus == &lis2hh12BusI2C && (xEBrun & pcf8574REQ_TASKS) != pcf8574REQ_TASKS) {	// I2C task not running
+		lis2hh12INST_ADD(psDev->Inst.IRQlost, 1);
 		return;
 	}
-	lis2hh12_t * psDev = (lis2hh12_t *) Arg;
-	u8_t Reg = lis2hh12CTRL3;
-	int iRV1 = halI2C_Queue(psDev->psI2C, i2cWR, &Reg, sizeof(Reg), &psDev->Reg.CTRL3, SO_MEM(lis2hh12_reg_t, CTRL3), (i2cq_p1_t) NULL, (i2cq_p2_t) NULL);
-	Reg = lis2hh12CTRL6;
-	int iRV2 = halI2C_Queue(psDev->psI2C, i2cWRC, &Reg, sizeof(Reg), &psDev->Reg.CTRL6, SO_MEM(lis2hh12_reg_t, CTRL6), (i2cq_p1_t)lis2hh12IRQ_1, (i2cq_p2_t) Arg);
-	if (iRV1 == pdTRUE || iRV2 == pdTRUE) portYIELD_FROM_ISR();
+	u8_t Reg = (psDev->Reg.ctrl3.fifo_en && psDev->Reg.fifo_ctrl.fmode != fmBYPASS) ? lis2hh12FIFO_SRC : lis2hh12STATUS;
+	psDev->SnapReg = Reg;
+	int iRV = lis2hh12Queue(psDev, i2cWRC, &Reg, sizeof(Reg), &psDev->Snap[Reg - lis2hh12STATUS], lis2hh12IG_SRC2 - Reg + 1, (i2cq_p1_t)lis2hh12IRQ_1, (i2cq_p2_t) Arg);
+	lis2hh12HistAdd(&psDev->Inst.Hist[lis2hh12_hIRQ0], esp_cpu_get_cycle_count() - Cyc);
+	if (iRV == pdTRUE) portYIELD_FROM_ISR();
 }
 
 // ################### Identification, Diagnostics & Configuration functions #######################
 
-void test(int i) {
-	lis2hh12ReadRegs(lis2hh12FIFO_CTRL, &sLIS2HH12.Reg.FIFO_CTRL, 1);
-	PX("i=%d\tFIFO_CTRL=x%02X" strNL, i, sLIS2HH12.Reg.FIFO_CTRL);
+void test(lis2hh12_t * psDev, int i) {
+	lis2hh12ReadRegs(psDev, lis2hh12FIFO_CTRL, &psDev->Reg.FIFO_CTRL, 1);
+	PX("i=%d\tFIFO_CTRL=x%02X" strNL, i, psDev->Reg.FIFO_CTRL);
+}
+
+/**
+ * @brief		find the device handle associated with an I2C device
+ * @return		pointer to device handle or NULL if not (yet) identified
+ */
+lis2hh12_t * lis2hh12GetDev(i2c_di_t * psI2C) {
+	for (int i = 0; i < lis2hh12Num; ++i) {
+		if (sLIS2HH12[i].psI2C == psI2C)			return &sLIS2HH12[i];
+	}
+	return NULL;
 }
 
 /**
  * device reset+register reads to ascertain exact device type
+ * @param	psI2C - device descriptor, the device key (and I2C transport handle) whatever the transport
+ * @param	psBus/pvBus - transport and its handle, e.g. &lis2hh12BusSPI & spi_device_handle_t
  * @return	erSUCCESS if supported device was detected, if not erFAILURE
+ * @note	a device handle is only claimed once the WHO_AM_I check passed
+ * @note	warm start (lis2hh12WARM): a device that stayed powered, e.g. through MCU deep sleep, and
+ * 			still holds lis2hh12Profile is neither rebooted nor reconfigured by lis2hh12Config()
  */
-int	lis2hh12Identify(i2c_di_t * psI2C) {
-	sLIS2HH12.psI2C = psI2C;
+int	lis2hh12IdentifyBus(i2c_di_t * psI2C, const lis2hh12_bus_t * psBus, void * pvBus) {
+	if (psBus == NULL || psBus->Queue == NULL)		return erINV_PARA;
+	lis2hh12_t * psDev = lis2hh12GetDev(psI2C);
+	if (psDev == NULL) {
+		if (lis2hh12Num == lis2hh12MAX_DEV)			return erFAILURE;
+		psDev = &sLIS2HH12[lis2hh12Num];
+		memset(psDev, 0, sizeof(lis2hh12_t));
+		psDev->ScaleFS = 0xFF;
+		psDev->IRQpin = lis2hh12IRQpin[lis2hh12Num];
+		psDev->Ring.psAge = &psDev->Inst.Hist[lis2hh12_hPOP];
+	}
+	psDev->psI2C = psI2C;
+	psDev->psBus = psBus;
+	psDev->pvBus = pvBus;
+#if (lis2hh12SIM > 0)
+	psDev->psSim = lis2hh12SimAttach(psDev);
+	if (psDev->psSim && psBus == &lis2hh12BusI2C) psDev->psBus = &lis2hh12BusSim;	// other transports reach the model via their HAL
+#endif
 	psI2C->Type = i2cDEV_LIS2HH12;
 	psI2C->Speed = i2cSPEED_400;
 	psI2C->TObus = 25;
 	psI2C->Test = 1;
+	memset(&psDev->Start, 0, sizeof(lis2hh12_start_t));
+	psDev->Start.T0 = lis2hh12TIME();
 	u8_t U8;
-	int iRV = lis2hh12WriteReg(lis2hh12CTRL6, NULL, 0x80);	// REBOOT
-	if (iRV < erSUCCESS)							return iRV;
-	vTaskDelay(pdMS_TO_TICKS(30));
-//	int iRV = lis2hh12WriteReg(lis2hh12CTRL5, NULL, 0x40);	// SOFT RESET
-	iRV = lis2hh12ReadRegs(lis2hh12WHO_AM_I, &U8, sizeof(U8));
+	int iRV = lis2hh12ReadRegs(psDev, lis2hh12WHO_AM_I, &U8, sizeof(U8));
 	if (iRV < erSUCCESS)							return iRV;
 	if (U8 != lis2hh12WHOAMI_NUM)					return erINV_WHOAMI;
+#if (lis2hh12WARM > 0)
+	if (lis2hh12VerifyCfg(psDev, lis2hh12Profile) == erSUCCESS) {	// 2 bursts, OUT_x skipped
+		lis2hh12ShadowCfg(psDev, lis2hh12Profile);
+		psDev->Start.Warm = 1;
+	} else
+#endif
+	{
+		iRV = lis2hh12Reboot(psDev);
+//		int iRV = lis2hh12WriteReg(psDev, lis2hh12CTRL5, NULL, 0x40);	// SOFT RESET
+		if (iRV < erSUCCESS)						return iRV;
+		if (psBus->CTRL4) {								// boot re-enabled I2C, off before any further SPI traffic
+			iRV = lis2hh12ModifyReg(psDev, lis2hh12CTRL4, &psDev->Reg.CTRL4, 0xFF, psBus->CTRL4);
+			if (iRV < erSUCCESS)					return iRV;
+		}
+	}
+	if (psDev == &sLIS2HH12[lis2hh12Num]) ++lis2hh12Num;
 	psI2C->IDok = 1;
 	psI2C->Test = 0;
+	psDev->Start.IdentUS = (u32_t) (lis2hh12TIME() - psDev->Start.T0);
 	return iRV;
 }
 
+int	lis2hh12Identify(i2c_di_t * psI2C) { return lis2hh12IdentifyBus(psI2C, &lis2hh12BusI2C, psI2C); }
+
 int	lis2hh12Config(i2c_di_t * psI2C) {
-	if (psI2C->IDok == 0) return erINV_STATE;
+	lis2hh12_t * psDev = lis2hh12GetDev(psI2C);
+	if (psI2C->IDok == 0 || psDev == NULL) return erINV_STATE;
 	psI2C->CFGok = 0;
-#if (0)
-	// x80=HR	x70=ODR		x08=BDU		x04=Zen		x02=Yen		x01=Xen
-	int iRV = lis2hh12WriteReg(lis2hh12CTRL1, &sLIS2HH12.Reg.CTRL1, makeCTRL1(0,1,1,1,1,1));
-	if (iRV < erSUCCESS) goto exit;
-
-	//	x80=RSVD	x60=DFC		x18=HPM		x04=FDS		x02=HPIS1	x01=HPIS2
-	iRV = lis2hh12WriteReg(lis2hh12CTRL2, &sLIS2HH12.Reg.CTRL2, makeCTRL2(0,0,0,0,0));
-	if (iRV < erSUCCESS) goto exit;
-
-	//	0x80=Fen	x40=STOP	x20=INACT	x10=IG2		x08=IG1		x04=OVR		x02=FTH		x01=DRDY
-	iRV = lis2hh12WriteReg(lis2hh12CTRL3, &sLIS2HH12.Reg.CTRL3, makeCTRL3(1,0,1,1,1,1,1,1));
-	if (iRV < erSUCCESS) goto exit;
-
-	//	xC0=BW		x30=FS		x08=BWman	x04=INCR	x02=I2Cdis	x01=SIM
-	iRV = lis2hh12WriteReg(lis2hh12CTRL4, &sLIS2HH12.Reg.CTRL4, makeCTRL4(0,0,0,1,0,0));
-	if (iRV < erSUCCESS) goto exit;
-
-	//	x80=DGB		x40=RST		x30=DEC		x0C=TST		x02=HLact	x01=ODen
-	iRV = lis2hh12WriteReg(lis2hh12CTRL5, &sLIS2HH12.Reg.CTRL5, makeCTRL5(0,0,0,0,1,1));
-	if (iRV < erSUCCESS) goto exit;
-
-	//	x80=BOOT	x40=RSVD	x20=I1Boot	x10=I2IG2	x08=I2IG1	x04=I2EMPTY	x02=I2FTH	x01=I2DRDY
-	iRV = lis2hh12WriteReg(lis2hh12CTRL6, &sLIS2HH12.Reg.CTRL6, makeCTRL6(0,1,1,1,1,1,1));
-	if (iRV < erSUCCESS) goto exit;
-
-	//	xC0=RSVD	x20=I2DCRM	x10=I1DCRM	x08=I2LIR	x04=I1LIR	x02=I2_4D	x01=I1_4D
-	iRV = lis2hh12WriteReg(lis2hh12CTRL7, &sLIS2HH12.Reg.CTRL7, makeCTRL7(0,0,0,0,0,0));
-	if (iRV < erSUCCESS) goto exit;
-
-	//	xE0=FMode	x1F=FTH
-	iRV = lis2hh12WriteReg(lis2hh12FIFO_CTRL, &sLIS2HH12.Reg.FIFO_CTRL, makeFIFOC(fmSTREAM,8));
-	if (iRV < erSUCCESS) goto exit;
-
-	//	x80=AOI		x40=D6		x20=ZH		x10=ZL		x08=YH		x04=YL		x02=XH		x01=XL
-	iRV = lis2hh12WriteReg(lis2hh12IG_CFG1, &sLIS2HH12.Reg.IG_CFG1, makeIGxCFG(0,0,1,1,1,1,1,1));
-	if (iRV < erSUCCESS) goto exit;
-	iRV = lis2hh12WriteReg(lis2hh12IG_CFG2, &sLIS2HH12.Reg.IG_CFG2, makeIGxCFG(0,0,0,0,0,0,0,0));
-	if (iRV < erSUCCESS) goto exit;
-#elif (1)
-	//	xC0=BW		x30=FS		x08=BWman	x04=INCR	x02=I2Cdis	x01=SIM
-	int iRV = lis2hh12WriteReg(lis2hh12CTRL4, &sLIS2HH12.Reg.CTRL4, makeCTRL4(0,0,0,1,0,0));
-	if (iRV < erSUCCESS) goto exit;
-
-#endif
+	int iRV = erSUCCESS;
+	u8_t Warm = psDev->Start.Warm;
+	psDev->Start.Warm = 0;								// once only, any later call reapplies the profile
+	if (Warm == 0) {									// else verified by lis2hh12Identify()
+		iRV = lis2hh12ApplyCfg(psDev, lis2hh12Profile);
+		if (iRV < erSUCCESS) goto exit;
+		iRV = lis2hh12VerifyCfg(psDev, lis2hh12Profile);
+		if (iRV < erSUCCESS) goto exit;
+	}
 	psI2C->CFGok = 1;
-	if (psI2C->CFGerr == 0) {
+	psDev->Start.ConfigUS = (u32_t) (lis2hh12TIME() - psDev->Start.T0);
+	if (psI2C->CFGerr == 0 && psDev->IRQpin >= 0) {
 		const gpio_config_t irq_pin_cfg = {
-			.pin_bit_mask = (1ULL << lis2hh12IRQ_PIN), .mode = GPIO_MODE_INPUT,
+			.pin_bit_mask = (1ULL << psDev->IRQpin), .mode = GPIO_MODE_INPUT,
 			.pull_up_en = GPIO_PULLUP_ENABLE, .pull_down_en = GPIO_PULLDOWN_DISABLE, .intr_type = GPIO_INTR_LOW_LEVEL,
 		};
 		ESP_ERROR_CHECK(gpio_config(&irq_pin_cfg));
-		halGPIO_IRQconfig(lis2hh12IRQ_PIN, lis2hh12IRQ_0, &sLIS2HH12);
+		halGPIO_IRQconfig(psDev->IRQpin, lis2hh12IRQ_0, psDev);
 	}
 exit:
 	if (iRV < erSUCCESS) SL_ERROR(iRV);
 	return iRV;
 }
 
-int	lis2hh12Diags(i2c_di_t * psI2C) { return erSUCCESS; }
+/**
+ * @brief		self test, result kept in the device handle for reporting
+ * @return		erSUCCESS if passed, erFAILURE if not, else erINV_STATE or bus error code
+ */
+int	lis2hh12Diags(i2c_di_t * psI2C) {
+	lis2hh12_t * psDev = lis2hh12GetDev(psI2C);
+	if (psI2C->IDok == 0 || psDev == NULL)			return erINV_STATE;
+	return lis2hh12SelfTest(psDev, &psDev->ST);
+}
 
 // ######################################### Reporting #############################################
 
-int lis2hh12ReportAll(report_t * psR) {
-	int iRV = halI2C_DeviceReport(psR, sLIS2HH12.psI2C);
-	iRV += lis2hh12ReportTEMP(psR);
-
-	iRV += lis2hh12ReportActDur(psR);
-	iRV += lis2hh12ReportActThr(psR);
-
-	iRV += li2hh12ReportCTRL1(psR);
-	iRV += li2hh12ReportCTRL2(psR);
-	iRV += li2hh12ReportCTRL3(psR);
-	iRV += li2hh12ReportCTRL4(psR);
-	iRV += li2hh12ReportCTRL5(psR);
-	iRV += li2hh12ReportCTRL6(psR);
-	iRV += li2hh12ReportCTRL7(psR);
-
-	iRV += li2hh12ReportSTATUS(psR);
-
-	iRV += lis2hh12ReportOUTxyz(psR);
-	iRV += lis2hh12ReportREFxyz(psR);
-
-	iRV += lis2hh12ReportFIFO_CTRL(psR);
-	iRV += lis2hh12ReportFIFO_SRC(psR);
+int lis2hh12ReportDev(report_t * psR, lis2hh12_t * psDev) {
+	int iRV = halI2C_DeviceReport(psR, psDev->psI2C);
+	iRV += lis2hh12ReportTEMP(psR, psDev);
+
+	iRV += lis2hh12ReportActDur(psR, psDev);
+	iRV += lis2hh12ReportActThr(psR, psDev);
+
+	iRV += li2hh12ReportCTRL1(psR, psDev);
+	iRV += li2hh12ReportCTRL2(psR, psDev);
+	iRV += li2hh12ReportCTRL3(psR, psDev);
+	iRV += li2hh12ReportCTRL4(psR, psDev);
+	iRV += li2hh12ReportCTRL5(psR, psDev);
+	iRV += li2hh12ReportCTRL6(psR, psDev);
+	iRV += li2hh12ReportCTRL7(psR, psDev);
+
+	iRV += li2hh12ReportSTATUS(psR, psDev);
+
+	iRV += lis2hh12ReportOUTxyz(psR, psDev);
+	iRV += lis2hh12ReportREFxyz(psR, psDev);
+
+	iRV += lis2hh12ReportFIFO_CTRL(psR, psDev);
+	iRV += lis2hh12ReportFIFO_SRC(psR, psDev);
+
+	iRV += lis2hh12ReportIGx(psR, psDev, 0);
+	iRV += lis2hh12ReportIGx(psR, psDev, 1);
+	iRV += lis2hh12ReportCounters(psR, psDev);
+	if (psDev->psDsp) iRV += lis2hh12ReportDsp(psR, psDev->psDsp);
+	if (psDev->psSpec) iRV += lis2hh12ReportSpec(psR, psDev->psSpec);
+	if (psDev->psPm) iRV += lis2hh12ReportPm(psR, psDev->psPm);
+	if (psDev->psPool) iRV += lis2hh12ReportPool(psR, psDev->psPool);
+	if (psDev->ST.Done) iRV += lis2hh12ReportSelfTest(psR, &psDev->ST);
+	if (psDev->psCal) iRV += lis2hh12ReportCal(psR, psDev->psCal);
+	if (psDev->psOrient) iRV += lis2hh12ReportOrient(psR, psDev->psOrient);
+	return iRV;
+}
 
-	iRV += lis2hh12ReportIGx(psR, 0);
-	iRV += lis2hh12ReportIGx(psR, 1);
-	iRV += lis2hh12ReportCounters(psR);
+int lis2hh12ReportAll(report_t * psR) {
+	int iRV = 0;
+	for (int i = 0; i < lis2hh12Num; ++i) iRV += lis2hh12ReportDev(psR, &sLIS2HH12[i]);
 	return iRV;
 }
 #endif
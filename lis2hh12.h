@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include "lis2hh12_codec.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -10,6 +12,114 @@ extern "C" {
 
 #define lis2hh12ADDR				0x1E				// 0x1C -> 0x1F selectable
 #define lis2hh12WHOAMI_NUM			0x41
+#define lis2hh12FIFO_DEPTH			32
+
+#ifndef lis2hh12MAX_DEV
+	#define lis2hh12MAX_DEV			1					// 0x1C -> 0x1F on each I2C bus
+#endif
+
+#ifndef lis2hh12IRQ_PINS
+	#define lis2hh12IRQ_PINS		{ lis2hh12IRQ_PIN }	// INT pin per device, -1 = none, lis2hh12MAX_DEV entries
+#endif
+
+#ifndef lis2hh12SIM
+	#define lis2hh12SIM				0					// 1 = register level chip model on the bus
+#endif
+
+#if (lis2hh12SIM > 0)
+	extern u64_t lis2hh12SimNow;						// model time while replaying, 0 = real time
+	#define lis2hh12TIME()			(lis2hh12SimNow ? lis2hh12SimNow : (u64_t) esp_timer_get_time())
+#else
+	#define lis2hh12TIME()			((u64_t) esp_timer_get_time())
+#endif
+
+#ifndef lis2hh12SPI
+	#define lis2hh12SPI				0					// 1 = 4 wire SPI transport (ESP-IDF spi_master)
+#endif
+
+#ifndef lis2hh12SPI_HZ
+	#define lis2hh12SPI_HZ			10000000			// SPI clock the device was added with, 10MHz max
+#endif
+
+#ifndef lis2hh12DSP_BIQUADS
+	#define lis2hh12DSP_BIQUADS		4					// max cascaded biquads per device
+#endif
+
+#ifndef lis2hh12SPEC_NMAX
+	#define lis2hh12SPEC_NMAX		256					// max FFT/Goertzel block, power of 2
+#endif
+
+#ifndef lis2hh12SPEC_RES
+	#define lis2hh12SPEC_RES		4					// target bin width in Hz used to select N from ODR
+#endif
+
+#ifndef lis2hh12SPEC_BINS
+	#define lis2hh12SPEC_BINS		8					// max Goertzel frequencies
+#endif
+
+#ifndef lis2hh12CLK_KP
+	#define lis2hh12CLK_KP			2					// phase correction 1/2^KP of error per reference
+#endif
+
+#ifndef lis2hh12CLK_KI
+	#define lis2hh12CLK_KI			3					// period correction 1/2^KI of error/sample per reference
+#endif
+
+#ifndef lis2hh12HIST_BINS
+	#define lis2hh12HIST_BINS		20					// log2 buckets, last one catches everything larger
+#endif
+
+#ifndef lis2hh12RING_SIZE
+	#define lis2hh12RING_SIZE		128					// samples, must be a power of 2
+#endif
+
+#ifndef lis2hh12POOL_SUBS
+	#define lis2hh12POOL_SUBS		3					// subscribers per pool
+#endif
+
+#ifndef lis2hh12SUB_DEPTH
+	#define lis2hh12SUB_DEPTH		4					// blocks queued per subscriber, must be a power of 2
+#endif
+
+#ifndef lis2hh12POOL_BLOCKS								// FIFO_DEPTH samples each, all queues full + filling + spare
+	#define lis2hh12POOL_BLOCKS		(lis2hh12POOL_SUBS * lis2hh12SUB_DEPTH + 2)
+#endif
+
+#ifndef lis2hh12WM_CLEAN
+	#define lis2hh12WM_CLEAN		10					// clean adaptation windows before probing a deeper FTH
+#endif
+
+#ifndef lis2hh12WARM
+	#define lis2hh12WARM			1					// 1 = skip reboot & reconfigure if the device still holds the profile
+#endif
+
+#ifndef lis2hh12BOOT_MS
+	#define lis2hh12BOOT_MS			30					// BOOT completion timeout, CTRL6 boot bit polled
+#endif
+
+#ifndef lis2hh12ST_SAMPLES
+	#define lis2hh12ST_SAMPLES		16					// self test samples averaged per phase
+#endif
+
+#ifndef lis2hh12ST_DISCARD
+	#define lis2hh12ST_DISCARD		8					// self test settling samples skipped per phase
+#endif
+
+#ifndef lis2hh12ST_MIN_MG
+	#define lis2hh12ST_MIN_MG		70					// self test output change limits, datasheet Vst
+#endif
+
+#ifndef lis2hh12ST_MAX_MG
+	#define lis2hh12ST_MAX_MG		1500
+#endif
+
+#ifndef lis2hh12SEQ_TRIES
+	#define lis2hh12SEQ_TRIES		8					// latest sample read attempts before giving up
+#endif
+
+#define lis2hh12INST_ADD(c, n)		__atomic_fetch_add(&(c), (n), __ATOMIC_RELAXED)	// Inst counter, ISR/I2C task/reset safe
+
+#define lis2hh12REG_IDX(r)			((r) < lis2hh12ACT_THS ? (r) - lis2hh12TEMP_L : (r) - lis2hh12ACT_THS + 2)	// Regs[] index
 
 #define	makeCTRL1(HR,ODR,BDU,Zen,Yen,Xen)										\
 	(((HR&1)<<7) | ((ODR&7)<<4) | ((BDU&1)<<3) | ((Zen&1)<<2) |	((Yen&1)<<1) | (Xen&1))
@@ -33,7 +143,7 @@ extern "C" {
 	(((I2DCRM&1)<<5) | ((I1DCRM&1)<<4) | ((I2LIR&1)<<3) | ((I1LIR&1)<<2) | ((I2_4D&1)<<1) | ((I1_4D&1)))
 
 #define	makeFIFOC(FMode,FTH)													\
-	(((FMode&7)<<4) | (FTH&31))
+	(((FMode&7)<<5) | (FTH&31))
 
 #define	makeIGxCFG(AOI,D6,ZH,ZL,YH,YL,XH,XL)									\
 	(((AOI&1)<<7) | ((D6&1)<<6) | ((ZH&1)<<5) | ((ZL&1)<<4) | ((YH&1)<<3) | ((YL&1)<<2) | ((XH&1)<<1) | (XL&1))
@@ -299,35 +409,577 @@ typedef union __attribute__((packed)) lis2hh12_reg_t {	// REGS
 } lis2hh12_reg_t;
 DUMB_STATIC_ASSERT(sizeof(lis2hh12_reg_t) == 36);
 
+typedef struct __attribute__((packed)) {				// configuration profile, see makeXXX() macros
+	u8_t ACT_THS;					// x1E
+	u8_t ACT_DUR;					// x1F
+	u8_t CTRL[7];					// x20-26 CTRL1..CTRL7
+	u8_t FIFO_CTRL;					// x2E
+	u8_t IG_CFG1;					// x30
+	u8_t IG_THS1[3];				// x32-34 X/Y/Z
+	u8_t IG_DUR1;					// x35
+	u8_t IG_CFG2;					// x36
+	u8_t IG_THS2;					// x38
+	u8_t IG_DUR2;					// x39
+} lis2hh12_cfg_t;
+DUMB_STATIC_ASSERT(sizeof(lis2hh12_cfg_t) == 18);
+
+DUMB_STATIC_ASSERT((lis2hh12RING_SIZE & (lis2hh12RING_SIZE - 1)) == 0);
+
+typedef struct {						// newest sample, sequence lock with a single writer (I2C callbacks)
+	u32_t Seq;						// odd while being written, Seq/2 = samples published
+	u8_t STATUS;					// as read with the sample (DRDY path)
+	u8_t FIFO_SRC;					// as read with the sample (FIFO paths)
+	lis2hh12_xyz_t XYZ;
+	u64_t TS;						// sample time in uSec
+} lis2hh12_latest_t;
+
+typedef struct {						// pool block, read only for subscribers once published
+	u32_t Ref;						// references held, 0 = free
+	u8_t Count;						// samples in XYZ[]
+	u16_t Gap;						// samples lost immediately before XYZ[0]
+	u32_t Period;					// sample period in uSec
+	u64_t TS;						// time of the newest sample in uSec
+	lis2hh12_xyz_t XYZ[lis2hh12FIFO_DEPTH];
+} lis2hh12_blk_t;
+
+typedef enum {
+	lis2hh12_subDROP_OLDEST,		// discard the oldest queued block to make space
+	lis2hh12_subDROP_NEWEST,		// discard the block being published
+	lis2hh12_subBLOCK,				// hold FIFO bursts in the sensor until queued, drop newest if it would overrun
+} lis2hh12_sub_policy_t;
+
+typedef struct {						// per subscriber block queue, producer pushes, consumer & drop oldest pop
+	lis2hh12_blk_t * Q[lis2hh12SUB_DEPTH];
+	u32_t Head, Tail;				// free running
+	void * xTask;					// notified (xTaskNotifyGive) on every push, NULL = poll
+	u8_t Active;					// 0 = free, 1 = receiving, 2 = being (un)subscribed
+	u8_t Policy;					// lis2hh12_sub_policy_t
+	u16_t Busy;						// publishers past the Active check, lis2hh12Unsubscribe() waits for 0
+	u32_t Pushed, DropOld, DropNew, Stalls, HiWater;
+} lis2hh12_sub_t;
+
+typedef struct {						// static block pool fanned out by reference to all subscribers
+	lis2hh12_blk_t Blk[lis2hh12POOL_BLOCKS];
+	lis2hh12_sub_t Sub[lis2hh12POOL_SUBS];
+	u8_t Next;						// allocation scan start
+	u32_t Published, Copied, NoBlock;
+} lis2hh12_pool_t;
+DUMB_STATIC_ASSERT((lis2hh12SUB_DEPTH & (lis2hh12SUB_DEPTH - 1)) == 0);
+
+typedef enum { lis2hh12_bqLOPASS, lis2hh12_bqHIPASS, lis2hh12_bqBANDPASS, lis2hh12_bqNOTCH } lis2hh12_bq_type_t;
+
+typedef struct {						// biquad, Q14 coefficients with a0 normalised to 1
+	i16_t b0, b1, b2, a1, a2;
+} lis2hh12_bq_t;
+
+typedef struct {						// software filter chain, DC removal -> biquads -> decimation
+	u8_t Decim;						// keep 1 of Decim samples, 1 = all
+	u8_t Phase;						// inputs since last output
+	u8_t DCshift;					// DC tracking pole at 1 - 2^-DCshift, 0 = off
+	u8_t NumBQ;
+	lis2hh12_bq_t BQ[lis2hh12DSP_BIQUADS];
+	i32_t DC[3];					// DC estimate per axis, Q16
+	i32_t Z[lis2hh12DSP_BIQUADS][3][4];	// x[n-1], x[n-2], y[n-1], y[n-2] per stage & axis
+	u32_t Cycles;					// CPU cycles spent
+	u32_t Samples;					// input samples processed
+} lis2hh12_dsp_t;
+
+typedef struct {						// log2 bucketed values, Bin[n] holds 2^(n-1) <= value < 2^n
+	u32_t Bin[lis2hh12HIST_BINS];
+	u32_t Max;
+} lis2hh12_hist_t;
+
+typedef struct {						// single producer (I2C callbacks) single consumer ring
+	u32_t Head;						// free running producer index
+	u32_t Tail;						// free running consumer index
+	u32_t Overflow;					// samples dropped because ring was full
+	u32_t Pend;						// dropped since the last put, marked as a gap on the next sample
+	u32_t HiWater;					// maximum fill level seen
+	lis2hh12_hist_t * psAge;		// age of the oldest sample at each peek, NULL = not recorded
+	lis2hh12_sample_t Buf[lis2hh12RING_SIZE];
+} lis2hh12_ring_t;
+
+typedef enum {
+	lis2hh12_hIRQ0,					// cycles, GPIO ISR body
+	lis2hh12_hBUS,					// uSec, INTx edge to decoder (queue wait + status burst)
+	lis2hh12_hIRQ1,					// cycles, decoder & dispatch
+	lis2hh12_hDATA,					// uSec, INTx edge to samples delivered
+	lis2hh12_hPOP,					// uSec, oldest unread sample age at consumer peek
+	lis2hh12_hNUM
+} lis2hh12_hidx_t;
+
+typedef struct {						// per device instrumentation, all fields u32, updated lock free
+	u32_t IRQok, IRQlost, IRQfifo, IRQig1, IRQig2, IRQinact, IRQboot;
+	u32_t IRQdrdy, IRQdrdyErr;
+	u32_t Overrun, Lost;			// FIFO ovr/STATUS ZYXor events & estimated samples lost
+	u32_t FIFOtrans, FIFOsamples;
+	u32_t BusTrans, BusBytes, BusErr;
+	u32_t Fill[lis2hh12FIFO_DEPTH + 1];	// FIFO level seen by each FIFO IRQ
+	lis2hh12_hist_t Hist[lis2hh12_hNUM];
+} lis2hh12_inst_t;
+DUMB_STATIC_ASSERT((sizeof(lis2hh12_inst_t) % sizeof(u32_t)) == 0);
+
+typedef struct {						// sensor clock estimator, times in Q16 uSec
+	u64_t Next;						// predicted time of next sample, 0 = not locked
+	u64_t Last;						// newest sample time handed out, keeps timestamps monotonic
+	u64_t Period;					// estimated sample period
+	u64_t Nominal;					// odr_scale[] period
+	u64_t IrqTS;					// uSec, INTx edge time captured in IRQ_0
+	u64_t RefTS;					// uSec, IRQ time of reference sample
+	i64_t Err;						// last phase error measured
+	u32_t Span;						// samples since last reference
+	u32_t Refs, Resync;
+	u8_t RefIdx;					// reference is sample RefIdx (1 based) of those still to be delivered, 0 = none
+	u8_t ODR;						// ctrl1.odr the estimate applies to
+} lis2hh12_clk_t;
+
+typedef struct {						// overrun gap marking & FIFO watermark adaptation
+	u8_t Pend;						// overrun seen, gap estimated at the next delivery
+	u8_t Ovr;						// overrun seen in the current adaptation window
+	u8_t Lag;						// worst FIFO level beyond FTH at decode in the current window
+	u8_t ODR;						// ctrl1.odr the window applies to
+	u16_t Clean;					// consecutive windows without overrun or lag growth
+	u32_t Gap;						// samples lost, not yet marked on a delivered sample
+	u32_t Changes;					// FTH adjustments made
+} lis2hh12_wm_t;
+
+typedef struct {						// startup timing, all relative to T0
+	u64_t T0;						// lis2hh12Identify() entry
+	u32_t BootUS;					// reboot until CTRL6 boot cleared, 0 if warm
+	u32_t IdentUS;					// lis2hh12Identify() done
+	u32_t ConfigUS;					// lis2hh12Config() done
+	u32_t FirstUS;					// first sample delivered, 0 = none yet
+	u8_t Polls;						// CTRL6 reads until boot cleared
+	u8_t Warm;						// profile found in place, no reboot & next lis2hh12Config() only, bus errors clear it
+} lis2hh12_start_t;
+
+typedef struct {						// self test result, averages in mG at +-2G
+	i16_t Base[3];					// self test off
+	i16_t Pos[3];					// positive sign self test
+	i16_t Neg[3];					// negative sign self test
+	u32_t DurUS;					// complete test incl. configuration restore
+	u8_t Fail;						// |Pos-Base| out of limits 1<<axis, |Neg-Base| 8<<axis
+	u8_t Done;						// 1 = test ran to completion, result valid
+} lis2hh12_st_t;
+DUMB_STATIC_ASSERT(lis2hh12ST_DISCARD + lis2hh12ST_SAMPLES <= lis2hh12FIFO_DEPTH);
+
+typedef struct {						// per device calibration, mG = M * nominal mG - B, plain data for NVS
+	i32_t M[3][3];					// gain & cross axis correction Q16.16, identity = 65536 on the diagonal
+	i32_t B[3];						// offset in mG Q16.16, after M
+	u16_t ResMG;					// RMS fit residual in mG
+	u8_t Points;					// orientations used by the fit
+	u8_t Valid;
+} lis2hh12_cal_t;
+
+struct lis2hh12_t;
+typedef void (* lis2hh12_spec_cb_t)(struct lis2hh12_t *, f32_t *, u16_t, f32_t);	// amplitudes, count, bin width (0 = Goertzel)
+typedef void (* lis2hh12_blk_cb_t)(struct lis2hh12_t *, lis2hh12_xyz_t *, u8_t);
+
+typedef struct {						// per axis window summary, LSb at the FS in the record
+	i16_t Mean;
+	u16_t RMS;						// AC RMS (standard deviation) about Mean
+	i16_t Min, Max;					// peak to peak = Max - Min
+	u16_t Crest;					// Q8, largest excursion from Mean / RMS
+	u16_t Kurt;						// Q8, 3.0 (768) for gaussian noise
+} lis2hh12_axsum_t;
+
+typedef struct {						// compact window summary record
+	u64_t TS;						// uSec, last sample in window
+	u16_t Count;					// samples in window
+	u8_t FS;						// ctrl4.fs at emission
+	u8_t Seq;						// window sequence number, gaps show lost records
+	lis2hh12_axsum_t Axis[3];
+} lis2hh12_sum_t;
+DUMB_STATIC_ASSERT(sizeof(lis2hh12_sum_t) == 48);
+
+typedef void (* lis2hh12_sum_cb_t)(struct lis2hh12_t *, lis2hh12_sum_t *);
+
+typedef struct {						// running moments for one axis
+	i16_t Min, Max;
+	f32_t Mean, M2, M3, M4;			// Welford / Pebay central moment sums
+} lis2hh12_mom_t;
+
+typedef struct {						// incremental window statistics
+	lis2hh12_sum_cb_t cbSum;		// called with each completed window
+	u16_t Window;					// samples per summary
+	u16_t Count;					// samples in current window
+	u8_t Seq;						// next record, skipped when a partial window is discarded on a gap
+	lis2hh12_mom_t Mom[3];
+} lis2hh12_stat_t;
+
+typedef enum { lis2hh12_specFFT, lis2hh12_specGOERTZEL } lis2hh12_spec_mode_t;
+
+typedef struct {						// block spectral analysis of one axis, Hann window, overlapped
+	lis2hh12_spec_cb_t cbSpec;		// called with amplitudes (peak LSb) of each block
+	u8_t Mode;						// lis2hh12_spec_mode_t
+	u8_t Axis;						// 0=X 1=Y 2=Z
+	u8_t NumBins;					// Goertzel frequencies configured
+	u16_t N;						// block size, from ODR
+	u16_t Hop;						// new samples per block, N - overlap
+	u16_t Fill;						// samples in In[]
+	f32_t Fs;						// sample rate Hz
+	f32_t WinSum;					// sum of window, amplitude normalisation
+	f32_t In[lis2hh12SPEC_NMAX];
+	f32_t Win[lis2hh12SPEC_NMAX];
+	f32_t Re[lis2hh12SPEC_NMAX / 2], Im[lis2hh12SPEC_NMAX / 2];
+	f32_t Cos[lis2hh12SPEC_NMAX / 2], Sin[lis2hh12SPEC_NMAX / 2];	// twiddles, 2*pi*k/N
+	f32_t Coef[lis2hh12SPEC_BINS];	// Goertzel 2*cos(w)
+	f32_t Freq[lis2hh12SPEC_BINS];
+	f32_t Mag[lis2hh12SPEC_NMAX / 2 + 1];
+	u32_t Blocks;
+	u32_t Cycles, CyclesMax;		// CPU cycles, all and worst block
+} lis2hh12_spec_t;
+
+typedef enum {							// axis pointing up, IG_SRCx bit + 1
+	lis2hh12_posNONE, lis2hh12_posXL, lis2hh12_posXH, lis2hh12_posYL, lis2hh12_posYH, lis2hh12_posZL, lis2hh12_posZH,
+} lis2hh12_pos_t;
+
+struct lis2hh12_orient_t;
+typedef void (* lis2hh12_orient_cb_t)(struct lis2hh12_t *, struct lis2hh12_orient_t *);
+
+typedef struct lis2hh12_orient_t {		// tilt & 6D/4D orientation
+	lis2hh12_orient_cb_t cbPos;		// called on each position change
+	i16_t Pitch, Roll;				// centidegrees, block mean (computed mode) or lis2hh12OrientNow()
+	u8_t Pos;						// lis2hh12_pos_t
+	u8_t IG;						// 0 = computed per block, 1/2 = IGx 6D/4D interrupt driven
+	u8_t D4;						// 4D, Z positions ignored
+	u32_t Blocks;					// computed mode blocks
+	u32_t Events;					// IGx interrupts
+	u32_t Changes;					// position changes
+	u32_t Cycles;					// CPU cycles, computed mode
+} lis2hh12_orient_t;
+DUMB_STATIC_ASSERT((lis2hh12SPEC_NMAX & (lis2hh12SPEC_NMAX - 1)) == 0);
+
+typedef enum { lis2hh12_pmINIT, lis2hh12_pmIDLE, lis2hh12_pmACTIVE } lis2hh12_pm_state_t;
+
+typedef struct {						// ODR & FIFO watermark profile
+	u8_t ODR;						// lis2hh12_odr_t
+	u8_t FTH;						// FIFO threshold, samples per wakeup
+} lis2hh12_pm_prof_t;
+
+typedef struct {						// activity driven power manager
+	lis2hh12_pm_prof_t Prof[3];		// indexed by lis2hh12_pm_state_t, [0] unused
+	u32_t QuietMS;					// no IG1 motion for this long before dropping back to IDLE
+	u64_t MotionTS;					// uSec, last IG1 event seen, 0 = none yet
+	u32_t LastIG1;					// Inst.IRQig1 at last service
+	u8_t State;						// lis2hh12_pm_state_t applied
+	u8_t Target;					// requested, differs from State while a switch is queued
+	u8_t FifoSrc;					// FIFO_SRC read ahead of switching
+	u32_t Switches;
+	u64_t MetTS;					// metrics window start, uSec
+	u32_t MetWake, MetBytes;		// counter values at window start
+	u32_t WakePS, BytesPS;			// IRQ wakeups & bus bytes per second, last window
+} lis2hh12_pm_t;
+
+typedef struct {						// hot path benchmark results, lis2hh12ReportBench() emits JSON
+	u32_t Iter;						// micro benchmark iterations
+	u32_t ConvCyc, ConvNS;			// lis2hh12ConvCoord() per call
+	u32_t CoordPS, BlkQ16PS, BlkF32PS;	// pSec per XYZ sample, 3 lis2hh12ConvCoord() or FIFO sized blocks
+	u32_t EncPS, EncBpkS;			// lis2hh12EncBlock() pSec & bytes per 1000 samples, FIFO sized blocks
+	u32_t Irq1Cyc, Irq1NS;			// lis2hh12IRQ_1() decode & dispatch per call, no data pending
+	u32_t RptUS, RptBytes;			// lis2hh12ReportDev() once
+	u32_t ODR, FTH, LatencyUS;		// macro run: configuration & model bus time per transaction
+	u32_t Samples, IRQs, FIFOtrans;	// macro run totals
+	u32_t BusTrans, BusBytes;
+	u32_t ModelMS, WallMS;
+	u32_t Rate;						// samples/s sustained against wall time
+} lis2hh12_bench_t;
+
+struct lis2hh12_t;
+typedef struct {						// transport, command & callback semantics as for halI2C_Queue()
+	const char * pcName;
+	int (* Queue)(struct lis2hh12_t *, int, u8_t *, size_t, u8_t *, size_t, i2cq_p1_t, i2cq_p2_t);
+	u32_t Hz;						// bus clock, wire time estimates
+	u8_t BitsPerByte;				// 9 for I2C (ACK), 8 for SPI
+	u8_t AddrBytes;					// device address bytes per direction, 0 for SPI
+	u8_t FrameBits;					// start/restart/stop or CS framing per transaction
+	u8_t CTRL4;						// CTRL4 bits the transport requires on top of any profile, e.g. SPI i2c_disable
+} lis2hh12_bus_t;
+
+#if (lis2hh12SIM > 0)
+struct lis2hh12_sim_t;
+typedef lis2hh12_xyz_t (* lis2hh12_gen_t)(struct lis2hh12_sim_t *, u64_t);	// sample in mG (raw LSb if GenRaw) at time uSec
+
+typedef struct lis2hh12_sim_t {
+	struct i2c_di_t * psI2C;		// bus device the model answers for
+	struct lis2hh12_t * psDev;		// driver handle, for INTx delivery
+	void (* cbIRQ)(void *);			// INTx handler, default lis2hh12IRQ_0
+	lis2hh12_gen_t Gen;				// sample source, NULL = built in waveform
+	void * GenArg;
+	u8_t GenRaw;					// Gen returns raw LSb at the current FS, bit exact replay
+	u8_t Reg[lis2hh12ZH_REF + 1];	// register file by address
+	lis2hh12_xyz_t FIFO[lis2hh12FIFO_DEPTH];
+	u64_t FIFOts[lis2hh12FIFO_DEPTH];	// time each entry was sampled
+	lis2hh12_xyz_t Last;			// previous sample in mG, for INACT
+	u8_t Head;						// oldest FIFO entry
+	u8_t Count;						// FIFO level
+	u8_t Pending;					// INTx asserted, cleared by the next bus read
+	u8_t Trig;						// IGx event seen, for S2F/B2S/B2F modes
+	u8_t Inactive;
+	u8_t Prev[2];					// previous IGx event bits, 6D movement
+	u8_t Dur[2];					// IGx condition duration in samples
+	u16_t Still;					// consecutive samples below ACT_THS
+	i16_t AmpX;						// built in waveform: 1G on Z plus AmpX mG sine on X
+	u16_t FreqX;					// Hz
+	u16_t Noise;					// mG peak, all axes
+	i16_t STmG;						// self test output change, default 400
+	u32_t Seed;
+	u32_t LatencyUS;				// simulated bus time per transaction
+	u32_t BootUS;					// CTRL6 boot remains set this long after a reboot, 0 = immediate
+	u64_t BootTS;					// boot completes, 0 = not booting
+	u64_t Tnext;					// time of next sample in uSec
+	i32_t PPM;						// sample period error, + = slow, the estimator's CLK Drift converges to it
+	u32_t Frac;						// Q16 uSec carried between skewed periods
+	u32_t Samples, Overruns, IRQs;
+	u32_t LatMax, LatCnt;			// sample to bus read latency in uSec
+	u64_t LatSum;
+} lis2hh12_sim_t;
+
+struct lis2hh12_replay_t;
+typedef void (* lis2hh12_replay_cb_t)(struct lis2hh12_replay_t *);
+
+typedef struct lis2hh12_replay_t {		// recorded samples played through the chip model
+	lis2hh12_sim_t * psSim;
+	const lis2hh12_sample_t * psSrc;	// recording, e.g. decoded with lis2hh12DecBlock()
+	size_t Count, Idx;
+	lis2hh12_replay_cb_t cbStep;	// called after each model step, pipeline consumer
+	void * Arg;
+	u64_t T0rec;					// uSec, first recorded sample
+	u64_t T0sim;					// uSec, model time replay started, 0 = not yet
+	u64_t Tsim;						// uSec, model time now
+	u64_t Trun, Twall;				// uSec, model & wall time of last lis2hh12ReplayRun()
+	u32_t Loops;					// times the recording wrapped
+	u8_t Loop;						// restart at end, else hold last sample
+} lis2hh12_replay_t;
+#endif
+
 struct i2c_di_t;
-typedef struct {
-	struct i2c_di_t * psI2C;
-	SemaphoreHandle_t mux;
+typedef struct lis2hh12_t {
+	struct i2c_di_t * psI2C;		// device descriptor, also the I2C transport handle
+	SemaphoreHandle_t mux;			// serialises transactions on transports without a queue (SPI)
+	const lis2hh12_bus_t * psBus;	// transport
+	void * pvBus;					// transport handle, e.g. spi_device_handle_t
 	lis2hh12_reg_t Reg;
+	lis2hh12_xyz_t * psBlk;			// FIFO burst drain buffer, NULL = legacy per sample drain
+	lis2hh12_blk_cb_t cbBlk;		// called with each drained block
+	lis2hh12_xyz_t * psFill;		// burst in flight, psBlk or a pool block
+	u8_t BlkSize;					// capacity of psBlk in samples
+	u8_t BlkCount;					// samples in current burst, 0 = idle
+	i8_t IRQpin;					// INTx GPIO, -1 = none
+	u8_t Cached;					// 1 = shadow authoritative for config registers
+	u64_t Dirty;					// Regs[] index bitmap of shadow changes not yet written
+	u8_t ScaleFS;					// ctrl4.fs value Scale* were computed for, 0xFF = none
+	i32_t ScaleQ16;					// mG/LSb in Q16.16
+	f32_t ScaleG;					// G/LSb
+	lis2hh12_cal_t * psCal;			// calibration, NULL = nominal scale, attach with lis2hh12CalApply()
+	i32_t CalK[9];					// calibration fused with ScaleQ16, mG Q16.16 per LSb
+	i32_t CalO[3];					// -B, mG Q16.16
+	f32_t CalKF[9];					// calibration fused with ScaleG, G per LSb
+	f32_t CalOF[3];
+	u8_t SnapReg;					// first register in Snap[] read by last IRQ burst
+	u8_t Snap[lis2hh12IG_SRC2 - lis2hh12STATUS + 1];	// IRQ burst of STATUS..IG_SRC2
+	lis2hh12_dsp_t * psDsp;			// software filter chain, NULL = none
+	lis2hh12_stat_t * psStat;		// window statistics, NULL = none
+	lis2hh12_spec_t * psSpec;		// spectral analysis, NULL = none
+	lis2hh12_pm_t * psPm;			// power manager, NULL = fixed configuration
+	lis2hh12_pool_t * psPool;		// block fan out to subscribers, NULL = none
+	lis2hh12_orient_t * psOrient;	// tilt & orientation, NULL = none, attach with lis2hh12OrientInit()
+#if (lis2hh12SIM > 0)
+	lis2hh12_sim_t * psSim;			// chip model replacing the bus, NULL = real device
+#endif
+	lis2hh12_clk_t Clk;
+	lis2hh12_wm_t WM;
+	lis2hh12_start_t Start;
+	lis2hh12_st_t ST;				// last self test, lis2hh12Diags()
+	lis2hh12_inst_t Inst;
+	lis2hh12_latest_t Latest;		// newest sample, any number of readers
+	lis2hh12_ring_t Ring;			// timestamped samples, lock free
 } lis2hh12_t;
-DUMB_STATIC_ASSERT(sizeof(lis2hh12_t) == 44);
 
 // ###################################### Public variables #########################################
 
 extern const u16_t odr_scale[];
-extern lis2hh12_t sLIS2HH12;
+extern const u16_t fs_scale[];
+extern const i32_t fs_q16[];
+extern const lis2hh12_cfg_t lis2hh12CfgDefault;
+extern const lis2hh12_cfg_t * lis2hh12Profile;
+extern const lis2hh12_bus_t lis2hh12BusI2C;
+#if (lis2hh12SPI > 0)
+	extern const lis2hh12_bus_t lis2hh12BusSPI;
+#endif
+#if (lis2hh12SIM > 0)
+	extern const lis2hh12_bus_t lis2hh12BusSim;
+#endif
+extern lis2hh12_t sLIS2HH12[lis2hh12MAX_DEV];
+extern u8_t lis2hh12Num;
 
 // ###################################### Public functions #########################################
 
-int lis2hh12ReadRegs(u8_t Reg, u8_t * pU8, size_t RxSize);
-int lis2hh12WriteReg(u8_t Reg, u8_t * pU8, u8_t val);
-
-f32_t lis2hh12ConvCoord(i32_t Val);
+int lis2hh12Queue(lis2hh12_t * psDev, int eCmd, u8_t * pTx, size_t TxSize, u8_t * pRx, size_t RxSize, i2cq_p1_t p1, i2cq_p2_t p2);
+u32_t lis2hh12BusBits(const lis2hh12_bus_t * psBus, size_t TxSize, size_t RxSize);
+int lis2hh12ReadRegs(lis2hh12_t * psDev, u8_t Reg, u8_t * pU8, size_t RxSize);
+int lis2hh12WriteReg(lis2hh12_t * psDev, u8_t Reg, u8_t * pU8, u8_t val);
+int lis2hh12WriteRegs(lis2hh12_t * psDev, u8_t Reg, const u8_t * pU8, size_t TxSize);
+int lis2hh12UpdateReg(lis2hh12_t * psDev, u8_t Reg, u8_t * pU8, u8_t _and, u8_t _or);
+int lis2hh12CacheEnable(lis2hh12_t * psDev, bool State);
+int lis2hh12Commit(lis2hh12_t * psDev);
+int lis2hh12ApplyCfg(lis2hh12_t * psDev, const lis2hh12_cfg_t * psCfg);
+void lis2hh12ShadowCfg(lis2hh12_t * psDev, const lis2hh12_cfg_t * psCfg);
+int lis2hh12VerifyCfg(lis2hh12_t * psDev, const lis2hh12_cfg_t * psCfg);
+
+f32_t lis2hh12ConvCoord(lis2hh12_t * psDev, i32_t Val);
+void lis2hh12ConvBlockQ16(lis2hh12_t * psDev, const lis2hh12_xyz_t * psSrc, i32_t * pDst, size_t Count);
+void lis2hh12ConvBlockF32(lis2hh12_t * psDev, const lis2hh12_xyz_t * psSrc, f32_t * pDst, size_t Count);
+u32_t lis2hh12PeriodUS(lis2hh12_t * psDev);
+
+int lis2hh12EnableAxis(lis2hh12_t * psDev, lis2hh12_axis_t Axis);
+int lis2hh12SetBDU(lis2hh12_t * psDev, bool State);
+int lis2hh12SetODR(lis2hh12_t * psDev, lis2hh12_odr_t Rate);
+int lis2hh12SetHR(lis2hh12_t * psDev, bool State);
+int lis2hh12SetScale(lis2hh12_t * psDev, lis2hh12_fs_t Scale);
+int lis2hh12SetDecimation(lis2hh12_t * psDev, lis2hh12_deci_t Samples);
+int lis2hh12GetDRDY(lis2hh12_t * psDev);
+int lis2hh12SoftReset(lis2hh12_t * psDev);
+int lis2hh12SetBoot(lis2hh12_t * psDev);
+int lis2hh12Reboot(lis2hh12_t * psDev);
+int lis2hh12SetFilterIntPath(lis2hh12_t * psDev, lis2hh12_intpath_t IntPath);
+int lis2hh12SetFilterOutPath(lis2hh12_t * psDev, lis2hh12_outpath_t OutPath);
+int lis2hh12SetFilterHiPassBW(lis2hh12_t * psDev, lis2hh12_hp_bw_t HiPassBW);
+int lis2hh12SetFilterLoPassBW(lis2hh12_t * psDev, lis2hh12_lp_bw_t LoPassBW);
+int lis2hh12SetFilterAAliasBW(lis2hh12_t * psDev, lis2hh12_aa_bw_t AAliasBW);
+int lis2hh12SetFilterReference(lis2hh12_t * psDev, i16_t RefVal);
+int lis2hh12SetInactivity(lis2hh12_t * psDev, u8_t ths, u8_t dur);
+int lis2hh12SetBW(lis2hh12_t * psDev, e_bw_t bw);
+int lis2hh12ConfigFIFO(lis2hh12_t * psDev, e_fm_t mode, u8_t thres);
+int lis2hh12AdaptFIFO(lis2hh12_t * psDev, u8_t Margin);
+int lis2hh12SetFIFOBlock(lis2hh12_t * psDev, lis2hh12_xyz_t * psBlk, u8_t Size, lis2hh12_blk_cb_t cbBlk);
+
+size_t lis2hh12RingPut(lis2hh12_ring_t * psRing, const lis2hh12_xyz_t * psXYZ, size_t Count, u64_t TS, u32_t Period, u16_t Gap);
+size_t lis2hh12RingCount(lis2hh12_ring_t * psRing);
+size_t lis2hh12RingPeek(lis2hh12_ring_t * psRing, lis2hh12_sample_t ** ppsS);
+void lis2hh12RingRelease(lis2hh12_ring_t * psRing, size_t Count);
+void lis2hh12LatestPut(lis2hh12_latest_t * psL, const lis2hh12_xyz_t * psXYZ, u64_t TS, u8_t STATUS, u8_t FIFO_SRC);
+int lis2hh12LatestGet(lis2hh12_latest_t * psL, lis2hh12_latest_t * psOut);
+int lis2hh12Latest(lis2hh12_t * psDev, lis2hh12_latest_t * psOut);
+
+size_t lis2hh12Deliver(lis2hh12_t * psDev, lis2hh12_xyz_t * psXYZ, size_t Count);
+void lis2hh12IRQ_0(void * Arg);
+void lis2hh12IRQ_1(void * Arg);
 
 struct i2c_di_t;
+lis2hh12_t * lis2hh12GetDev(struct i2c_di_t * psI2C);
+int	lis2hh12IdentifyBus(struct i2c_di_t * psI2C, const lis2hh12_bus_t * psBus, void * pvBus);
 int	lis2hh12Identify(struct i2c_di_t * psI2C);
 int	lis2hh12Config(struct i2c_di_t * psI2C);
 int	lis2hh12Diags(struct i2c_di_t * psI2C);
 
 struct report_t;
+void lis2hh12InstSnapshot(lis2hh12_t * psDev, lis2hh12_inst_t * psSnap, bool Reset);
 int lis2hh12ReportIG_SRC(struct report_t * psR);
+int lis2hh12ReportDev(struct report_t * psR, lis2hh12_t * psDev);
 int lis2hh12ReportAll(struct report_t * psR);
 
+// lis2hh12_bench.c
+
+#if (lis2hh12SIM > 0)
+int lis2hh12Bench(lis2hh12_bench_t * psB, const lis2hh12_cfg_t * psCfg, struct report_t * psRsink, u32_t Iter, u32_t LatencyUS, u32_t DurationMS);
+#endif
+int lis2hh12ReportBench(struct report_t * psR, lis2hh12_bench_t * psB);
+int lis2hh12LatestStress(struct report_t * psR, u32_t Readers, u32_t DurationMS);
+int lis2hh12BenchBus(struct report_t * psR, lis2hh12_t * psDev, u32_t Iter, u8_t FTH);
+
+// lis2hh12_cal.c
+
+int lis2hh12CalFit(lis2hh12_cal_t * psCal, const f32_t (* pMeas)[3], const f32_t (* pRef)[3], size_t Count);
+int lis2hh12CalSixPos(lis2hh12_cal_t * psCal, const f32_t (* pMeas)[3]);
+int lis2hh12CalApply(lis2hh12_t * psDev, lis2hh12_cal_t * psCal);
+void lis2hh12CalFuse(lis2hh12_t * psDev);
+int lis2hh12ReportCal(struct report_t * psR, lis2hh12_cal_t * psCal);
+
+// lis2hh12_codec.c, see lis2hh12_codec.h
+
+int lis2hh12EncHeader(lis2hh12_enc_t * psEnc, lis2hh12_t * psDev, u64_t TS);
+
+// lis2hh12_diag.c
+
+int lis2hh12SelfTest(lis2hh12_t * psDev, lis2hh12_st_t * psST);
+int lis2hh12ReportSelfTest(struct report_t * psR, lis2hh12_st_t * psST);
+
+// lis2hh12_dsp.c
+
+int lis2hh12DspInit(lis2hh12_dsp_t * psDsp, u8_t Decim, u8_t DCshift);
+int lis2hh12DspAddFilter(lis2hh12_dsp_t * psDsp, lis2hh12_bq_type_t Type, f32_t Fs, f32_t Fc, f32_t Q);
+void lis2hh12DspReset(lis2hh12_dsp_t * psDsp);
+size_t lis2hh12DspRun(lis2hh12_dsp_t * psDsp, lis2hh12_xyz_t * psXYZ, size_t Count);
+int lis2hh12ReportDsp(struct report_t * psR, lis2hh12_dsp_t * psDsp);
+
+// lis2hh12_orient.c
+
+u32_t lis2hh12Isqrt(u32_t Val);
+i32_t lis2hh12Atan2CD(i32_t Y, i32_t X);
+void lis2hh12Tilt(i32_t X, i32_t Y, i32_t Z, i16_t * pPitch, i16_t * pRoll);
+int lis2hh12OrientInit(lis2hh12_t * psDev, lis2hh12_orient_t * psO, u8_t IG, bool D4, u16_t ThsMG, u8_t Dur, lis2hh12_orient_cb_t cbPos);
+void lis2hh12OrientFeed(lis2hh12_t * psDev, lis2hh12_xyz_t * psXYZ, size_t Count);
+void lis2hh12OrientEvent(lis2hh12_t * psDev, u8_t IG, u8_t Src);
+int lis2hh12OrientNow(lis2hh12_t * psDev);
+int lis2hh12ReportOrient(struct report_t * psR, lis2hh12_orient_t * psO);
+
+// lis2hh12_pm.c
+
+int lis2hh12PmInit(lis2hh12_pm_t * psPm, lis2hh12_odr_t IdleODR, u8_t IdleFTH, lis2hh12_odr_t ActiveODR, u8_t ActiveFTH, u32_t QuietMS);
+int lis2hh12Service(lis2hh12_t * psDev);
+int lis2hh12ReportPm(struct report_t * psR, lis2hh12_pm_t * psPm);
+
+// lis2hh12_pool.c
+
+void lis2hh12PoolInit(lis2hh12_pool_t * psPool);
+lis2hh12_blk_t * lis2hh12PoolAlloc(lis2hh12_pool_t * psPool);
+lis2hh12_blk_t * lis2hh12PoolOwner(lis2hh12_pool_t * psPool, lis2hh12_xyz_t * psXYZ);
+void lis2hh12PoolPublish(lis2hh12_pool_t * psPool, lis2hh12_xyz_t * psXYZ, size_t Count, u64_t TS, u32_t Period, u16_t Gap);
+bool lis2hh12PoolHold(lis2hh12_pool_t * psPool, u8_t Level);
+int lis2hh12Subscribe(lis2hh12_pool_t * psPool, lis2hh12_sub_policy_t Policy, void * xTask);
+void lis2hh12Unsubscribe(lis2hh12_pool_t * psPool, int Sub);
+lis2hh12_blk_t * lis2hh12SubGet(lis2hh12_pool_t * psPool, int Sub);
+void lis2hh12BlkRelease(lis2hh12_blk_t * psBlk);
+int lis2hh12ReportPool(struct report_t * psR, lis2hh12_pool_t * psPool);
+
+// lis2hh12_spec.c
+
+int lis2hh12SpecInit(lis2hh12_spec_t * psSpec, u8_t ODR, lis2hh12_spec_mode_t Mode, u8_t Axis, u8_t Overlap, lis2hh12_spec_cb_t cbSpec);
+int lis2hh12SpecAddBin(lis2hh12_spec_t * psSpec, f32_t Freq);
+void lis2hh12SpecFeed(lis2hh12_t * psDev, lis2hh12_xyz_t * psXYZ, size_t Count);
+f32_t lis2hh12SpecBand(lis2hh12_spec_t * psSpec, f32_t Lo, f32_t Hi);
+int lis2hh12ReportSpec(struct report_t * psR, lis2hh12_spec_t * psSpec);
+int lis2hh12SpecBench(struct report_t * psR);
+
+// lis2hh12_spi.c
+
+#if (lis2hh12SPI > 0)
+int lis2hh12SpiQueue(lis2hh12_t * psDev, int eCmd, u8_t * pTx, size_t TxSize, u8_t * pRx, size_t RxSize, i2cq_p1_t p1, i2cq_p2_t p2);
+#endif
+
+// lis2hh12_stat.c
+
+int lis2hh12StatInit(lis2hh12_stat_t * psStat, u16_t Window, lis2hh12_sum_cb_t cbSum);
+void lis2hh12StatFeed(lis2hh12_t * psDev, lis2hh12_xyz_t * psXYZ, size_t Count, u64_t TS, u32_t Period, u16_t Gap);
+int lis2hh12ReportSum(struct report_t * psR, lis2hh12_sum_t * psSum);
+
+// lis2hh12_sim.c
+
+#if (lis2hh12SIM > 0)
+int lis2hh12SimInit(lis2hh12_sim_t * psSim, struct i2c_di_t * psI2C);
+lis2hh12_sim_t * lis2hh12SimAttach(lis2hh12_t * psDev);
+int lis2hh12SimQueue(lis2hh12_sim_t * psSim, int eCmd, u8_t * pTx, size_t TxSize, u8_t * pRx, size_t RxSize, i2cq_p1_t p1, i2cq_p2_t p2);
+void lis2hh12SimTick(lis2hh12_sim_t * psSim, u64_t Now);
+int lis2hh12ReportSim(struct report_t * psR, lis2hh12_sim_t * psSim);
+
+// lis2hh12_replay.c
+
+int lis2hh12ReplayInit(lis2hh12_replay_t * psRep, lis2hh12_sim_t * psSim, const lis2hh12_sample_t * psSrc, size_t Count, bool Loop);
+int lis2hh12ReplayRun(lis2hh12_replay_t * psRep, u64_t Duration, u32_t Speed, u32_t StepUS);
+int lis2hh12ReportReplay(struct report_t * psR, lis2hh12_replay_t * psRep);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,333 @@
+// lis2hh12_bench.c - Copyright (c) 2022-24 Andre M. Maree / KSS Technologies (Pty) Ltd.
+
+#include "hal_platform.h"
+
+#if (HAL_LIS2HH12 > 0)
+#include "hal_i2c_common.h"
+#include "lis2hh12.h"
+#include "report.h"
+#include "errors_events.h"
+
+#include "esp_cpu.h"
+#include "esp_timer.h"
+
+// ############################################# Macros ############################################
+
+#define	debugFLAG					0xF000
+#define	debugTIMING					(debugFLAG_GLOBAL & debugFLAG & 0x1000)
+#define	debugTRACK					(debugFLAG_GLOBAL & debugFLAG & 0x2000)
+#define	debugPARAM					(debugFLAG_GLOBAL & debugFLAG & 0x4000)
+#define	debugRESULT					(debugFLAG_GLOBAL & debugFLAG & 0x8000)
+
+#define lis2hh12BENCH_SCHEMA		3					// bump when JSON fields change meaning
+
+// ###################################### Local variables ##########################################
+
+typedef struct {						// sequence lock stress, shared by writer and reader tasks
+	lis2hh12_latest_t * psL;
+	u8_t Run;
+	u32_t Done;						// reader tasks finished
+	u32_t Reads, Torn, Busy, Back;
+} lis2hh12_stress_t;
+
+#if (lis2hh12SIM > 0)
+static const lis2hh12_cfg_t BenchCfg = {				// 800Hz, FIFO stream, FTH 16
+	.CTRL = {
+		makeCTRL1(1,lis2hh12_odr800,1,1,1,1), makeCTRL2(0,0,0,0,0), makeCTRL3(1,0,0,0,0,0,1,0), makeCTRL4(0,0,0,1,0,0),
+		makeCTRL5(0,0,0,0,0,0), makeCTRL6(0,0,0,0,0,0,0), makeCTRL7(0,0,0,0,0,0),
+	},
+	.FIFO_CTRL = makeFIFOC(fmSTREAM,16),
+};
+
+static lis2hh12_t sBenchDev;							// private, never in sLIS2HH12[]
+static lis2hh12_sim_t sBenchSim;
+static i2c_di_t sBenchI2C;
+static lis2hh12_xyz_t sBenchBlk[lis2hh12FIFO_DEPTH];
+static i32_t sBenchQ16[lis2hh12FIFO_DEPTH * 3];
+static f32_t sBenchF32[lis2hh12FIFO_DEPTH * 3];
+static lis2hh12_sample_t sBenchS[lis2hh12FIFO_DEPTH];
+static u8_t sBenchEnc[1024];
+static u32_t BenchSamples;
+#endif
+
+// #################################### Local ONLY functions #######################################
+
+#if (lis2hh12SIM > 0)
+/**
+ * @brief		macro run consumer, empty the ring after every model step as an application would
+ */
+static void lis2hh12BenchDrain(lis2hh12_replay_t * psRep) {
+	lis2hh12_sample_t * psS;
+	size_t Count;
+	while ((Count = lis2hh12RingPeek(&sBenchDev.Ring, &psS))) {
+		BenchSamples += Count;
+		lis2hh12RingRelease(&sBenchDev.Ring, Count);
+	}
+}
+
+/**
+ * @brief		private device on its own chip model, configured with psCfg
+ */
+static int lis2hh12BenchDev(const lis2hh12_cfg_t * psCfg, u32_t LatencyUS) {
+	if (lis2hh12SimInit(&sBenchSim, &sBenchI2C) < erSUCCESS)	return erINV_STATE;
+	sBenchSim.AmpX = 500;
+	sBenchSim.FreqX = 50;
+	sBenchSim.LatencyUS = LatencyUS;
+	memset(&sBenchDev, 0, sizeof(lis2hh12_t));
+	sBenchDev.psI2C = &sBenchI2C;
+	sBenchDev.psBus = &lis2hh12BusSim;
+	sBenchDev.psSim = &sBenchSim;
+	sBenchDev.ScaleFS = 0xFF;
+	sBenchDev.IRQpin = -1;
+	sBenchDev.Ring.psAge = &sBenchDev.Inst.Hist[lis2hh12_hPOP];
+	sBenchSim.psDev = &sBenchDev;
+	int iRV = lis2hh12ApplyCfg(&sBenchDev, psCfg);
+	if (iRV == erSUCCESS) iRV = lis2hh12SetFIFOBlock(&sBenchDev, sBenchBlk, lis2hh12FIFO_DEPTH, NULL);
+	return iRV;
+}
+#endif
+
+/**
+ * @brief		stress reader, checks every snapshot against the writer's pattern
+ */
+static void lis2hh12StressTask(void * pvPara) {
+	lis2hh12_stress_t * psS = (lis2hh12_stress_t *) pvPara;
+	lis2hh12_latest_t sL;
+	u32_t Reads = 0, Torn = 0, Busy = 0, Back = 0, Last = 0;
+	while (__atomic_load_n(&psS->Run, __ATOMIC_RELAXED)) {
+		int iRV = lis2hh12LatestGet(psS->psL, &sL);
+		if (iRV == erFAILURE) { ++Busy; continue; }
+		if (iRV != erSUCCESS)						continue;
+		++Reads;
+		u32_t N = (u32_t) sL.TS;						// writer encodes its count in every field
+		if (sL.Seq != N * 2 || (u32_t) (sL.TS >> 32) != N || sL.STATUS != (u8_t) N || sL.FIFO_SRC != (u8_t) ~N ||
+			sL.XYZ.X != (i16_t) N || sL.XYZ.Y != (i16_t) ~N || sL.XYZ.Z != (i16_t) (N * 7)) ++Torn;
+		if (sL.Seq < Last) ++Back;
+		Last = sL.Seq;
+	}
+	__atomic_fetch_add(&psS->Reads, Reads, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&psS->Torn, Torn, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&psS->Busy, Busy, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&psS->Back, Back, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&psS->Done, 1, __ATOMIC_RELEASE);
+	vTaskDelete(NULL);
+}
+
+// ###################################### Public functions #########################################
+
+#if (lis2hh12SIM > 0)
+/**
+ * @brief		measure the driver hot paths on a private device backed by its own chip model
+ * @param[in]	psCfg - device configuration, NULL = 800Hz FIFO stream with FTH 16
+ * @param[in]	psRsink - destination for the lis2hh12ReportDev() output being timed
+ * @param[in]	Iter - micro benchmark iterations, 0 = 4096
+ * @param[in]	LatencyUS/DurationMS - macro run bus time per transaction and model time to run
+ * @return		erSUCCESS, erINV_PARA, erINV_STATE if no chip model slot is free or a bus error
+ * @note		micro benchmarks (conversion, IRQ decode, reporting) run without bus traffic, the macro
+ * 				run (FIFO drain, end to end rate) drives the model unpaced. Identified devices are not
+ * 				touched apart from lis2hh12TIME() following model time during the macro run.
+ */
+int lis2hh12Bench(lis2hh12_bench_t * psB, const lis2hh12_cfg_t * psCfg, report_t * psRsink, u32_t Iter, u32_t LatencyUS, u32_t DurationMS) {
+	if (psB == NULL)								return erINV_PARA;
+	memset(psB, 0, sizeof(lis2hh12_bench_t));
+	psB->Iter = Iter ? Iter : 4096;
+	int iRV = lis2hh12BenchDev(psCfg ? psCfg : &BenchCfg, LatencyUS);
+	if (iRV < erSUCCESS)							return iRV;
+	lis2hh12_t * psDev = &sBenchDev;
+
+	// per sample conversion
+	volatile f32_t Sink = 0.0f;							// keep the calls from being optimised away
+	u64_t T0 = esp_timer_get_time();
+	u32_t Cyc = esp_cpu_get_cycle_count();
+	for (u32_t i = 0; i < psB->Iter; ++i) Sink += lis2hh12ConvCoord(psDev, (i32_t) (i & 0xFFFF) - 32768);
+	psB->ConvCyc = (esp_cpu_get_cycle_count() - Cyc) / psB->Iter;
+	psB->ConvNS = (u32_t) (((esp_timer_get_time() - T0) * 1000ULL) / psB->Iter);
+
+	// per XYZ sample, 3 single conversions against block conversion of FIFO sized blocks
+	for (int i = 0; i < lis2hh12FIFO_DEPTH; ++i) {
+		sBenchBlk[i].X = (i16_t) (i * 1021);
+		sBenchBlk[i].Y = (i16_t) (-i * 517);
+		sBenchBlk[i].Z = (i16_t) (16384 + i);
+	}
+	const u64_t Samples = (u64_t) psB->Iter * lis2hh12FIFO_DEPTH;
+	T0 = esp_timer_get_time();
+	for (u32_t i = 0; i < psB->Iter; ++i) {
+		for (int j = 0; j < lis2hh12FIFO_DEPTH; ++j) {
+			sBenchF32[j * 3] = lis2hh12ConvCoord(psDev, sBenchBlk[j].X);
+			sBenchF32[j * 3 + 1] = lis2hh12ConvCoord(psDev, sBenchBlk[j].Y);
+			sBenchF32[j * 3 + 2] = lis2hh12ConvCoord(psDev, sBenchBlk[j].Z);
+		}
+		__asm__ __volatile__("" ::: "memory");			// results stored every pass
+	}
+	psB->CoordPS = (u32_t) (((esp_timer_get_time() - T0) * 1000000ULL) / Samples);
+	T0 = esp_timer_get_time();
+	for (u32_t i = 0; i < psB->Iter; ++i) {
+		lis2hh12ConvBlockQ16(psDev, sBenchBlk, sBenchQ16, lis2hh12FIFO_DEPTH);
+		__asm__ __volatile__("" ::: "memory");
+	}
+	psB->BlkQ16PS = (u32_t) (((esp_timer_get_time() - T0) * 1000000ULL) / Samples);
+	T0 = esp_timer_get_time();
+	for (u32_t i = 0; i < psB->Iter; ++i) {
+		lis2hh12ConvBlockF32(psDev, sBenchBlk, sBenchF32, lis2hh12FIFO_DEPTH);
+		__asm__ __volatile__("" ::: "memory");
+	}
+	psB->BlkF32PS = (u32_t) (((esp_timer_get_time() - T0) * 1000000ULL) / Samples);
+
+	// recording encoder on FIFO sized ring blocks, the same samples with +-1mG (16 LSb) noise at 800Hz
+	u32_t Seed = 1;
+	for (int j = 0; j < lis2hh12FIFO_DEPTH; ++j) {
+		for (int a = 0; a < 3; ++a) {
+			Seed = Seed * 1664525 + 1013904223;
+			sBenchS[j].XYZ.Axis[a] = sBenchBlk[j].Axis[a] + (i16_t) ((Seed >> 16) % 33) - 16;
+		}
+		sBenchS[j].Gap = 0;
+	}
+	lis2hh12_enc_t sEnc;
+	lis2hh12EncInit(&sEnc, sBenchEnc, sizeof(sBenchEnc), 256);
+	u64_t Bytes = 0;
+	T0 = esp_timer_get_time();
+	for (u32_t i = 0; i < psB->Iter; ++i) {
+		for (int j = 0; j < lis2hh12FIFO_DEPTH; ++j) sBenchS[j].TS = ((u64_t) i * lis2hh12FIFO_DEPTH + j) * 1250ULL;
+		size_t Done = 0;
+		while ((Done += lis2hh12EncBlock(&sEnc, &sBenchS[Done], lis2hh12FIFO_DEPTH - Done)) < lis2hh12FIFO_DEPTH) {
+			Bytes += sEnc.Len;							// drained as a writer task would
+			sEnc.Len = 0;
+		}
+	}
+	psB->EncPS = (u32_t) (((esp_timer_get_time() - T0) * 1000000ULL) / Samples);
+	psB->EncBpkS = (u32_t) (((Bytes + sEnc.Len) * 1000ULL) / Samples);
+
+	// INTx decode & dispatch with nothing pending, bus and sample delivery excluded
+	psDev->SnapReg = lis2hh12FIFO_SRC;
+	memset(psDev->Snap, 0, sizeof(psDev->Snap));
+	T0 = esp_timer_get_time();
+	Cyc = esp_cpu_get_cycle_count();
+	for (u32_t i = 0; i < psB->Iter; ++i) lis2hh12IRQ_1(psDev);
+	psB->Irq1Cyc = (esp_cpu_get_cycle_count() - Cyc) / psB->Iter;
+	psB->Irq1NS = (u32_t) (((esp_timer_get_time() - T0) * 1000ULL) / psB->Iter);
+
+	// full device report, cost depends on where psRsink sends it
+	T0 = esp_timer_get_time();
+	iRV = lis2hh12ReportDev(psRsink, psDev);
+	psB->RptUS = (u32_t) (esp_timer_get_time() - T0);
+	psB->RptBytes = iRV > 0 ? iRV : 0;
+
+	// FIFO drain cost & sustained rate, the model running unpaced at the configured ODR/FTH
+	if (DurationMS) {
+		psB->ODR = odr_scale[psDev->Reg.ctrl1.odr];
+		psB->FTH = psDev->Reg.fifo_ctrl.fth;
+		psB->LatencyUS = LatencyUS;
+		u64_t SaveNow = lis2hh12SimNow;
+		lis2hh12InstSnapshot(psDev, NULL, true);
+		lis2hh12_replay_t sRep = { .psSim = &sBenchSim, .cbStep = lis2hh12BenchDrain, .Tsim = lis2hh12TIME() };
+		BenchSamples = 0;
+		lis2hh12ReplayRun(&sRep, (u64_t) DurationMS * 1000ULL, 0, 1000);
+		lis2hh12_inst_t * psI = &psDev->Inst;
+		psB->Samples = BenchSamples;
+		psB->IRQs = psI->IRQok;
+		psB->FIFOtrans = psI->FIFOtrans;
+		psB->BusTrans = psI->BusTrans;
+		psB->BusBytes = psI->BusBytes;
+		psB->ModelMS = (u32_t) (sRep.Trun / 1000ULL);
+		psB->WallMS = (u32_t) (sRep.Twall / 1000ULL);
+		psB->Rate = sRep.Twall ? (u32_t) (((u64_t) BenchSamples * 1000000ULL) / sRep.Twall) : 0;
+		lis2hh12SimNow = SaveNow;
+	}
+	return erSUCCESS;
+}
+#endif
+
+/**
+ * @brief		hammer a latest sample sequence lock from the calling task with Readers tasks checking
+ * @param[in]	Readers - reader tasks, at the caller's priority on any core
+ * @return		erSUCCESS if no torn or out of order snapshot was seen, erFAILURE if one was,
+ * 				erINV_STATE if no reader task could be created
+ * @note		the writer yields a tick every 1024 updates, the only time same core readers run
+ * 				apart from preempting it, possibly mid update, on tick time slicing
+ */
+int lis2hh12LatestStress(report_t * psR, u32_t Readers, u32_t DurationMS) {
+	static lis2hh12_latest_t sL;
+	lis2hh12_stress_t sS = { .psL = &sL, .Run = 1 };
+	memset(&sL, 0, sizeof(sL));
+	u32_t Tasks = 0;
+	for (u32_t i = 0; i < Readers; ++i) {
+		if (xTaskCreate(lis2hh12StressTask, "lis2hh12rd", 2048, &sS, uxTaskPriorityGet(NULL), NULL) == pdPASS) ++Tasks;
+	}
+	if (Tasks == 0)									return erINV_STATE;
+	i64_t Tend = esp_timer_get_time() + (i64_t) DurationMS * 1000LL;
+	u32_t N = 0;
+	while (esp_timer_get_time() < Tend) {
+		++N;
+		lis2hh12_xyz_t XYZ = { .X = (i16_t) N, .Y = (i16_t) ~N, .Z = (i16_t) (N * 7) };
+		lis2hh12LatestPut(&sL, &XYZ, ((u64_t) N << 32) | N, (u8_t) N, (u8_t) ~N);
+		if ((N & 1023) == 0) vTaskDelay(1);
+	}
+	__atomic_store_n(&sS.Run, 0, __ATOMIC_RELAXED);
+	while (__atomic_load_n(&sS.Done, __ATOMIC_ACQUIRE) < Tasks) vTaskDelay(1);
+	xReport(psR, "\tSEQLOCK Readers=%lu  Writes=%lu  Reads=%lu  Torn=%lu  Backward=%lu  Busy=%lu" strNL,
+		Tasks, N, sS.Reads, sS.Torn, sS.Back, sS.Busy);
+	return (sS.Torn || sS.Back) ? erFAILURE : erSUCCESS;
+}
+
+/**
+ * @brief		transport throughput, measured on the current transport and modelled for I2C and SPI
+ * @param[in]	Iter - FIFO service cycles (status burst + FTH sample burst) to time, 0 = 256
+ * @param[in]	FTH - samples per burst, 0 = current watermark or 1 if none
+ * @return		erSUCCESS, erINV_PARA or the first bus error
+ * @note		reads OUT_x, popping FIFO entries, run with the device otherwise idle. The sensor count
+ * 				is how many devices at 800Hz one bus could service if it did nothing else.
+ */
+int lis2hh12BenchBus(report_t * psR, lis2hh12_t * psDev, u32_t Iter, u8_t FTH) {
+	if (psDev == NULL || FTH > lis2hh12FIFO_DEPTH)	return erINV_PARA;
+#if (lis2hh12SPI > 0)
+	const lis2hh12_bus_t * const psSPI = &lis2hh12BusSPI;
+#else
+	static const lis2hh12_bus_t sSPI = { .pcName = "SPI", .Hz = lis2hh12SPI_HZ, .BitsPerByte = 8, .AddrBytes = 0, .FrameBits = 2 };
+	const lis2hh12_bus_t * const psSPI = &sSPI;		// wire model only, transport not built
+#endif
+	const lis2hh12_bus_t * const BusList[2] = { &lis2hh12BusI2C, psSPI };
+	if (Iter == 0) Iter = 256;
+	if (FTH == 0) FTH = psDev->Reg.fifo_ctrl.fth ? psDev->Reg.fifo_ctrl.fth : 1;
+	u8_t Src[lis2hh12IG_SRC2 - lis2hh12FIFO_SRC + 1];
+	lis2hh12_xyz_t XYZ[lis2hh12FIFO_DEPTH];
+	const size_t XYZSize = FTH * sizeof(lis2hh12_xyz_t);
+	int iRV = erSUCCESS;
+	u64_t T0 = esp_timer_get_time();
+	for (u32_t i = 0; i < Iter && iRV == erSUCCESS; ++i) {
+		iRV = lis2hh12ReadRegs(psDev, lis2hh12FIFO_SRC, Src, sizeof(Src));
+		if (iRV == erSUCCESS) iRV = lis2hh12ReadRegs(psDev, lis2hh12OUT_X_L, (u8_t *) XYZ, XYZSize);
+	}
+	if (iRV < erSUCCESS)							return iRV;
+	u32_t CycNS = (u32_t) (((esp_timer_get_time() - T0) * 1000ULL) / Iter);
+	xReport(psR, "{\"bench\":\"lis2hh12_bus\",\"schema\":%d,\"fth\":%hhu,\"iter\":%lu,"
+		"\"measured\":{\"bus\":\"%s\",\"cycle_ns\":%lu,\"sample_ns\":%lu},\"model\":[", lis2hh12BENCH_SCHEMA, FTH,
+		Iter, psDev->psBus ? psDev->psBus->pcName : "-", CycNS, CycNS / FTH);
+	for (int i = 0; i < 2; ++i) {						// bus time only, software overhead excluded
+		const lis2hh12_bus_t * psBus = BusList[i];
+		u32_t Bits = lis2hh12BusBits(psBus, 1, sizeof(Src)) + lis2hh12BusBits(psBus, 1, XYZSize);
+		u32_t NS = (u32_t) (((u64_t) Bits * 1000000000ULL) / psBus->Hz);
+		xReport(psR, "%s{\"bus\":\"%s\",\"hz\":%lu,\"cycle_bits\":%lu,\"cycle_ns\":%lu,\"sample_ns\":%lu,"
+			"\"samples_per_s\":%lu,\"sensors_800hz\":%lu}", i ? "," : "", psBus->pcName, psBus->Hz, Bits, NS, NS / FTH,
+			(u32_t) ((1000000000ULL * FTH) / NS), (u32_t) ((1000000000ULL * FTH) / ((u64_t) NS * odr_scale[lis2hh12_odr800])));
+	}
+	xReport(psR, "]}" strNL);
+	return erSUCCESS;
+}
+
+/**
+ * @brief		results as a single line JSON object, fixed point per sample ratios x1000
+ */
+int lis2hh12ReportBench(report_t * psR, lis2hh12_bench_t * psB) {
+	u32_t N = psB->Samples ? psB->Samples : 1;
+	return xReport(psR, "{\"bench\":\"lis2hh12\",\"schema\":%d,\"iter\":%lu,"
+		"\"conv\":{\"cyc\":%lu,\"ns\":%lu,\"coord_ps_per_sample\":%lu,\"q16_ps_per_sample\":%lu,\"f32_ps_per_sample\":%lu},\"enc\":{\"ps_per_sample\":%lu,\"bytes_per_ksample\":%lu},\"irq1\":{\"cyc\":%lu,\"ns\":%lu},\"report\":{\"us\":%lu,\"bytes\":%lu},"
+		"\"drain\":{\"odr\":%lu,\"fth\":%lu,\"latency_us\":%lu,\"samples\":%lu,\"irqs\":%lu,\"fifo_trans\":%lu,"
+		"\"bus_trans\":%lu,\"bus_bytes\":%lu,\"trans_per_ksample\":%lu,\"bytes_per_ksample\":%lu},"
+		"\"e2e\":{\"model_ms\":%lu,\"wall_ms\":%lu,\"samples_per_s\":%lu}}" strNL,
+		lis2hh12BENCH_SCHEMA, psB->Iter, psB->ConvCyc, psB->ConvNS, psB->CoordPS, psB->BlkQ16PS, psB->BlkF32PS, psB->EncPS, psB->EncBpkS, psB->Irq1Cyc, psB->Irq1NS, psB->RptUS, psB->RptBytes,
+		psB->ODR, psB->FTH, psB->LatencyUS, psB->Samples, psB->IRQs, psB->FIFOtrans, psB->BusTrans, psB->BusBytes,
+		(u32_t) (((u64_t) psB->BusTrans * 1000ULL) / N), (u32_t) (((u64_t) psB->BusBytes * 1000ULL) / N),
+		psB->ModelMS, psB->WallMS, psB->Rate);
+}
+
+#endif
@@ -0,0 +1,158 @@
+// lis2hh12_cal.c - Copyright (c) 2022-24 Andre M. Maree / KSS Technologies (Pty) Ltd.
+
+#include "hal_platform.h"
+
+#if (HAL_LIS2HH12 > 0)
+#include "hal_i2c_common.h"
+#include "lis2hh12.h"
+#include "report.h"
+#include "errors_events.h"
+
+// ############################################# Macros ############################################
+
+#define	debugFLAG					0xF000
+#define	debugTIMING					(debugFLAG_GLOBAL & debugFLAG & 0x1000)
+#define	debugTRACK					(debugFLAG_GLOBAL & debugFLAG & 0x2000)
+#define	debugPARAM					(debugFLAG_GLOBAL & debugFLAG & 0x4000)
+#define	debugRESULT					(debugFLAG_GLOBAL & debugFLAG & 0x8000)
+
+#define	lis2hh12CAL_Q16(f)			((i32_t) ((f) * 65536.0f + ((f) < 0 ? -0.5f : 0.5f)))
+
+// ######################################### Constants #############################################
+
+static const f32_t SixPosRef[6][3] = {					// +X, -X, +Y, -Y, +Z, -Z facing up
+	{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+};
+
+// #################################### Local ONLY functions #######################################
+
+/**
+ * @brief		solve N.X = R in place, Gauss-Jordan with partial pivoting
+ * @param[in]	N - 4x4 normal matrix, R - 4x3 right hand sides, X returned in R
+ * @return		erSUCCESS or erINV_PARA if singular (orientations do not span all 3 axes)
+ */
+static int lis2hh12CalSolve(f32_t N[4][4], f32_t R[4][3]) {
+	for (int c = 0; c < 4; ++c) {
+		int p = c;
+		for (int r = c + 1; r < 4; ++r) if (fabsf(N[r][c]) > fabsf(N[p][c])) p = r;
+		if (fabsf(N[p][c]) < 1e-6f * fabsf(N[3][3]))	return erINV_PARA;
+		for (int k = 0; k < 4; ++k) { f32_t T = N[c][k]; N[c][k] = N[p][k]; N[p][k] = T; }
+		for (int k = 0; k < 3; ++k) { f32_t T = R[c][k]; R[c][k] = R[p][k]; R[p][k] = T; }
+		f32_t D = N[c][c];
+		for (int k = 0; k < 4; ++k) N[c][k] /= D;
+		for (int k = 0; k < 3; ++k) R[c][k] /= D;
+		for (int r = 0; r < 4; ++r) {
+			if (r == c || N[r][c] == 0.0f)			continue;
+			f32_t F = N[r][c];
+			for (int k = 0; k < 4; ++k) N[r][k] -= F * N[c][k];
+			for (int k = 0; k < 3; ++k) R[r][k] -= F * R[c][k];
+		}
+	}
+	return erSUCCESS;
+}
+
+// ###################################### Public functions #########################################
+
+/**
+ * @brief		least squares fit of the sensor model s = A.g + b over static orientations
+ * @param[in]	pMeas - per orientation X/Y/Z averages in nominal mG, e.g. lis2hh12_stat window means
+ * @param[in]	pRef - matching gravity vectors in G in the device frame, e.g. from a fixture
+ * @param[in]	Count - orientations, at least 4 spanning all axes, 6 or more recommended
+ * @return		erSUCCESS, erINV_PARA if the orientations do not determine A & b
+ * @note		inverted into the correction mG = M.s - B with M = 1000.inv(A) & B = M.b
+ */
+int lis2hh12CalFit(lis2hh12_cal_t * psCal, const f32_t (* pMeas)[3], const f32_t (* pRef)[3], size_t Count) {
+	if (Count < 4)									return erINV_PARA;
+	f32_t N[4][4] = { 0 }, P[4][3] = { 0 };
+	for (size_t k = 0; k < Count; ++k) {				// normal equations, x = [ref 1]
+		f32_t X[4] = { pRef[k][0], pRef[k][1], pRef[k][2], 1.0f };
+		for (int r = 0; r < 4; ++r) {
+			for (int c = 0; c < 4; ++c) N[r][c] += X[r] * X[c];
+			for (int i = 0; i < 3; ++i) P[r][i] += X[r] * pMeas[k][i];
+		}
+	}
+	int iRV = lis2hh12CalSolve(N, P);
+	if (iRV < erSUCCESS)							return iRV;
+	f32_t A[3][3], b[3];								// P[j][i] = A[i][j], P[3][i] = b[i]
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) A[i][j] = P[j][i];
+		b[i] = P[3][i];
+	}
+	f32_t Det = A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1]) - A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0]) +
+				A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+	if (fabsf(Det) < 1.0f)							return erINV_PARA;	// nominal 1e9 mG^3/G^3
+	f32_t M[3][3] = {
+		{ A[1][1] * A[2][2] - A[1][2] * A[2][1], A[0][2] * A[2][1] - A[0][1] * A[2][2], A[0][1] * A[1][2] - A[0][2] * A[1][1] },
+		{ A[1][2] * A[2][0] - A[1][0] * A[2][2], A[0][0] * A[2][2] - A[0][2] * A[2][0], A[0][2] * A[1][0] - A[0][0] * A[1][2] },
+		{ A[1][0] * A[2][1] - A[1][1] * A[2][0], A[0][1] * A[2][0] - A[0][0] * A[2][1], A[0][0] * A[1][1] - A[0][1] * A[1][0] },
+	};
+	memset(psCal, 0, sizeof(lis2hh12_cal_t));
+	for (int i = 0; i < 3; ++i) {
+		f32_t B = 0.0f;
+		for (int j = 0; j < 3; ++j) {
+			M[i][j] *= 1000.0f / Det;
+			B += M[i][j] * b[j];
+			psCal->M[i][j] = lis2hh12CAL_Q16(M[i][j]);
+		}
+		psCal->B[i] = lis2hh12CAL_Q16(B);
+	}
+	f32_t Sum = 0.0f;									// residual of the corrected fit points
+	for (size_t k = 0; k < Count; ++k) {
+		for (int i = 0; i < 3; ++i) {
+			f32_t E = -1000.0f * pRef[k][i];
+			for (int j = 0; j < 3; ++j) E += M[i][j] * (pMeas[k][j] - b[j]);
+			Sum += E * E;
+		}
+	}
+	f32_t Res = sqrtf(Sum / (f32_t) (Count * 3));
+	psCal->ResMG = (Res > 65535.0f) ? 65535 : (u16_t) (Res + 0.5f);
+	psCal->Points = (Count > 255) ? 255 : Count;
+	psCal->Valid = 1;
+	return erSUCCESS;
+}
+
+/**
+ * @brief		6 position calibration, each axis in turn facing up then down
+ * @param[in]	pMeas - 6 averages in nominal mG, order +X, -X, +Y, -Y, +Z, -Z up
+ */
+int lis2hh12CalSixPos(lis2hh12_cal_t * psCal, const f32_t (* pMeas)[3]) {
+	return lis2hh12CalFit(psCal, pMeas, SixPosRef, 6);
+}
+
+/**
+ * @brief		attach a calibration to a device, NULL to return to the nominal scale
+ * @return		erSUCCESS or erINV_PARA if the calibration is not valid
+ * @note		takes effect on the next lis2hh12ConvBlock*() call, re-fused on every FS change
+ */
+int lis2hh12CalApply(lis2hh12_t * psDev, lis2hh12_cal_t * psCal) {
+	if (psCal && psCal->Valid == 0)					return erINV_PARA;
+	psDev->psCal = psCal;
+	psDev->ScaleFS = 0xFF;								// force rescale & fuse
+	return erSUCCESS;
+}
+
+/**
+ * @brief		fold the current FS scale into the calibration, called on scale change only
+ */
+void lis2hh12CalFuse(lis2hh12_t * psDev) {
+	lis2hh12_cal_t * psCal = psDev->psCal;
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			psDev->CalK[i * 3 + j] = (i32_t) (((i64_t) psCal->M[i][j] * psDev->ScaleQ16 + 0x8000) >> 16);
+			psDev->CalKF[i * 3 + j] = (f32_t) psCal->M[i][j] * psDev->ScaleG / 65536.0f;
+		}
+		psDev->CalO[i] = -psCal->B[i];
+		psDev->CalOF[i] = (f32_t) -psCal->B[i] / 65536000.0f;
+	}
+}
+
+int lis2hh12ReportCal(report_t * psR, lis2hh12_cal_t * psCal) {
+	if (psCal->Valid == 0)							return xReport(psR, "\tCAL none" strNL);
+	int iRV = xReport(psR, "\tCAL Points=%hhu  Residual=%humG", psCal->Points, psCal->ResMG);
+	for (int i = 0; i < 3; ++i) {
+		iRV += xReport(psR, "  %c=[%ld %ld %ld]-%ld", 'X' + i, psCal->M[i][0], psCal->M[i][1], psCal->M[i][2], psCal->B[i] >> 16);
+	}
+	return iRV + xReport(psR, strNL);
+}
+
+#endif
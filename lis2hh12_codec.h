@@ -0,0 +1,79 @@
+// lis2hh12_codec.h - Copyright (c) 2022-24 Andre M. Maree/KSS Technologies (Pty) Ltd.
+//
+// Recording codec, standard C only: no HAL, FreeRTOS or driver dependencies so host tools can link
+// lis2hh12_codec.c on its own. lis2hh12EncHeader() in the driver fills the header from a device.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ######################################## Enumerations ###########################################
+
+enum { lis2hh12_codecOK = 0, lis2hh12_codecINV_PARA = -1, lis2hh12_codecNO_SPACE = -2, lis2hh12_codecINV_SIZE = -3 };
+
+// ######################################### Structures ############################################
+
+typedef union {										// OUT_X/Y/Z or single FIFO entry
+	struct { int16_t X; int16_t Y; int16_t Z; };
+	int16_t Axis[3];
+} lis2hh12_xyz_t;
+_Static_assert(sizeof(lis2hh12_xyz_t) == 6, "lis2hh12_xyz_t");
+
+typedef struct {
+	uint64_t TS;					// sample time in uSec
+	lis2hh12_xyz_t XYZ;
+	uint16_t Gap;					// samples lost immediately before this one, saturates at 0xFFFF
+} lis2hh12_sample_t;
+_Static_assert(sizeof(lis2hh12_sample_t) == 16, "lis2hh12_sample_t");
+
+typedef struct __attribute__((packed)) {	// recording header, little endian
+	uint8_t Magic[4];				// "L2HH"
+	uint8_t Version;
+	uint8_t Size;					// header bytes, later versions append fields
+	uint8_t CTRL1, CTRL4, CTRL5, FIFO_CTRL;	// shadow registers at start of recording
+	uint16_t SyncEvery;				// samples between sync points
+	uint32_t ScaleQ16;				// mG/LSb Q16
+	uint32_t PeriodQ8;				// nominal uSec/sample Q8
+	uint16_t REF[3];				// X/Y/Z_REF high pass reference
+	uint64_t TS;					// uSec, first sample
+} lis2hh12_enc_hdr_t;
+_Static_assert(sizeof(lis2hh12_enc_hdr_t) == 34, "lis2hh12_enc_hdr_t");
+
+typedef struct {						// streaming encoder state
+	uint8_t * pBuf;					// output, caller drains Len bytes when EncBlock() stops short
+	size_t Size, Len;
+	lis2hh12_xyz_t Prev, Prev2;		// last two samples encoded
+	uint64_t SyncTS;				// uSec, last sync point
+	uint32_t PeriodQ8;				// uSec/sample Q8, measured between sync points
+	uint16_t SyncEvery, Since;		// samples between / since sync points, Since = SyncEvery forces one
+	uint32_t Samples;				// encoded in total
+} lis2hh12_enc_t;
+
+typedef struct {						// decoder state
+	const uint8_t * pBuf;
+	size_t Len, Pos;
+	lis2hh12_enc_hdr_t Hdr;
+	lis2hh12_xyz_t Prev, Prev2;
+	uint64_t SyncTS;
+	uint32_t PeriodQ8;
+	uint32_t Since;					// samples since sync point
+	uint32_t Resync;				// bytes skipped hunting for a sync point
+	uint8_t Synced;
+} lis2hh12_dec_t;
+
+// ###################################### Public functions #########################################
+
+int lis2hh12EncInit(lis2hh12_enc_t * psEnc, uint8_t * pBuf, size_t Size, uint16_t SyncEvery);
+int lis2hh12EncStart(lis2hh12_enc_t * psEnc, const lis2hh12_enc_hdr_t * psHdr);
+size_t lis2hh12EncBlock(lis2hh12_enc_t * psEnc, const lis2hh12_sample_t * psS, size_t Count);
+int lis2hh12DecInit(lis2hh12_dec_t * psDec, const uint8_t * pBuf, size_t Len);
+int lis2hh12DecBlock(lis2hh12_dec_t * psDec, lis2hh12_sample_t * psS, size_t Max);
+
+#ifdef __cplusplus
+}
+#endif
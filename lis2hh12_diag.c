@@ -0,0 +1,129 @@
+// lis2hh12_diag.c - Copyright (c) 2022-24 Andre M. Maree / KSS Technologies (Pty) Ltd.
+
+#include "hal_platform.h"
+
+#if (HAL_LIS2HH12 > 0)
+#include "hal_i2c_common.h"
+#include "lis2hh12.h"
+#include "report.h"
+#include "errors_events.h"
+
+// ############################################# Macros ############################################
+
+#define	debugFLAG					0xF000
+#define	debugTIMING					(debugFLAG_GLOBAL & debugFLAG & 0x1000)
+#define	debugTRACK					(debugFLAG_GLOBAL & debugFLAG & 0x2000)
+#define	debugPARAM					(debugFLAG_GLOBAL & debugFLAG & 0x4000)
+#define	debugRESULT					(debugFLAG_GLOBAL & debugFLAG & 0x8000)
+
+#define	lis2hh12ST_NEED				(lis2hh12ST_DISCARD + lis2hh12ST_SAMPLES)
+#define	lis2hh12ST_ODR				lis2hh12_odr800		// fastest rate, whole test well below 100mS
+
+// #################################### Local ONLY functions #######################################
+
+/**
+ * @brief		restart FIFO collection at the current self test setting, average one burst
+ * @param[in]	CTRL5 - value to write, self test sign included
+ * @param[out]	pMG - X/Y/Z averages in mG at +-2G
+ * @return		erSUCCESS, erFAILURE if the FIFO did not fill in time, else bus error code
+ * @note		restarting the FIFO after the change makes the discarded samples the settling time
+ */
+static int lis2hh12StPhase(lis2hh12_t * psDev, u8_t CTRL5, i16_t * pMG) {
+	int iRV = lis2hh12WriteReg(psDev, lis2hh12CTRL5, NULL, CTRL5);
+	if (iRV < erSUCCESS)							return iRV;
+	iRV = lis2hh12WriteReg(psDev, lis2hh12FIFO_CTRL, NULL, makeFIFOC(fmBYPASS, 0));	// empty FIFO
+	if (iRV < erSUCCESS)							return iRV;
+	iRV = lis2hh12WriteReg(psDev, lis2hh12FIFO_CTRL, NULL, makeFIFOC(fmFIFO, 0));	// collect until full
+	if (iRV < erSUCCESS)							return iRV;
+	u64_t T0 = lis2hh12TIME();
+	u64_t Tmax = 2ULL * lis2hh12ST_NEED * 1000000ULL / odr_scale[lis2hh12ST_ODR] + 10000ULL;
+	lis2hh12_fifo_src_t sSrc;
+	while (1) {
+		iRV = lis2hh12ReadRegs(psDev, lis2hh12FIFO_SRC, (u8_t *) &sSrc, sizeof(sSrc));
+		if (iRV < erSUCCESS)						return iRV;
+		if (sSrc.ovr || sSrc.fss >= lis2hh12ST_NEED)	break;
+		if (lis2hh12TIME() - T0 > Tmax)				return erFAILURE;
+		vTaskDelay(1);
+	}
+	lis2hh12_xyz_t XYZ[lis2hh12ST_NEED];
+	iRV = lis2hh12ReadRegs(psDev, lis2hh12OUT_X_L, (u8_t *) XYZ, sizeof(XYZ));	// OUT_Z_H wraps to next entry
+	if (iRV < erSUCCESS)							return iRV;
+	for (int a = 0; a < 3; ++a) {
+		i32_t Sum = 0;
+		for (int i = lis2hh12ST_DISCARD; i < lis2hh12ST_NEED; ++i) Sum += XYZ[i].Axis[a];
+		pMG[a] = (i16_t) (((i64_t) Sum * fs_q16[lis2hh12_fs2G]) / ((i64_t) lis2hh12ST_SAMPLES << 16));
+	}
+	return erSUCCESS;
+}
+
+// ###################################### Public functions #########################################
+
+/**
+ * @brief		built in self test, electrostatic force on the proof mass in both directions
+ * @param[out]	psST - averages with self test off/positive/negative and per axis pass/fail
+ * @return		erSUCCESS if every axis changed within lis2hh12ST_MIN_MG..lis2hh12ST_MAX_MG both ways,
+ * 				erFAILURE if not (or the FIFO failed to fill), else bus error code
+ * @note		runs at 800Hz, +-2G, filters off with one FIFO burst per phase, ~90mS in total. INTx
+ * 				routing is disabled throughout, the configuration is restored from the device's own
+ * 				registers afterwards and sample timing relocks. Run with the device otherwise idle.
+ */
+int lis2hh12SelfTest(lis2hh12_t * psDev, lis2hh12_st_t * psST) {
+	u8_t Save[lis2hh12CTRL7 - lis2hh12CTRL1 + 1];
+	u8_t SaveFIFO;
+	memset(psST, 0, sizeof(lis2hh12_st_t));
+	u64_t T0 = lis2hh12TIME();
+	int iRV = lis2hh12ReadRegs(psDev, lis2hh12CTRL1, Save, sizeof(Save));
+	if (iRV < erSUCCESS)							return iRV;
+	iRV = lis2hh12ReadRegs(psDev, lis2hh12FIFO_CTRL, &SaveFIFO, sizeof(SaveFIFO));
+	if (iRV < erSUCCESS)							return iRV;
+	#define SAVE(r)	Save[(r) - lis2hh12CTRL1]
+	SAVE(lis2hh12CTRL5) &= 0xB3;						// soft_reset self clearing, st always off
+	SAVE(lis2hh12CTRL6) &= 0x7F;						// boot self clearing
+	u8_t TestC5 = SAVE(lis2hh12CTRL5) & 0x83;			// keep debug & INT polarity/drive, no decimation or st
+	u8_t Test[sizeof(Save)] = {
+		makeCTRL1(0,lis2hh12ST_ODR,1,1,1,1), makeCTRL2(0,0,0,0,0), makeCTRL3(1,0,0,0,0,0,0,0),
+		(SAVE(lis2hh12CTRL4) & 0x03) | makeCTRL4(0,lis2hh12_fs2G,0,1,0,0),	// keep I2C disable & 3 wire SPI
+		TestC5, makeCTRL6(0,0,0,0,0,0,0), SAVE(lis2hh12CTRL7),
+	};
+	iRV = lis2hh12WriteRegs(psDev, lis2hh12CTRL1, Test, sizeof(Test));
+	if (iRV == erSUCCESS) iRV = lis2hh12StPhase(psDev, TestC5, psST->Base);
+	if (iRV == erSUCCESS) iRV = lis2hh12StPhase(psDev, TestC5 | (1 << 2), psST->Pos);
+	if (iRV == erSUCCESS) iRV = lis2hh12StPhase(psDev, TestC5 | (2 << 2), psST->Neg);
+	// restore, even after a failed phase, FIFO emptied before the original mode resumes
+	int iRV2 = lis2hh12WriteReg(psDev, lis2hh12FIFO_CTRL, NULL, makeFIFOC(fmBYPASS, 0));
+	if (iRV2 == erSUCCESS) iRV2 = lis2hh12WriteRegs(psDev, lis2hh12CTRL1, Save, sizeof(Save));
+	if (iRV2 == erSUCCESS) iRV2 = lis2hh12WriteRegs(psDev, lis2hh12FIFO_CTRL, &SaveFIFO, sizeof(SaveFIFO));
+	if (iRV2 == erSUCCESS) {
+		memcpy(&psDev->Reg.CTRL1, Save, sizeof(Save));
+		psDev->Reg.FIFO_CTRL = SaveFIFO;
+	}
+	#undef SAVE
+	psDev->Clk.Next = 0;								// sampling restarted, relock
+	if (psDev->psDsp) lis2hh12DspReset(psDev->psDsp);
+	psST->DurUS = (u32_t) (lis2hh12TIME() - T0);
+	if (iRV < erSUCCESS)							return iRV;
+	if (iRV2 < erSUCCESS)							return iRV2;
+	for (int a = 0; a < 3; ++a) {
+		i32_t dPos = psST->Pos[a] - psST->Base[a];
+		i32_t dNeg = psST->Base[a] - psST->Neg[a];
+		if (dPos < 0) dPos = -dPos;
+		if (dNeg < 0) dNeg = -dNeg;
+		if (!INRANGE(lis2hh12ST_MIN_MG, dPos, lis2hh12ST_MAX_MG)) psST->Fail |= 1 << a;
+		if (!INRANGE(lis2hh12ST_MIN_MG, dNeg, lis2hh12ST_MAX_MG)) psST->Fail |= 8 << a;
+	}
+	psST->Done = 1;
+	return psST->Fail ? erFAILURE : erSUCCESS;
+}
+
+int lis2hh12ReportSelfTest(report_t * psR, lis2hh12_st_t * psST) {
+	if (psST->Done == 0)							return xReport(psR, "\tSELFTEST none" strNL);
+	int iRV = xReport(psR, "\tSELFTEST %s %lumS (%d..%dmG)", psST->Fail ? "FAIL" : "PASS", psST->DurUS / 1000,
+		lis2hh12ST_MIN_MG, lis2hh12ST_MAX_MG);
+	for (int a = 0; a < 3; ++a) {
+		iRV += xReport(psR, "  %c=%d +%d%s -%d%s", 'X' + a, psST->Base[a], psST->Pos[a] - psST->Base[a],
+			(psST->Fail & (1 << a)) ? "!" : "", psST->Base[a] - psST->Neg[a], (psST->Fail & (8 << a)) ? "!" : "");
+	}
+	return iRV + xReport(psR, strNL);
+}
+
+#endif
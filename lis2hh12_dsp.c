@@ -0,0 +1,127 @@
+// lis2hh12_dsp.c - Copyright (c) 2022-24 Andre M. Maree / KSS Technologies (Pty) Ltd.
+
+#include "hal_platform.h"
+
+#if (HAL_LIS2HH12 > 0)
+#include "hal_i2c_common.h"
+#include "lis2hh12.h"
+#include "report.h"
+#include "errors_events.h"
+
+#include "esp_cpu.h"
+
+// ############################################# Macros ############################################
+
+#define	debugFLAG					0xF000
+#define	debugTIMING					(debugFLAG_GLOBAL & debugFLAG & 0x1000)
+#define	debugTRACK					(debugFLAG_GLOBAL & debugFLAG & 0x2000)
+#define	debugPARAM					(debugFLAG_GLOBAL & debugFLAG & 0x4000)
+#define	debugRESULT					(debugFLAG_GLOBAL & debugFLAG & 0x8000)
+
+#define lis2hh12Q14(x)				((i32_t) ((x) * 16384.0f + ((x) < 0 ? -0.5f : 0.5f)))
+
+// #################################### Local ONLY functions #######################################
+
+static inline i16_t DspSat16(i32_t Val) { return (Val > INT16_MAX) ? INT16_MAX : (Val < INT16_MIN) ? INT16_MIN : Val; }
+
+// ###################################### Public functions #########################################
+
+/**
+ * @brief		initialise filter chain, removing all biquads and clearing state
+ * @param[in]	Decim - output 1 of every Decim samples, 1..255
+ * @param[in]	DCshift - DC removal time constant 2^DCshift samples, 0 = off, max 15
+ * @return		erSUCCESS or erINV_PARA
+ */
+int lis2hh12DspInit(lis2hh12_dsp_t * psDsp, u8_t Decim, u8_t DCshift) {
+	if (Decim == 0 || DCshift > 15)					return erINV_PARA;
+	memset(psDsp, 0, sizeof(lis2hh12_dsp_t));
+	psDsp->Decim = Decim;
+	psDsp->DCshift = DCshift;
+	return erSUCCESS;
+}
+
+/**
+ * @brief		append a biquad designed with the RBJ cookbook formulae, quantised to Q14
+ * @param[in]	Fs - sample rate (ODR) in Hz, Fc - corner/centre in Hz, Q - quality (0.7071 = Butterworth)
+ * @return		erSUCCESS, erINV_PARA if out of range or no free stage
+ * @note		for decimation the anti alias low pass Fc should be below Fs / (2 * Decim)
+ */
+int lis2hh12DspAddFilter(lis2hh12_dsp_t * psDsp, lis2hh12_bq_type_t Type, f32_t Fs, f32_t Fc, f32_t Q) {
+	if (psDsp->NumBQ == lis2hh12DSP_BIQUADS || Fc <= 0 || Fc >= Fs / 2 || Q <= 0)	return erINV_PARA;
+	f32_t W0 = 2.0f * (f32_t) M_PI * Fc / Fs, C = cosf(W0), Alpha = sinf(W0) / (2.0f * Q);
+	f32_t A0 = 1.0f + Alpha, b0, b1, b2;
+	switch (Type) {
+	case lis2hh12_bqLOPASS:		b1 = 1.0f - C;	b0 = b2 = b1 / 2.0f;			break;
+	case lis2hh12_bqHIPASS:		b1 = -(1.0f + C); b0 = b2 = -b1 / 2.0f;		break;
+	case lis2hh12_bqBANDPASS:	b0 = Alpha;	b1 = 0.0f;	b2 = -Alpha;		break;
+	case lis2hh12_bqNOTCH:		b0 = b2 = 1.0f;	b1 = -2.0f * C;				break;
+	default:					return erINV_PARA;
+	}
+	f32_t Coef[5] = { b0 / A0, b1 / A0, b2 / A0, -2.0f * C / A0, (1.0f - Alpha) / A0 };
+	lis2hh12_bq_t * psBQ = &psDsp->BQ[psDsp->NumBQ];
+	i16_t * pI16 = &psBQ->b0;
+	for (int i = 0; i < 5; ++i) {
+		if (Coef[i] >= 2.0f || Coef[i] < -2.0f)		return erINV_PARA;	// outside Q14 range
+		pI16[i] = lis2hh12Q14(Coef[i]);
+	}
+	memset(psDsp->Z[psDsp->NumBQ], 0, sizeof(psDsp->Z[0]));
+	++psDsp->NumBQ;
+	return erSUCCESS;
+}
+
+/**
+ * @brief		clear filter history, e.g. after an ODR change or a gap in the stream
+ */
+void lis2hh12DspReset(lis2hh12_dsp_t * psDsp) {
+	memset(psDsp->DC, 0, sizeof(psDsp->DC));
+	memset(psDsp->Z, 0, sizeof(psDsp->Z));
+	psDsp->Phase = 0;
+}
+
+/**
+ * @brief		run samples through the chain in place, no allocation
+ * @return		number of output samples now at the start of psXYZ
+ */
+size_t lis2hh12DspRun(lis2hh12_dsp_t * psDsp, lis2hh12_xyz_t * psXYZ, size_t Count) {
+	u32_t Start = esp_cpu_get_cycle_count();
+	size_t Out = 0;
+	for (size_t n = 0; n < Count; ++n) {
+		i32_t X[3] = { psXYZ[n].X, psXYZ[n].Y, psXYZ[n].Z };
+		for (int a = 0; a < 3; ++a) {
+			if (psDsp->DCshift) {					// full scale step against opposite DC needs 33 bits
+				i64_t Err = (i64_t) X[a] * 65536 - psDsp->DC[a];
+				psDsp->DC[a] += (i32_t) (Err >> psDsp->DCshift);
+				X[a] -= psDsp->DC[a] >> 16;
+			}
+			for (int s = 0; s < psDsp->NumBQ; ++s) {	// direct form I, 64 bit accumulator
+				const lis2hh12_bq_t * psBQ = &psDsp->BQ[s];
+				i32_t * Z = psDsp->Z[s][a];
+				i64_t Acc = (i64_t) psBQ->b0 * X[a] + (i64_t) psBQ->b1 * Z[0] + (i64_t) psBQ->b2 * Z[1] -
+							(i64_t) psBQ->a1 * Z[2] - (i64_t) psBQ->a2 * Z[3];
+				i32_t Y = DspSat16((i32_t) (Acc >> 14));
+				Z[1] = Z[0];
+				Z[0] = X[a];
+				Z[3] = Z[2];
+				Z[2] = Y;
+				X[a] = Y;
+			}
+		}
+		if (++psDsp->Phase < psDsp->Decim) continue;
+		psDsp->Phase = 0;
+		psXYZ[Out].X = DspSat16(X[0]);
+		psXYZ[Out].Y = DspSat16(X[1]);
+		psXYZ[Out].Z = DspSat16(X[2]);
+		++Out;
+	}
+	psDsp->Samples += Count;
+	psDsp->Cycles += esp_cpu_get_cycle_count() - Start;
+	return Out;
+}
+
+int lis2hh12ReportDsp(report_t * psR, lis2hh12_dsp_t * psDsp) {
+	u32_t CpS = psDsp->Samples ? psDsp->Cycles / psDsp->Samples : 0;
+	return xReport(psR, "\tDSP Decim=%hhu  DC=%hhu  BQ=%hhu  Samples=%lu  Cycles/Sample=%lu" strNL,
+		psDsp->Decim, psDsp->DCshift, psDsp->NumBQ, psDsp->Samples, CpS);
+}
+
+#endif
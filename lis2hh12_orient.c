@@ -0,0 +1,234 @@
+// lis2hh12_orient.c - Copyright (c) 2022-24 Andre M. Maree / KSS Technologies (Pty) Ltd.
+
+#include "hal_platform.h"
+
+#if (HAL_LIS2HH12 > 0)
+#include "hal_i2c_common.h"
+#include "lis2hh12.h"
+#include "report.h"
+#include "errors_events.h"
+
+#include "esp_cpu.h"
+
+// ############################################# Macros ############################################
+
+#define	debugFLAG					0xF000
+#define	debugTIMING					(debugFLAG_GLOBAL & debugFLAG & 0x1000)
+#define	debugTRACK					(debugFLAG_GLOBAL & debugFLAG & 0x2000)
+#define	debugPARAM					(debugFLAG_GLOBAL & debugFLAG & 0x4000)
+#define	debugRESULT					(debugFLAG_GLOBAL & debugFLAG & 0x8000)
+
+// atan(r) ~ pi/4.r + r.(1-r).(0.2447 + 0.0663.r) radians, 0 <= r <= 1, |error| < 0.0015 rad
+#define	lis2hh12ATAN_C0				4500				// pi/4 in centidegrees
+#define	lis2hh12ATAN_C1				1402				// 0.2447 in centidegrees/rad
+#define	lis2hh12ATAN_C2				380					// 0.0663 in centidegrees/rad
+
+// ######################################### Constants #############################################
+
+static const char * const PosName[] = { "-", "X-", "X+", "Y-", "Y+", "Z-", "Z+" };
+
+// #################################### Local ONLY functions #######################################
+
+/**
+ * @brief		scale a vector up or down until the largest component uses 15 bits
+ * @note		each square fits i32 and any two sum below 2^31, all three only fit in u32.
+ * 				Scaling small (raw LSb or mG) vectors up keeps the Isqrt() floor below 0.01 degree.
+ */
+static void lis2hh12Fit15(i32_t * pV) {
+	u32_t Max = 0;
+	for (int a = 0; a < 3; ++a) {
+		u32_t Abs = (pV[a] < 0) ? 0U - (u32_t) pV[a] : (u32_t) pV[a];
+		if (Abs > Max) Max = Abs;
+	}
+	if (Max == 0)									return;
+	int Shift = 0;
+	while ((Max >> Shift) > 0x7FFF) ++Shift;
+	if (Shift) {
+		for (int a = 0; a < 3; ++a) pV[a] >>= Shift;
+		return;
+	}
+	while ((Max << Shift) < 0x4000) ++Shift;
+	for (int a = 0; a < 3; ++a) pV[a] = (i32_t) ((u32_t) pV[a] << Shift);
+}
+
+/**
+ * @brief		new position from a gravity vector, hysteresis keeps the current one near boundaries
+ * @note		an axis must be within ~39 degrees of vertical (sin^2 > 0.6) to become the position
+ */
+static u8_t lis2hh12OrientPos(lis2hh12_orient_t * psO, const i32_t * pV) {
+	u32_t Sum = (u32_t) (pV[0] * pV[0]) + (u32_t) (pV[1] * pV[1]) + (u32_t) (pV[2] * pV[2]);
+	for (int a = 0; a < (psO->D4 ? 2 : 3); ++a) {
+		u32_t Sq = (u32_t) (pV[a] * pV[a]);
+		if ((u64_t) Sq * 5 > (u64_t) Sum * 3)			return 2 * a + (pV[a] > 0 ? 2 : 1);
+	}
+	return psO->Pos;
+}
+
+static void lis2hh12OrientSet(lis2hh12_t * psDev, lis2hh12_orient_t * psO, u8_t Pos) {
+	if (Pos == psO->Pos)							return;
+	psO->Pos = Pos;
+	++psO->Changes;
+	if (psO->cbPos) psO->cbPos(psDev, psO);
+}
+
+// ###################################### Public functions #########################################
+
+/**
+ * @brief		integer square root, floor
+ */
+u32_t lis2hh12Isqrt(u32_t Val) {
+	u32_t Res = 0, Bit = 1UL << 30;
+	while (Bit > Val) Bit >>= 2;
+	while (Bit) {
+		if (Val >= Res + Bit) {
+			Val -= Res + Bit;
+			Res = (Res >> 1) + Bit;
+		} else {
+			Res >>= 1;
+		}
+		Bit >>= 2;
+	}
+	return Res;
+}
+
+/**
+ * @brief		four quadrant arc tangent without libm, one division & 2 multiplies
+ * @return		angle in centidegrees -18000..18000, within 0.1 degree of atan2f()
+ * @note		inputs beyond +-65535 are scaled down first, resolution follows the smaller input
+ */
+i32_t lis2hh12Atan2CD(i32_t Y, i32_t X) {
+	u32_t AX = (X < 0) ? 0U - (u32_t) X : (u32_t) X, AY = (Y < 0) ? 0U - (u32_t) Y : (u32_t) Y;	// INT32_MIN safe
+	if (AX == 0 && AY == 0)							return 0;
+	while ((AX | AY) > 0xFFFF) { AX >>= 1; AY >>= 1; }
+	bool Swap = AY > AX;
+	u32_t R = Swap ? (AX << 15) / AY : (AY << 15) / AX;	// Q15, 0..1
+	u32_t RR = (R * (32768 - R)) >> 15;				// r.(1-r)
+	i32_t A = (lis2hh12ATAN_C0 * R + RR * (lis2hh12ATAN_C1 + ((lis2hh12ATAN_C2 * R) >> 15)) + 16384) >> 15;
+	if (Swap) A = 9000 - A;
+	if (X < 0) A = 18000 - A;
+	return (Y < 0) ? -A : A;
+}
+
+/**
+ * @brief		pitch & roll from a static acceleration vector, any consistent scale
+ * @param[out]	pPitch - rotation about Y, nose (X) up positive, -9000..9000 centidegrees
+ * @param[out]	pRoll - rotation about X, -18000..18000 centidegrees
+ */
+void lis2hh12Tilt(i32_t X, i32_t Y, i32_t Z, i16_t * pPitch, i16_t * pRoll) {
+	i32_t V[3] = { X, Y, Z };
+	lis2hh12Fit15(V);
+	*pPitch = lis2hh12Atan2CD(-V[0], lis2hh12Isqrt((u32_t) (V[1] * V[1]) + (u32_t) (V[2] * V[2])));
+	*pRoll = lis2hh12Atan2CD(Y, Z);					// unscaled, Y & Z may be tiny next to X
+}
+
+/**
+ * @brief		attach an orientation stage
+ * @param[in]	IG - 0 = pitch/roll & position computed from every delivered block's mean,
+ * 				1/2 = position from IGx in 6D (D4 = 0) or 4D movement mode, routed to INT1
+ * @param[in]	ThsMG/Dur - IGx threshold (~700mG for 45 degree zones) and duration in samples
+ * @return		erSUCCESS, erINV_PARA or bus error code
+ * @note		interrupt driven mode computes nothing per sample, lis2hh12OrientNow() gives pitch &
+ * 				roll on demand. IGx is dedicated to orientation while attached.
+ */
+int lis2hh12OrientInit(lis2hh12_t * psDev, lis2hh12_orient_t * psO, u8_t IG, bool D4, u16_t ThsMG, u8_t Dur, lis2hh12_orient_cb_t cbPos) {
+	if (IG > 2)										return erINV_PARA;
+	psDev->psOrient = NULL;
+	memset(psO, 0, sizeof(lis2hh12_orient_t));
+	psO->cbPos = cbPos;
+	psO->IG = IG;
+	psO->D4 = D4;
+	if (IG) {
+		u8_t Bit = IG - 1;
+		u32_t Ths = ((u32_t) ThsMG * 256) / fs_scale[psDev->Reg.ctrl4.fs];	// 1 LSb = FS/256
+		u8_t THS = (Ths > 0xFF) ? 0xFF : Ths;
+		int iRV = lis2hh12UpdateReg(psDev, lis2hh12CTRL7, &psDev->Reg.CTRL7, ~(1 << Bit), D4 << Bit);
+		if (iRV == erSUCCESS) {
+			if (IG == 1) {
+				u8_t THS3[3] = { THS, THS, THS };
+				iRV = lis2hh12WriteRegs(psDev, lis2hh12IG_THS_X1, THS3, sizeof(THS3));
+				if (iRV == erSUCCESS) memcpy(&psDev->Reg.IG_THS_X1, THS3, sizeof(THS3));
+				if (iRV == erSUCCESS) iRV = lis2hh12WriteReg(psDev, lis2hh12IG_DUR1, &psDev->Reg.IG_DUR1, makeIGxDUR(0, Dur));
+			} else {
+				iRV = lis2hh12WriteReg(psDev, lis2hh12IG_THS2, &psDev->Reg.IG_THS2, THS);
+				if (iRV == erSUCCESS) iRV = lis2hh12WriteReg(psDev, lis2hh12IG_DUR2, &psDev->Reg.IG_DUR2, makeIGxDUR(0, Dur));
+			}
+		}
+		if (iRV == erSUCCESS) iRV = lis2hh12WriteReg(psDev, IG == 1 ? lis2hh12IG_CFG1 : lis2hh12IG_CFG2,
+			IG == 1 ? &psDev->Reg.IG_CFG1 : &psDev->Reg.IG_CFG2, makeIGxCFG(0,1,!D4,!D4,1,1,1,1));	// 6D movement
+		if (iRV == erSUCCESS) iRV = lis2hh12UpdateReg(psDev, lis2hh12CTRL3, &psDev->Reg.CTRL3, 0xFF, 1 << (3 + Bit));
+		u8_t Src;											// current zone, INTx only on changes
+		if (iRV == erSUCCESS) iRV = lis2hh12ReadRegs(psDev, IG == 1 ? lis2hh12IG_SRC1 : lis2hh12IG_SRC2, &Src, sizeof(Src));
+		if (iRV < erSUCCESS)						return iRV;
+		for (int b = 0; b < 6; ++b) {
+			if (Src & (1 << b)) { psO->Pos = b + 1; break; }
+		}
+	}
+	psDev->psOrient = psO;
+	return erSUCCESS;
+}
+
+/**
+ * @brief		computed mode stage, called by lis2hh12Deliver()
+ * @note		one conversion (calibration included) and 2 arc tangents per block, the block mean
+ * 				also averages out vibration the tilt estimate should not follow
+ */
+void lis2hh12OrientFeed(lis2hh12_t * psDev, lis2hh12_xyz_t * psXYZ, size_t Count) {
+	if (Count == 0)									return;
+	lis2hh12_orient_t * psO = psDev->psOrient;
+	u32_t Cyc = esp_cpu_get_cycle_count();
+	i32_t Sum[3] = { 0 };
+	for (size_t i = 0; i < Count; ++i) {
+		Sum[0] += psXYZ[i].X;
+		Sum[1] += psXYZ[i].Y;
+		Sum[2] += psXYZ[i].Z;
+	}
+	lis2hh12_xyz_t Mean = { .X = Sum[0] / (i32_t) Count, .Y = Sum[1] / (i32_t) Count, .Z = Sum[2] / (i32_t) Count };
+	i32_t V[3];
+	lis2hh12ConvBlockQ16(psDev, &Mean, V, 1);
+	lis2hh12Fit15(V);
+	lis2hh12Tilt(V[0], V[1], V[2], &psO->Pitch, &psO->Roll);
+	lis2hh12OrientSet(psDev, psO, lis2hh12OrientPos(psO, V));
+	++psO->Blocks;
+	psO->Cycles += esp_cpu_get_cycle_count() - Cyc;
+}
+
+/**
+ * @brief		interrupt mode stage, called from lis2hh12IntIG1/2() with the IG_SRCx just read
+ * @note		between zones (no axis beyond threshold) the previous position is kept
+ */
+void lis2hh12OrientEvent(lis2hh12_t * psDev, u8_t IG, u8_t Src) {
+	lis2hh12_orient_t * psO = psDev->psOrient;
+	if (psO->IG != IG)								return;
+	++psO->Events;
+	for (int b = 0; b < 6; ++b) {
+		if (Src & (1 << b)) {
+			lis2hh12OrientSet(psDev, psO, b + 1);
+			break;
+		}
+	}
+}
+
+/**
+ * @brief		pitch & roll of the newest sample, for interrupt driven mode
+ * @return		erSUCCESS, erINV_STATE if no stage attached or no consistent sample available
+ */
+int lis2hh12OrientNow(lis2hh12_t * psDev) {
+	lis2hh12_orient_t * psO = psDev->psOrient;
+	lis2hh12_latest_t sL;
+	if (psO == NULL || lis2hh12Latest(psDev, &sL) < erSUCCESS)	return erINV_STATE;
+	i32_t V[3];
+	lis2hh12ConvBlockQ16(psDev, &sL.XYZ, V, 1);
+	lis2hh12Tilt(V[0], V[1], V[2], &psO->Pitch, &psO->Roll);
+	return erSUCCESS;
+}
+
+int lis2hh12ReportOrient(report_t * psR, lis2hh12_orient_t * psO) {
+	u32_t CpB = psO->Blocks ? psO->Cycles / psO->Blocks : 0;
+	u16_t P = (psO->Pitch < 0) ? -psO->Pitch : psO->Pitch, R = (psO->Roll < 0) ? -psO->Roll : psO->Roll;
+	return xReport(psR, "\tORIENT %s%s Pos=%s  Pitch=%s%u.%02u  Roll=%s%u.%02u  Blocks=%lu (%lu cyc)  Events=%lu  Changes=%lu" strNL,
+		psO->IG ? (psO->IG == 1 ? "IG1 " : "IG2 ") : "", psO->D4 ? "4D" : "6D", PosName[psO->Pos],
+		psO->Pitch < 0 ? "-" : "", P / 100, P % 100, psO->Roll < 0 ? "-" : "", R / 100, R % 100,
+		psO->Blocks, CpB, psO->Events, psO->Changes);
+}
+
+#endif
@@ -0,0 +1,123 @@
+// lis2hh12_pm.c - Copyright (c) 2022-24 Andre M. Maree / KSS Technologies (Pty) Ltd.
+
+#include "hal_platform.h"
+
+#if (HAL_LIS2HH12 > 0)
+#include "hal_i2c_common.h"
+#include "lis2hh12.h"
+#include "report.h"
+#include "errors_events.h"
+
+#include "esp_timer.h"
+
+// ############################################# Macros ############################################
+
+#define	debugFLAG					0xF000
+#define	debugTIMING					(debugFLAG_GLOBAL & debugFLAG & 0x1000)
+#define	debugTRACK					(debugFLAG_GLOBAL & debugFLAG & 0x2000)
+#define	debugPARAM					(debugFLAG_GLOBAL & debugFLAG & 0x4000)
+#define	debugRESULT					(debugFLAG_GLOBAL & debugFLAG & 0x8000)
+
+// #################################### Local ONLY functions #######################################
+
+/**
+ * @brief		profile switch, runs in I2C task context behind any FIFO bursts already queued
+ * @note		samples still in the FIFO were taken at the old ODR, deliver them before changing
+ * 				rate so the timestamp estimator and DSP never mix the two rates in one block
+ * @note		only ODR and FTH change, the FIFO mode stays as the application configured it
+ */
+static void lis2hh12PmSwitch(void * Arg) {
+	lis2hh12_t * psDev = (lis2hh12_t *) Arg;
+	lis2hh12_pm_t * psPm = psDev->psPm;
+	lis2hh12_fifo_src_t sSrc = { .fss = 0 };
+	memcpy(&sSrc, &psPm->FifoSrc, sizeof(sSrc));
+	u8_t Count = sSrc.fss;
+	if (Count) {
+		lis2hh12_xyz_t XYZ[lis2hh12FIFO_DEPTH];
+		if (lis2hh12ReadRegs(psDev, lis2hh12OUT_X_L, (u8_t *) XYZ, Count * sizeof(lis2hh12_xyz_t)) == erSUCCESS) {
+			lis2hh12INST_ADD(psDev->Inst.FIFOsamples, Count);
+			lis2hh12INST_ADD(psDev->Inst.FIFOtrans, 1);
+			lis2hh12Deliver(psDev, XYZ, Count);
+		}
+	}
+	lis2hh12_pm_prof_t * psProf = &psPm->Prof[psPm->Target];
+	int iRV = lis2hh12SetODR(psDev, psProf->ODR);
+	if (iRV >= erSUCCESS) iRV = lis2hh12ConfigFIFO(psDev, psDev->Reg.fifo_ctrl.fmode, psProf->FTH);	// mode as configured
+	if (iRV >= erSUCCESS && psDev->Cached) iRV = lis2hh12Commit(psDev);
+	if (psDev->psDsp) lis2hh12DspReset(psDev->psDsp);		// filter history from the old rate
+	if (iRV < erSUCCESS) {
+		psPm->Target = psPm->State;					// retry on next service
+		return;
+	}
+	psPm->State = psPm->Target;
+	++psPm->Switches;
+}
+
+// ###################################### Public functions #########################################
+
+/**
+ * @brief		initialise power manager, hardware untouched until the first lis2hh12Service()
+ * @param[in]	IdleODR/IdleFTH - low rate with deep watermark, few wakeups while idle
+ * @param[in]	ActiveODR/ActiveFTH - full rate profile entered on IG1 motion events
+ * @param[in]	QuietMS - hysteresis, time without motion before returning to idle
+ * @return		erSUCCESS or erINV_PARA
+ * @note		IG1 must be configured as a motion (OR of high events) interrupt by the application.
+ * 				The chip's own inactivity function (lis2hh12SetInactivity) is not used, it drops to
+ * 				10Hz autonomously which the driver cannot see and would corrupt sample timing.
+ */
+int lis2hh12PmInit(lis2hh12_pm_t * psPm, lis2hh12_odr_t IdleODR, u8_t IdleFTH, lis2hh12_odr_t ActiveODR, u8_t ActiveFTH, u32_t QuietMS) {
+	if (IdleODR == lis2hh12_odr0 || ActiveODR == lis2hh12_odr0 || IdleODR > lis2hh12_odr800 || ActiveODR > lis2hh12_odr800 ||
+		IdleFTH == 0 || IdleFTH >= lis2hh12FIFO_DEPTH || ActiveFTH == 0 || ActiveFTH >= lis2hh12FIFO_DEPTH)	return erINV_PARA;
+	memset(psPm, 0, sizeof(lis2hh12_pm_t));
+	psPm->Prof[lis2hh12_pmIDLE] = (lis2hh12_pm_prof_t) { .ODR = IdleODR, .FTH = IdleFTH };
+	psPm->Prof[lis2hh12_pmACTIVE] = (lis2hh12_pm_prof_t) { .ODR = ActiveODR, .FTH = ActiveFTH };
+	psPm->QuietMS = QuietMS;
+	return erSUCCESS;
+}
+
+/**
+ * @brief		task level policy step, call periodically (100mS..1S) or when woken by IG1
+ * @return		state now requested (lis2hh12_pm_state_t) or erINV_STATE if no manager attached
+ */
+int lis2hh12Service(lis2hh12_t * psDev) {
+	lis2hh12_pm_t * psPm = psDev->psPm;
+	if (psPm == NULL)								return erINV_STATE;
+	u64_t Now = lis2hh12TIME();
+	u32_t Wake = psDev->Inst.IRQok + psDev->Inst.IRQlost;
+	u32_t Bytes = __atomic_load_n(&psDev->Inst.BusBytes, __ATOMIC_RELAXED);
+	u64_t dT = Now - psPm->MetTS;
+	if (psPm->MetTS == 0 || dT >= 1000000ULL) {				// 1 second or longer metrics window
+		if (psPm->MetTS && Wake >= psPm->MetWake && Bytes >= psPm->MetBytes) {	// skip window if counters were reset
+			psPm->WakePS = (u32_t) (((u64_t) (Wake - psPm->MetWake) * 1000000ULL) / dT);
+			psPm->BytesPS = (u32_t) (((u64_t) (Bytes - psPm->MetBytes) * 1000000ULL) / dT);
+		}
+		psPm->MetTS = Now;
+		psPm->MetWake = Wake;
+		psPm->MetBytes = Bytes;
+	}
+	u32_t IG1 = psDev->Inst.IRQig1;
+	if (IG1 != psPm->LastIG1) {
+		psPm->LastIG1 = IG1;
+		psPm->MotionTS = Now;
+	}
+	u8_t Target = (psPm->MotionTS && (Now - psPm->MotionTS) < (u64_t) psPm->QuietMS * 1000ULL) ? lis2hh12_pmACTIVE : lis2hh12_pmIDLE;
+	if (psPm->Target != psPm->State)				return psPm->Target;	// switch still queued
+	if (Target == psPm->State)						return Target;
+	psPm->Target = Target;
+	u8_t Reg = lis2hh12FIFO_SRC;
+	int iRV = lis2hh12Queue(psDev, i2cWRC, &Reg, sizeof(Reg), &psPm->FifoSrc, sizeof(psPm->FifoSrc), (i2cq_p1_t) lis2hh12PmSwitch, (i2cq_p2_t) psDev);
+	if (iRV < erSUCCESS) {
+		psPm->Target = psPm->State;					// retry on next service
+		return iRV;
+	}
+	return Target;
+}
+
+int lis2hh12ReportPm(report_t * psR, lis2hh12_pm_t * psPm) {
+	static const char * const StateName[] = { "INIT", "IDLE", "ACTIVE" };
+	lis2hh12_pm_prof_t * psProf = &psPm->Prof[psPm->State];
+	return xReport(psR, "\tPM %s ODR=%huHz FTH=%hhu Switches=%lu  Wakeups/s=%lu  BusBytes/s=%lu" strNL,
+		StateName[psPm->State], odr_scale[psProf->ODR], psProf->FTH, psPm->Switches, psPm->WakePS, psPm->BytesPS);
+}
+
+#endif
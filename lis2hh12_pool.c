@@ -0,0 +1,206 @@
+// lis2hh12_pool.c - Copyright (c) 2022-24 Andre M. Maree / KSS Technologies (Pty) Ltd.
+
+#include "hal_platform.h"
+
+#if (HAL_LIS2HH12 > 0)
+#include "hal_i2c_common.h"
+#include "lis2hh12.h"
+#include "report.h"
+#include "errors_events.h"
+
+// ############################################# Macros ############################################
+
+#define	debugFLAG					0xF000
+#define	debugTIMING					(debugFLAG_GLOBAL & debugFLAG & 0x1000)
+#define	debugTRACK					(debugFLAG_GLOBAL & debugFLAG & 0x2000)
+#define	debugPARAM					(debugFLAG_GLOBAL & debugFLAG & 0x4000)
+#define	debugRESULT					(debugFLAG_GLOBAL & debugFLAG & 0x8000)
+
+#define lis2hh12SUB_MASK			(lis2hh12SUB_DEPTH - 1)
+
+// #################################### Local ONLY functions #######################################
+
+/**
+ * @brief		remove the oldest queued block, consumer and (drop oldest) producer may race for it
+ * @return		block, ownership of its queue reference passes to the caller, or NULL if empty
+ */
+static lis2hh12_blk_t * lis2hh12SubPop(lis2hh12_sub_t * psS) {
+	u32_t Tail = __atomic_load_n(&psS->Tail, __ATOMIC_ACQUIRE);
+	while (Tail != __atomic_load_n(&psS->Head, __ATOMIC_ACQUIRE)) {
+		lis2hh12_blk_t * psB = psS->Q[Tail & lis2hh12SUB_MASK];		// only valid if the CAS succeeds
+		if (__atomic_compare_exchange_n(&psS->Tail, &Tail, Tail + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			return psB;
+	}
+	return NULL;
+}
+
+/**
+ * @brief		queue a published block to one subscriber according to its backpressure policy
+ * @note		never waits, lis2hh12_subBLOCK is applied before the burst by lis2hh12PoolHold()
+ */
+static void lis2hh12SubPush(lis2hh12_sub_t * psS, lis2hh12_blk_t * psB) {
+	u32_t Head = psS->Head;
+	if (Head - __atomic_load_n(&psS->Tail, __ATOMIC_ACQUIRE) >= lis2hh12SUB_DEPTH) {
+		if (psS->Policy == lis2hh12_subDROP_OLDEST) {
+			lis2hh12_blk_t * psOld = lis2hh12SubPop(psS);
+			if (psOld) {
+				lis2hh12BlkRelease(psOld);
+				++psS->DropOld;
+			}
+		}
+		if (Head - __atomic_load_n(&psS->Tail, __ATOMIC_ACQUIRE) >= lis2hh12SUB_DEPTH) {
+			++psS->DropNew;
+			return;
+		}
+	}
+	__atomic_fetch_add(&psB->Ref, 1, __ATOMIC_RELAXED);
+	psS->Q[Head & lis2hh12SUB_MASK] = psB;
+	__atomic_store_n(&psS->Head, Head + 1, __ATOMIC_RELEASE);
+	++psS->Pushed;
+	u32_t Used = Head + 1 - __atomic_load_n(&psS->Tail, __ATOMIC_RELAXED);
+	if (Used > psS->HiWater) psS->HiWater = Used;
+	if (psS->xTask) xTaskNotifyGive((TaskHandle_t) psS->xTask);
+}
+
+// ###################################### Public functions #########################################
+
+void lis2hh12PoolInit(lis2hh12_pool_t * psPool) { memset(psPool, 0, sizeof(lis2hh12_pool_t)); }
+
+/**
+ * @brief		claim a free block for filling, producer side only
+ * @return		block holding the producer's reference, or NULL if all are still referenced
+ */
+lis2hh12_blk_t * lis2hh12PoolAlloc(lis2hh12_pool_t * psPool) {
+	for (int i = 0; i < lis2hh12POOL_BLOCKS; ++i) {
+		lis2hh12_blk_t * psB = &psPool->Blk[(psPool->Next + i) % lis2hh12POOL_BLOCKS];
+		if (__atomic_load_n(&psB->Ref, __ATOMIC_ACQUIRE) == 0) {	// last reader done with contents
+			psB->Ref = 1;
+			psPool->Next = (psPool->Next + i + 1) % lis2hh12POOL_BLOCKS;
+			return psB;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief		pool block whose samples start at psXYZ, NULL if psXYZ is not a pool block
+ */
+lis2hh12_blk_t * lis2hh12PoolOwner(lis2hh12_pool_t * psPool, lis2hh12_xyz_t * psXYZ) {
+	for (int i = 0; i < lis2hh12POOL_BLOCKS; ++i) {
+		if (psPool->Blk[i].XYZ == psXYZ)			return &psPool->Blk[i];
+	}
+	return NULL;
+}
+
+/**
+ * @brief		hand delivered samples to every subscriber by reference, called by lis2hh12Deliver()
+ * @note		samples burst read into a pool block are published in place, those from the DRDY,
+ * 				per sample FIFO or power manager paths are copied into a block once
+ */
+void lis2hh12PoolPublish(lis2hh12_pool_t * psPool, lis2hh12_xyz_t * psXYZ, size_t Count, u64_t TS, u32_t Period, u16_t Gap) {
+	lis2hh12_blk_t * psB = lis2hh12PoolOwner(psPool, psXYZ);
+	bool Own = (psB == NULL);
+	if (Own) {
+		psB = lis2hh12PoolAlloc(psPool);
+		if (psB == NULL) {							// every block still held by slow subscribers
+			++psPool->NoBlock;
+			return;
+		}
+		memcpy(psB->XYZ, psXYZ, Count * sizeof(lis2hh12_xyz_t));
+		++psPool->Copied;
+	}
+	psB->Count = Count;
+	psB->Gap = Gap;
+	psB->TS = TS;
+	psB->Period = Period;
+	for (int i = 0; i < lis2hh12POOL_SUBS; ++i) {
+		lis2hh12_sub_t * psS = &psPool->Sub[i];
+		__atomic_fetch_add(&psS->Busy, 1, __ATOMIC_SEQ_CST);		// announced before the Active check
+		if (__atomic_load_n(&psS->Active, __ATOMIC_SEQ_CST) == 1) lis2hh12SubPush(psS, psB);
+		__atomic_fetch_sub(&psS->Busy, 1, __ATOMIC_RELEASE);
+	}
+	++psPool->Published;
+	if (Own) lis2hh12BlkRelease(psB);
+}
+
+/**
+ * @brief		backpressure from lis2hh12_subBLOCK subscribers, asked before each FIFO drain
+ * @param[in]	Level - samples waiting in the sensor FIFO
+ * @return		true to leave the samples in the sensor FIFO until a later interrupt, false to drain now
+ * @note		the sensor FIFO is the buffer, the I2C task is shared by every device on the bus and never
+ * 				waits. With the FIFO about to overrun it is drained and the block dropped for a full subscriber.
+ */
+bool lis2hh12PoolHold(lis2hh12_pool_t * psPool, u8_t Level) {
+	if (Level >= lis2hh12FIFO_DEPTH - 1)			return false;
+	for (int i = 0; i < lis2hh12POOL_SUBS; ++i) {
+		lis2hh12_sub_t * psS = &psPool->Sub[i];
+		if (__atomic_load_n(&psS->Active, __ATOMIC_ACQUIRE) != 1 || psS->Policy != lis2hh12_subBLOCK)	continue;
+		if (psS->Head - __atomic_load_n(&psS->Tail, __ATOMIC_ACQUIRE) < lis2hh12SUB_DEPTH)			continue;
+		++psS->Stalls;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * @brief		register a consumer, any task
+ * @param[in]	xTask - task to notify on each new block, NULL to poll lis2hh12SubGet()
+ * @return		subscriber number or erFAILURE if all lis2hh12POOL_SUBS are in use
+ */
+int lis2hh12Subscribe(lis2hh12_pool_t * psPool, lis2hh12_sub_policy_t Policy, void * xTask) {
+	for (int i = 0; i < lis2hh12POOL_SUBS; ++i) {
+		lis2hh12_sub_t * psS = &psPool->Sub[i];
+		u8_t Free = 0;
+		if (!__atomic_compare_exchange_n(&psS->Active, &Free, 2, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))	continue;
+		memset(psS->Q, 0, sizeof(psS->Q));
+		psS->Head = psS->Tail = 0;
+		psS->xTask = xTask;
+		psS->Policy = Policy;
+		psS->Pushed = psS->DropOld = psS->DropNew = psS->Stalls = psS->HiWater = 0;
+		__atomic_store_n(&psS->Active, 1, __ATOMIC_RELEASE);		// 2 = claimed, not yet published to
+		return i;
+	}
+	return erFAILURE;
+}
+
+/**
+ * @brief		stop delivery to a subscriber and return the blocks still queued for it
+ * @note		waits for a publish that passed the Active check before it changed to finish its push
+ */
+void lis2hh12Unsubscribe(lis2hh12_pool_t * psPool, int Sub) {
+	IF_myASSERT(debugPARAM, Sub >= 0 && Sub < lis2hh12POOL_SUBS);
+	lis2hh12_sub_t * psS = &psPool->Sub[Sub];
+	__atomic_store_n(&psS->Active, 2, __ATOMIC_SEQ_CST);
+	while (__atomic_load_n(&psS->Busy, __ATOMIC_SEQ_CST)) vTaskDelay(1);
+	lis2hh12_blk_t * psB;
+	while ((psB = lis2hh12SubPop(psS))) lis2hh12BlkRelease(psB);
+	__atomic_store_n(&psS->Active, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief		next block for a subscriber, never blocks, consumer side
+ * @return		block to be returned with lis2hh12BlkRelease() once processed, NULL if none queued
+ */
+lis2hh12_blk_t * lis2hh12SubGet(lis2hh12_pool_t * psPool, int Sub) {
+	IF_myASSERT(debugPARAM, Sub >= 0 && Sub < lis2hh12POOL_SUBS);
+	return lis2hh12SubPop(&psPool->Sub[Sub]);
+}
+
+void lis2hh12BlkRelease(lis2hh12_blk_t * psBlk) { __atomic_fetch_sub(&psBlk->Ref, 1, __ATOMIC_RELEASE); }
+
+int lis2hh12ReportPool(report_t * psR, lis2hh12_pool_t * psPool) {
+	static const char * const PolicyName[] = { "OLDEST", "NEWEST", "BLOCK" };
+	int Free = 0;
+	for (int i = 0; i < lis2hh12POOL_BLOCKS; ++i) Free += (__atomic_load_n(&psPool->Blk[i].Ref, __ATOMIC_RELAXED) == 0);
+	int iRV = xReport(psR, "\tPOOL Free=%d/%d  Published=%lu  Copied=%lu  NoBlock=%lu" strNL, Free, lis2hh12POOL_BLOCKS,
+		psPool->Published, psPool->Copied, psPool->NoBlock);
+	for (int i = 0; i < lis2hh12POOL_SUBS; ++i) {
+		lis2hh12_sub_t * psS = &psPool->Sub[i];
+		if (psS->Active == 0)						continue;
+		iRV += xReport(psR, "\t  SUB%d %s Queued=%lu  Pushed=%lu  DropOld=%lu  DropNew=%lu  Stalls=%lu  HiWater=%lu" strNL, i,
+			PolicyName[psS->Policy], psS->Head - psS->Tail, psS->Pushed, psS->DropOld, psS->DropNew, psS->Stalls, psS->HiWater);
+	}
+	return iRV;
+}
+
+#endif
@@ -0,0 +1,113 @@
+// lis2hh12_replay.c - Copyright (c) 2022-24 Andre M. Maree / KSS Technologies (Pty) Ltd.
+
+#include "hal_platform.h"
+
+#if (HAL_LIS2HH12 > 0)
+#include "hal_i2c_common.h"
+#include "lis2hh12.h"
+#include "report.h"
+#include "errors_events.h"
+
+#include "esp_timer.h"
+
+#if (lis2hh12SIM > 0)
+
+// ############################################# Macros ############################################
+
+#define	debugFLAG					0xF000
+#define	debugTIMING					(debugFLAG_GLOBAL & debugFLAG & 0x1000)
+#define	debugTRACK					(debugFLAG_GLOBAL & debugFLAG & 0x2000)
+#define	debugPARAM					(debugFLAG_GLOBAL & debugFLAG & 0x4000)
+#define	debugRESULT					(debugFLAG_GLOBAL & debugFLAG & 0x8000)
+
+// #################################### Local ONLY functions #######################################
+
+/**
+ * @brief		chip model sample source, recorded sample due at model time TS
+ * @note		recording time is anchored to the first sample the model takes, thereafter samples
+ * 				are picked nearest in time so a recording replayed at its own ODR is bit exact and
+ * 				one at a different ODR is resampled (hold or skip) as the real chip would see it
+ */
+static lis2hh12_xyz_t lis2hh12ReplayGen(lis2hh12_sim_t * psSim, u64_t TS) {
+	lis2hh12_replay_t * psRep = (lis2hh12_replay_t *) psSim->GenArg;
+	const lis2hh12_sample_t * psSrc = psRep->psSrc;
+	if (psRep->T0sim == 0) psRep->T0sim = TS;
+	u8_t ODR = (psSim->Reg[lis2hh12CTRL1] >> 4) & 7;
+	u32_t Half = (ODR && ODR <= lis2hh12_odr800) ? 500000UL / odr_scale[ODR] : 0;
+	u64_t Trec = psRep->T0rec + (TS - psRep->T0sim) + Half;
+	while (psRep->Idx + 1 < psRep->Count && psSrc[psRep->Idx + 1].TS <= Trec) ++psRep->Idx;
+	if (psRep->Loop && psRep->Idx + 1 == psRep->Count && psRep->Count > 1) {
+		u64_t Span = psSrc[psRep->Count - 1].TS - psRep->T0rec;
+		Span += Span / (psRep->Count - 1);				// last sample lasts one average period
+		if (Trec >= psRep->T0rec + Span) {				// restart, keep recording & model time aligned
+			psRep->T0sim += Span;
+			psRep->Idx = 0;
+			++psRep->Loops;
+		}
+	}
+	return psSrc[psRep->Idx].XYZ;
+}
+
+// ###################################### Public functions #########################################
+
+/**
+ * @brief		attach a recording to the chip model as its sample source
+ * @param[in]	psSrc - samples with TS in uSec and raw XYZ at the FS the model will be configured for
+ * @param[in]	Loop - restart at the end of the recording, else the last sample is held
+ * @return		erSUCCESS or erINV_PARA
+ * @note		everything downstream of the bus (FIFO_SRC fss/ovr, IG_SRC, IRQ handlers, Deliver and
+ * 				its DSP/STAT/SPEC stages, ring) runs unmodified against the model
+ */
+int lis2hh12ReplayInit(lis2hh12_replay_t * psRep, lis2hh12_sim_t * psSim, const lis2hh12_sample_t * psSrc, size_t Count, bool Loop) {
+	if (psSim == NULL || psSrc == NULL || Count == 0)	return erINV_PARA;
+	memset(psRep, 0, sizeof(lis2hh12_replay_t));
+	psRep->psSim = psSim;
+	psRep->psSrc = psSrc;
+	psRep->Count = Count;
+	psRep->T0rec = psSrc[0].TS;
+	psRep->Loop = Loop;
+	psSim->Gen = lis2hh12ReplayGen;
+	psSim->GenArg = psRep;
+	psSim->GenRaw = 1;
+	return erSUCCESS;
+}
+
+/**
+ * @brief		advance model time, driving the chip model and through it the complete driver
+ * @param[in]	Duration - model time to run in uSec
+ * @param[in]	Speed - multiple of real time, 1 = real time, 0 = as fast as possible
+ * @param[in]	StepUS - model time per step, also the IRQ latency granularity, 0 = 1mS
+ * @return		erSUCCESS or erINV_STATE if not initialised
+ * @note		driver time (lis2hh12TIME) follows model time while running and remains at the end
+ * 				of the run afterwards, set lis2hh12SimNow to 0 to return the driver to real time.
+ * 				cbStep is called after every step, typically draining the ring into the pipeline.
+ */
+int lis2hh12ReplayRun(lis2hh12_replay_t * psRep, u64_t Duration, u32_t Speed, u32_t StepUS) {
+	if (psRep->psSim == NULL)						return erINV_STATE;
+	if (StepUS == 0) StepUS = 1000;
+	u64_t Tstart = psRep->Tsim;
+	u64_t Tend = Tstart + Duration;
+	u64_t W0 = esp_timer_get_time();
+	while (psRep->Tsim < Tend) {
+		psRep->Tsim += StepUS;							// never 0, that selects real time
+		lis2hh12SimNow = psRep->Tsim;
+		lis2hh12SimTick(psRep->psSim, psRep->Tsim);
+		if (psRep->cbStep) psRep->cbStep(psRep);
+		if (Speed) {									// pace against wall time, yield when ahead
+			i64_t Ahead = (i64_t) (W0 + (psRep->Tsim - Tstart) / Speed) - esp_timer_get_time();
+			if (Ahead >= (i64_t) (portTICK_PERIOD_MS * 1000)) vTaskDelay(pdMS_TO_TICKS(Ahead / 1000));
+		}
+	}
+	psRep->Trun = psRep->Tsim - Tstart;
+	psRep->Twall = esp_timer_get_time() - W0;
+	return erSUCCESS;
+}
+
+int lis2hh12ReportReplay(report_t * psR, lis2hh12_replay_t * psRep) {
+	u32_t Speed = psRep->Twall ? (u32_t) (psRep->Trun / psRep->Twall) : 0;
+	return xReport(psR, "\tREPLAY Sample=%lu/%lu  Loops=%lu  Model=%llumS  Wall=%llumS  Speed=x%lu" strNL,
+		(u32_t) psRep->Idx, (u32_t) psRep->Count, psRep->Loops, psRep->Trun / 1000ULL, psRep->Twall / 1000ULL, Speed);
+}
+
+#endif
+#endif
@@ -0,0 +1,346 @@
+// lis2hh12_sim.c - Copyright (c) 2022-24 Andre M. Maree / KSS Technologies (Pty) Ltd.
+
+#include "hal_platform.h"
+
+#if (HAL_LIS2HH12 > 0)
+#include "hal_i2c_common.h"
+#include "lis2hh12.h"
+#include "report.h"
+#include "errors_events.h"
+
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+
+#if (lis2hh12SIM > 0)
+
+// ############################################# Macros ############################################
+
+#define	debugFLAG					0xF000
+#define	debugTIMING					(debugFLAG_GLOBAL & debugFLAG & 0x1000)
+#define	debugTRACK					(debugFLAG_GLOBAL & debugFLAG & 0x2000)
+#define	debugPARAM					(debugFLAG_GLOBAL & debugFLAG & 0x4000)
+#define	debugRESULT					(debugFLAG_GLOBAL & debugFLAG & 0x8000)
+
+#define R(r)						psSim->Reg[r]
+
+// ###################################### Global variables #########################################
+
+u64_t lis2hh12SimNow = 0;
+
+// ###################################### Local variables ##########################################
+
+static lis2hh12_sim_t * SimList[lis2hh12MAX_DEV] = { NULL };
+
+// #################################### Local ONLY functions #######################################
+
+static void SimReset(lis2hh12_sim_t * psSim) {
+	memset(psSim->Reg, 0, sizeof(psSim->Reg));
+	R(lis2hh12WHO_AM_I) = lis2hh12WHOAMI_NUM;
+	R(lis2hh12CTRL1) = makeCTRL1(0,0,0,1,1,1);
+	R(lis2hh12CTRL4) = makeCTRL4(0,0,0,1,0,0);
+	R(lis2hh12TEMP_H) = 0x01;
+	psSim->Head = psSim->Count = psSim->Trig = psSim->Inactive = psSim->Pending = 0;
+	psSim->Dur[0] = psSim->Dur[1] = psSim->Prev[0] = psSim->Prev[1] = psSim->Still = 0;
+	psSim->Tnext = 0;
+	psSim->Frac = 0;
+}
+
+/**
+ * @brief		effective FIFO behaviour, resolving the trigger based modes
+ */
+static e_fm_t SimMode(lis2hh12_sim_t * psSim) {
+	if ((R(lis2hh12CTRL3) & 0x80) == 0)				return fmBYPASS;
+	switch (R(lis2hh12FIFO_CTRL) >> 5) {
+	case fmFIFO:	return fmFIFO;
+	case fmSTREAM:	return fmSTREAM;
+	case fmS2F:		return psSim->Trig ? fmFIFO : fmSTREAM;
+	case fmB2S:		return psSim->Trig ? fmSTREAM : fmBYPASS;
+	case fmB2F:		return psSim->Trig ? fmFIFO : fmBYPASS;
+	default:		return fmBYPASS;
+	}
+}
+
+static u8_t SimFIFOsrc(lis2hh12_sim_t * psSim) {
+	u8_t Ths = R(lis2hh12FIFO_CTRL) & 0x1F;
+	u8_t Val = (psSim->Count > 0x1F) ? 0x1F : psSim->Count;
+	if (psSim->Count == 0) Val |= 0x20;
+	if (psSim->Count == lis2hh12FIFO_DEPTH) Val |= 0x40;
+	if (Ths && psSim->Count >= Ths) Val |= 0x80;
+	return Val;
+}
+
+static u8_t SimNext(lis2hh12_sim_t * psSim, u8_t Addr) {
+	if ((R(lis2hh12CTRL4) & 0x04) == 0)				return Addr;
+	if (Addr == lis2hh12OUT_Z_H && SimMode(psSim) != fmBYPASS) return lis2hh12OUT_X_L;	// FIFO read wrap
+	return (Addr == lis2hh12ZH_REF) ? lis2hh12ZH_REF : Addr + 1;
+}
+
+static u8_t SimRead(lis2hh12_sim_t * psSim, u8_t Addr) {
+	if (INRANGE(lis2hh12OUT_X_L, Addr, lis2hh12OUT_Z_H)) {
+		if (SimMode(psSim) != fmBYPASS && psSim->Count) {
+			u8_t Val = ((u8_t *) &psSim->FIFO[psSim->Head])[Addr - lis2hh12OUT_X_L];
+			if (Addr == lis2hh12OUT_Z_H) {				// last byte of entry, pop it
+				u32_t Lat = psSim->Tnext ? lis2hh12TIME() - psSim->FIFOts[psSim->Head] : 0;
+				psSim->LatSum += Lat;
+				++psSim->LatCnt;
+				if (Lat > psSim->LatMax) psSim->LatMax = Lat;
+				psSim->Head = (psSim->Head + 1) % lis2hh12FIFO_DEPTH;
+				if (--psSim->Count == 0) R(lis2hh12STATUS) = 0;
+			}
+			return Val;
+		}
+		if (Addr == lis2hh12OUT_Z_H) R(lis2hh12STATUS) = 0;	// data read, clear xDA & xOR
+		return R(Addr);
+	}
+	if (Addr == lis2hh12FIFO_SRC)					return SimFIFOsrc(psSim);
+	if (Addr == lis2hh12CTRL6 && psSim->BootTS && lis2hh12TIME() >= psSim->BootTS) {
+		R(Addr) &= 0x7F;
+		psSim->BootTS = 0;
+	}
+	u8_t Val = R(Addr);
+	if (Addr == lis2hh12IG_SRC1 && (R(lis2hh12CTRL7) & 0x04)) R(Addr) = 0;	// latched, clear on read
+	if (Addr == lis2hh12IG_SRC2 && (R(lis2hh12CTRL7) & 0x08)) R(Addr) = 0;
+	return Val;
+}
+
+static void SimWrite(lis2hh12_sim_t * psSim, u8_t Addr, u8_t Val) {
+	switch (Addr) {
+	case lis2hh12TEMP_L: case lis2hh12TEMP_H: case lis2hh12WHO_AM_I: case lis2hh12STATUS:
+	case lis2hh12OUT_X_L: case lis2hh12OUT_X_H: case lis2hh12OUT_Y_L: case lis2hh12OUT_Y_H:
+	case lis2hh12OUT_Z_L: case lis2hh12OUT_Z_H: case lis2hh12FIFO_SRC: case lis2hh12IG_SRC1: case lis2hh12IG_SRC2:
+		return;										// read only
+	case lis2hh12CTRL5:
+		if (Val & 0x40) { SimReset(psSim); return; }	// SOFT_RESET
+		break;
+	case lis2hh12CTRL6:
+		if (Val & 0x80) {								// BOOT, self clearing after BootUS
+			SimReset(psSim);
+			if (psSim->BootUS) {
+				R(Addr) = 0x80;
+				psSim->BootTS = lis2hh12TIME() + psSim->BootUS;
+			}
+			return;
+		}
+		break;
+	case lis2hh12FIFO_CTRL:
+		if ((Val >> 5) == fmBYPASS || (Val >> 5) != (R(Addr) >> 5)) psSim->Head = psSim->Count = psSim->Trig = 0;
+		break;
+	}
+	R(Addr) = Val;
+}
+
+/**
+ * @brief		evaluate one interrupt generator against a sample
+ * @return		IG_SRCx value, ia set if the event condition held for longer than IG_DURx
+ */
+static u8_t SimIG(lis2hh12_sim_t * psSim, int Num, const i16_t * pMG, i32_t FSmg) {
+	u8_t Cfg = R(Num ? lis2hh12IG_CFG2 : lis2hh12IG_CFG1);
+	u8_t Dur = R(Num ? lis2hh12IG_DUR2 : lis2hh12IG_DUR1) & 0x7F;
+	bool _4D = (R(lis2hh12CTRL7) >> Num) & 1;
+	u8_t Ev = 0;
+	for (int a = 0; a < (_4D ? 2 : 3); ++a) {
+		i32_t Ths = (Num ? R(lis2hh12IG_THS2) : R(lis2hh12IG_THS_X1 + a)) * FSmg / 256;	// 1 LSb = FS/256
+		i32_t Val = (Cfg & 0x40) ? pMG[a] : (pMG[a] < 0 ? -pMG[a] : pMG[a]);
+		bool Hi = Val > Ths;
+		bool Lo = (Cfg & 0x40) ? Val < -Ths : Val < Ths;
+		Ev |= (Hi << (2 * a + 1)) | (Lo << (2 * a));
+	}
+	u8_t En = Cfg & 0x3F;
+	bool Cond = (Cfg & 0x80) ? (En && (Ev & En) == En) : (Ev & En) != 0;
+	if ((Cfg & 0xC0) == 0x40) Cond = Cond && (Ev & En) != (psSim->Prev[Num] & En);	// 6D movement
+	psSim->Prev[Num] = Ev;
+	psSim->Dur[Num] = Cond ? (psSim->Dur[Num] < 0x7F ? psSim->Dur[Num] + 1 : 0x7F) : 0;
+	return (Cond && psSim->Dur[Num] > Dur) ? (Ev | 0x40) : Ev;
+}
+
+static lis2hh12_xyz_t SimWave(lis2hh12_sim_t * psSim, u64_t TS) {
+	f32_t Phase = 2.0 * M_PI * (f32_t) psSim->FreqX * (f32_t) (TS % 1000000ULL) / 1000000.0;
+	i16_t N[3] = { 0 };
+	for (int a = 0; psSim->Noise && a < 3; ++a) {
+		psSim->Seed = psSim->Seed * 1664525 + 1013904223;
+		N[a] = (i16_t) ((psSim->Seed >> 16) % (2 * psSim->Noise + 1)) - psSim->Noise;
+	}
+	return (lis2hh12_xyz_t) { .X = (i16_t) (psSim->AmpX * sinf(Phase)) + N[0], .Y = N[1], .Z = 1000 + N[2] };
+}
+
+static void SimSample(lis2hh12_sim_t * psSim, u64_t TS) {
+	static const u16_t SimSens[4] = { 61, 61, 122, 244 };	// uG/LSb
+	u8_t FS = (R(lis2hh12CTRL4) >> 4) & 3;
+	i32_t FSmg = (FS == 0) ? 2000 : (FS == 2) ? 4000 : 8000;
+	lis2hh12_xyz_t MG = psSim->Gen ? psSim->Gen(psSim, TS) : SimWave(psSim, TS);
+	i16_t * pMG = MG.Axis;
+	lis2hh12_xyz_t Raw;
+	i16_t * pRaw = Raw.Axis;
+	u8_t Sign = (R(lis2hh12CTRL5) >> 2) & 3;			// self test, force on the proof mass
+	i16_t ST = (Sign == 1) ? psSim->STmG : (Sign == 2) ? -psSim->STmG : 0;
+	for (int a = 0; a < 3; ++a) {
+		i32_t Val;
+		if (psSim->Gen && psSim->GenRaw) {				// raw in, mG derived for IG/INACT
+			Val = pMG[a];
+			pMG[a] = (i16_t) ((Val * SimSens[FS]) / 1000);
+		} else {
+			Val = ((i32_t) pMG[a] * 1000) / SimSens[FS];
+		}
+		Val += ((i32_t) ST * 1000) / SimSens[FS];
+		pMG[a] += ST;
+		if ((R(lis2hh12CTRL1) & (1 << a)) == 0) Val = 0;
+		pRaw[a] = (Val > INT16_MAX) ? INT16_MAX : (Val < INT16_MIN) ? INT16_MIN : Val;
+	}
+	++psSim->Samples;
+	// Interrupt generators, latched sources only updated when set
+	for (int Num = 0; Num < 2; ++Num) {
+		u8_t Src = SimIG(psSim, Num, pMG, FSmg);
+		u8_t Reg = Num ? lis2hh12IG_SRC2 : lis2hh12IG_SRC1;
+		bool LIR = (R(lis2hh12CTRL7) >> (2 + Num)) & 1;
+		if (LIR == 0 || (Src & 0x40)) R(Reg) = Src;
+		if (Src & 0x40) psSim->Trig = 1;
+	}
+	// Inactivity, change between samples below ACT_THS for ACT_DUR * 8 samples
+	if (R(lis2hh12ACT_THS)) {
+		i32_t Ths = R(lis2hh12ACT_THS) * FSmg / 128;
+		i32_t dX = MG.X - psSim->Last.X, dY = MG.Y - psSim->Last.Y, dZ = MG.Z - psSim->Last.Z;
+		bool Still = (dX < Ths && dX > -Ths && dY < Ths && dY > -Ths && dZ < Ths && dZ > -Ths);
+		psSim->Still = Still ? (psSim->Still < UINT16_MAX ? psSim->Still + 1 : UINT16_MAX) : 0;
+		psSim->Inactive = psSim->Still >= R(lis2hh12ACT_DUR) * 8;
+	}
+	psSim->Last = MG;
+	// Output data and FIFO
+	switch (SimMode(psSim)) {
+	case fmBYPASS:
+		if (R(lis2hh12STATUS) & 0x08) R(lis2hh12STATUS) |= 0xF0;	// previous sample not read
+		memcpy(&R(lis2hh12OUT_X_L), &Raw, sizeof(Raw));
+		R(lis2hh12STATUS) |= 0x0F;
+		return;
+	case fmSTREAM:
+		if (psSim->Count == lis2hh12FIFO_DEPTH) {			// overwrite oldest
+			psSim->Head = (psSim->Head + 1) % lis2hh12FIFO_DEPTH;
+			--psSim->Count;
+			++psSim->Overruns;
+		}
+		break;
+	default:
+		if (psSim->Count == lis2hh12FIFO_DEPTH) {			// FIFO full, stop collecting
+			++psSim->Overruns;
+			return;
+		}
+	}
+	u8_t Idx = (psSim->Head + psSim->Count++) % lis2hh12FIFO_DEPTH;
+	psSim->FIFO[Idx] = Raw;
+	psSim->FIFOts[Idx] = lis2hh12TIME();
+	R(lis2hh12STATUS) |= 0x0F;
+}
+
+/**
+ * @brief		evaluate INT1/INT2, deliver an interrupt if asserted and not yet being serviced
+ */
+static void SimLines(lis2hh12_sim_t * psSim) {
+	u8_t C3 = R(lis2hh12CTRL3), C6 = R(lis2hh12CTRL6), Src = SimFIFOsrc(psSim);
+	bool DRDY = R(lis2hh12STATUS) & 0x08;
+	bool IA1 = R(lis2hh12IG_SRC1) & 0x40, IA2 = R(lis2hh12IG_SRC2) & 0x40;
+	bool INT1 = ((C3 & 0x01) && DRDY) || ((C3 & 0x02) && (Src & 0x80)) || ((C3 & 0x04) && (Src & 0x40)) ||
+				((C3 & 0x08) && IA1) || ((C3 & 0x10) && IA2) || ((C3 & 0x20) && psSim->Inactive);
+	bool INT2 = ((C6 & 0x01) && DRDY) || ((C6 & 0x02) && (Src & 0x80)) || ((C6 & 0x04) && (Src & 0x20)) ||
+				((C6 & 0x08) && IA1) || ((C6 & 0x10) && IA2);
+	if ((INT1 || INT2) && psSim->Pending == 0 && psSim->psDev && psSim->cbIRQ) {
+		psSim->Pending = 1;
+		++psSim->IRQs;
+		psSim->cbIRQ(psSim->psDev);
+	}
+}
+
+// ###################################### Public functions #########################################
+
+/**
+ * @brief		initialise chip model in power on state and register it for the I2C device
+ * @return		erSUCCESS or erFAILURE if all model slots are in use
+ */
+int lis2hh12SimInit(lis2hh12_sim_t * psSim, i2c_di_t * psI2C) {
+	int Free = -1;
+	for (int i = 0; i < lis2hh12MAX_DEV; ++i) {
+		if (SimList[i] == psSim || SimList[i] == NULL) { Free = i; break; }
+	}
+	if (Free < 0)									return erFAILURE;
+	memset(psSim, 0, sizeof(lis2hh12_sim_t));
+	psSim->psI2C = psI2C;
+	psSim->cbIRQ = lis2hh12IRQ_0;
+	psSim->Seed = 1;
+	psSim->STmG = 400;
+	SimReset(psSim);
+	SimList[Free] = psSim;
+	return erSUCCESS;
+}
+
+/**
+ * @brief		link driver handle and chip model for the same I2C device, called by lis2hh12Identify()
+ * @return		chip model or NULL if the device is real
+ */
+lis2hh12_sim_t * lis2hh12SimAttach(lis2hh12_t * psDev) {
+	for (int i = 0; i < lis2hh12MAX_DEV; ++i) {
+		if (SimList[i] && SimList[i]->psI2C == psDev->psI2C) {
+			SimList[i]->psDev = psDev;
+			return SimList[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief		bus transaction against the register model, same semantics as halI2C_Queue()
+ * @note		transactions complete synchronously, i2cWRC callbacks are called before returning
+ */
+int lis2hh12SimQueue(lis2hh12_sim_t * psSim, int eCmd, u8_t * pTx, size_t TxSize, u8_t * pRx, size_t RxSize, i2cq_p1_t p1, i2cq_p2_t p2) {
+	IF_myASSERT(debugPARAM, pTx && TxSize);
+	if (psSim->LatencyUS) esp_rom_delay_us(psSim->LatencyUS);	// host: advances virtual time, else waits
+	u8_t Addr = pTx[0];
+	if (eCmd == i2cWRMW) {
+		u8_t Val = (SimRead(psSim, Addr) & (u8_t) (uintptr_t) p1) | (u8_t) (uintptr_t) p2;
+		SimWrite(psSim, Addr, Val);
+		if (pRx) *pRx = Val;
+		return erSUCCESS;
+	}
+	for (size_t i = 1; i < TxSize; ++i, Addr = SimNext(psSim, Addr)) SimWrite(psSim, Addr, pTx[i]);
+	if (RxSize) {
+		for (size_t i = 0; i < RxSize; ++i, Addr = SimNext(psSim, Addr)) pRx[i] = SimRead(psSim, Addr);
+		psSim->Pending = 0;								// INTx serviced, re-evaluated on next tick
+	}
+	if (eCmd == i2cWRC && p1) ((void (*)(void *)) p1)(p2);
+	return erSUCCESS;
+}
+
+static int lis2hh12QueueSim(lis2hh12_t * psDev, int eCmd, u8_t * pTx, size_t TxSize, u8_t * pRx, size_t RxSize, i2cq_p1_t p1, i2cq_p2_t p2) {
+	return lis2hh12SimQueue(psDev->psSim, eCmd, pTx, TxSize, pRx, RxSize, p1, p2);
+}
+
+const lis2hh12_bus_t lis2hh12BusSim = {				// byte accounting & wire time as the I2C device modelled
+	.pcName = "SIM", .Queue = lis2hh12QueueSim, .Hz = 400000, .BitsPerByte = 9, .AddrBytes = 1, .FrameBits = 2,
+};
+
+/**
+ * @brief		advance model time, generating all samples due at the current ODR
+ * @param[in]	Now - model time in uSec, real or accelerated
+ */
+void lis2hh12SimTick(lis2hh12_sim_t * psSim, u64_t Now) {
+	u8_t ODR = (R(lis2hh12CTRL1) >> 4) & 7;
+	if (ODR == lis2hh12_odr0 || ODR > lis2hh12_odr800) {
+		psSim->Tnext = 0;
+	} else {
+		u64_t PeriodQ16 = (((u64_t) 1000000 << 16) * (1000000 + psSim->PPM)) / (1000000ULL * odr_scale[ODR]);
+		if (psSim->Tnext == 0) psSim->Tnext = Now + (PeriodQ16 >> 16);
+		while (psSim->Tnext <= Now) {
+			SimSample(psSim, psSim->Tnext);
+			psSim->Frac += PeriodQ16 & 0xFFFF;
+			psSim->Tnext += (PeriodQ16 >> 16) + (psSim->Frac >> 16);
+			psSim->Frac &= 0xFFFF;
+		}
+	}
+	SimLines(psSim);
+}
+
+int lis2hh12ReportSim(report_t * psR, lis2hh12_sim_t * psSim) {
+	u32_t LatAvg = psSim->LatCnt ? psSim->LatSum / psSim->LatCnt : 0;
+	return xReport(psR, "\tSIM Samples=%lu  Overruns=%lu  IRQs=%lu  FIFO=%hhu  Latency avg=%luuS  max=%luuS" strNL,
+		psSim->Samples, psSim->Overruns, psSim->IRQs, psSim->Count, LatAvg, psSim->LatMax);
+}
+
+#endif
+#endif
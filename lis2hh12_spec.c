@@ -0,0 +1,214 @@
+// lis2hh12_spec.c - Copyright (c) 2022-24 Andre M. Maree / KSS Technologies (Pty) Ltd.
+
+#include "hal_platform.h"
+
+#if (HAL_LIS2HH12 > 0)
+#include "hal_i2c_common.h"
+#include "lis2hh12.h"
+#include "report.h"
+#include "errors_events.h"
+
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+
+// ############################################# Macros ############################################
+
+#define	debugFLAG					0xF000
+#define	debugTIMING					(debugFLAG_GLOBAL & debugFLAG & 0x1000)
+#define	debugTRACK					(debugFLAG_GLOBAL & debugFLAG & 0x2000)
+#define	debugPARAM					(debugFLAG_GLOBAL & debugFLAG & 0x4000)
+#define	debugRESULT					(debugFLAG_GLOBAL & debugFLAG & 0x8000)
+
+// #################################### Local ONLY functions #######################################
+
+/**
+ * @brief		in place radix 2 complex FFT of M = N/2 points held in Re[]/Im[]
+ * @note		twiddles for M points are every 2nd entry of the N point table
+ */
+static void lis2hh12SpecCFFT(lis2hh12_spec_t * psSpec) {
+	u16_t M = psSpec->N / 2;
+	f32_t * Re = psSpec->Re, * Im = psSpec->Im;
+	for (u16_t i = 1, j = 0; i < M; ++i) {				// bit reversal permutation
+		u16_t Bit = M >> 1;
+		for (; j & Bit; Bit >>= 1) j ^= Bit;
+		j |= Bit;
+		if (i < j) {
+			f32_t T = Re[i]; Re[i] = Re[j]; Re[j] = T;
+			T = Im[i]; Im[i] = Im[j]; Im[j] = T;
+		}
+	}
+	for (u16_t Len = 2; Len <= M; Len <<= 1) {
+		u16_t Half = Len / 2, Step = psSpec->N / Len;	// N point table stride
+		for (u16_t i = 0; i < M; i += Len) {
+			for (u16_t k = 0; k < Half; ++k) {
+				f32_t C = psSpec->Cos[k * Step], S = psSpec->Sin[k * Step];
+				u16_t a = i + k, b = a + Half;
+				f32_t Tr = Re[b] * C + Im[b] * S;		// (Re + jIm) * (C - jS)
+				f32_t Ti = Im[b] * C - Re[b] * S;
+				Re[b] = Re[a] - Tr;
+				Im[b] = Im[a] - Ti;
+				Re[a] += Tr;
+				Im[a] += Ti;
+			}
+		}
+	}
+}
+
+/**
+ * @brief		real FFT of N windowed samples via N/2 complex FFT and split, amplitudes to Mag[0..N/2]
+ */
+static void lis2hh12SpecFFT(lis2hh12_spec_t * psSpec) {
+	u16_t M = psSpec->N / 2;
+	for (u16_t n = 0; n < M; ++n) {						// pack even/odd samples as complex
+		psSpec->Re[n] = psSpec->In[2*n] * psSpec->Win[2*n];
+		psSpec->Im[n] = psSpec->In[2*n+1] * psSpec->Win[2*n+1];
+	}
+	lis2hh12SpecCFFT(psSpec);
+	f32_t Scale = 2.0f / psSpec->WinSum;
+	psSpec->Mag[0] = fabsf(psSpec->Re[0] + psSpec->Im[0]) / psSpec->WinSum;
+	psSpec->Mag[M] = fabsf(psSpec->Re[0] - psSpec->Im[0]) / psSpec->WinSum;
+	for (u16_t k = 1; k < M; ++k) {
+		f32_t Ar = psSpec->Re[k], Ai = psSpec->Im[k];
+		f32_t Br = psSpec->Re[M-k], Bi = -psSpec->Im[M-k];	// conj(Z[M-k])
+		f32_t Er = (Ar + Br) / 2.0f, Ei = (Ai + Bi) / 2.0f;
+		f32_t Or = (Ai - Bi) / 2.0f, Oi = (Br - Ar) / 2.0f;	// -j(A - B)/2
+		f32_t C = psSpec->Cos[k], S = psSpec->Sin[k];
+		f32_t Xr = Er + Or * C + Oi * S;
+		f32_t Xi = Ei + Oi * C - Or * S;
+		psSpec->Mag[k] = sqrtf(Xr * Xr + Xi * Xi) * Scale;
+	}
+}
+
+static void lis2hh12SpecGoertzel(lis2hh12_spec_t * psSpec) {
+	for (u8_t b = 0; b < psSpec->NumBins; ++b) {
+		f32_t Coef = psSpec->Coef[b], S1 = 0.0f, S2 = 0.0f;
+		for (u16_t n = 0; n < psSpec->N; ++n) {
+			f32_t S0 = psSpec->In[n] * psSpec->Win[n] + Coef * S1 - S2;
+			S2 = S1;
+			S1 = S0;
+		}
+		f32_t Pwr = S1 * S1 + S2 * S2 - Coef * S1 * S2;
+		psSpec->Mag[b] = 2.0f * sqrtf(Pwr > 0.0f ? Pwr : 0.0f) / psSpec->WinSum;
+	}
+}
+
+static void lis2hh12SpecBlock(lis2hh12_t * psDev, lis2hh12_spec_t * psSpec) {
+	u32_t C0 = esp_cpu_get_cycle_count();
+	if (psSpec->Mode == lis2hh12_specFFT) lis2hh12SpecFFT(psSpec);
+	else lis2hh12SpecGoertzel(psSpec);
+	u32_t Cyc = esp_cpu_get_cycle_count() - C0;
+	psSpec->Cycles += Cyc;
+	if (Cyc > psSpec->CyclesMax) psSpec->CyclesMax = Cyc;
+	++psSpec->Blocks;
+	if (psSpec->cbSpec) {
+		if (psSpec->Mode == lis2hh12_specFFT) psSpec->cbSpec(psDev, psSpec->Mag, psSpec->N / 2 + 1, psSpec->Fs / psSpec->N);
+		else psSpec->cbSpec(psDev, psSpec->Mag, psSpec->NumBins, 0.0f);
+	}
+	u16_t Keep = psSpec->N - psSpec->Hop;				// slide overlap to start of block
+	memmove(psSpec->In, &psSpec->In[psSpec->Hop], Keep * sizeof(f32_t));
+	psSpec->Fill = Keep;
+}
+
+// ###################################### Public functions #########################################
+
+/**
+ * @brief		initialise spectral stage, block size N chosen from ODR for ~lis2hh12SPEC_RES Hz bins
+ * @param[in]	ODR - ctrl1.odr code of the samples fed (1..6), index into odr_scale[]
+ * @param[in]	Axis - 0=X 1=Y 2=Z
+ * @param[in]	Overlap - percentage of each block reused in the next, 0..75
+ * @param[in]	cbSpec - called from the sample path with each block result
+ * @return		erSUCCESS or erINV_PARA
+ * @note		with DSP decimation active, feed ODR of the decimated rate is not a table entry,
+ * 				configure the spectral stage only on undecimated streams
+ */
+int lis2hh12SpecInit(lis2hh12_spec_t * psSpec, u8_t ODR, lis2hh12_spec_mode_t Mode, u8_t Axis, u8_t Overlap, lis2hh12_spec_cb_t cbSpec) {
+	if (ODR == 0 || ODR > 6 || Axis > 2 || Overlap > 75 || Mode > lis2hh12_specGOERTZEL)	return erINV_PARA;
+	memset(psSpec, 0, sizeof(lis2hh12_spec_t));
+	psSpec->Fs = (f32_t) odr_scale[ODR];
+	u16_t N = 16;
+	while (N < lis2hh12SPEC_NMAX && N * lis2hh12SPEC_RES < odr_scale[ODR]) N <<= 1;
+	psSpec->N = N;
+	psSpec->Hop = N - (N * Overlap) / 100;
+	psSpec->Mode = Mode;
+	psSpec->Axis = Axis;
+	psSpec->cbSpec = cbSpec;
+	for (u16_t n = 0; n < N; ++n) {
+		psSpec->Win[n] = 0.5f - 0.5f * cosf(2.0f * (f32_t) M_PI * n / N);	// periodic Hann
+		psSpec->WinSum += psSpec->Win[n];
+	}
+	for (u16_t k = 0; k < N / 2; ++k) {
+		psSpec->Cos[k] = cosf(2.0f * (f32_t) M_PI * k / N);
+		psSpec->Sin[k] = sinf(2.0f * (f32_t) M_PI * k / N);
+	}
+	return erSUCCESS;
+}
+
+/**
+ * @brief		add a Goertzel frequency, need not be bin centred
+ * @return		erSUCCESS or erINV_PARA if out of range or no free slot
+ */
+int lis2hh12SpecAddBin(lis2hh12_spec_t * psSpec, f32_t Freq) {
+	if (psSpec->NumBins == lis2hh12SPEC_BINS || Freq <= 0.0f || Freq >= psSpec->Fs / 2.0f)	return erINV_PARA;
+	psSpec->Freq[psSpec->NumBins] = Freq;
+	psSpec->Coef[psSpec->NumBins] = 2.0f * cosf(2.0f * (f32_t) M_PI * Freq / psSpec->Fs);
+	++psSpec->NumBins;
+	return erSUCCESS;
+}
+
+/**
+ * @brief		accumulate samples of the configured axis, analyse each full block
+ */
+void lis2hh12SpecFeed(lis2hh12_t * psDev, lis2hh12_xyz_t * psXYZ, size_t Count) {
+	lis2hh12_spec_t * psSpec = psDev->psSpec;
+	for (size_t i = 0; i < Count; ++i) {
+		psSpec->In[psSpec->Fill++] = (f32_t) psXYZ[i].Axis[psSpec->Axis];
+		if (psSpec->Fill == psSpec->N) lis2hh12SpecBlock(psDev, psSpec);
+	}
+}
+
+/**
+ * @brief		band energy (sum of squared amplitudes) of the last FFT block between Lo and Hi Hz
+ */
+f32_t lis2hh12SpecBand(lis2hh12_spec_t * psSpec, f32_t Lo, f32_t Hi) {
+	if (psSpec->Mode != lis2hh12_specFFT || psSpec->Blocks == 0)	return 0.0f;
+	f32_t BinHz = psSpec->Fs / psSpec->N, Sum = 0.0f;
+	for (u16_t k = 0; k <= psSpec->N / 2; ++k) {
+		f32_t F = k * BinHz;
+		if (F >= Lo && F <= Hi) Sum += psSpec->Mag[k] * psSpec->Mag[k];
+	}
+	return Sum;
+}
+
+int lis2hh12ReportSpec(report_t * psR, lis2hh12_spec_t * psSpec) {
+	u32_t CpB = psSpec->Blocks ? psSpec->Cycles / psSpec->Blocks : 0;
+	f32_t UpB = (f32_t) CpB / (f32_t) esp_rom_get_cpu_ticks_per_us();	// blocks take a few uSec, from cycles
+	f32_t Duty = UpB * psSpec->Fs / (f32_t) psSpec->Hop / 10000.0f;	// % of hop interval
+	return xReport(psR, "\tSPEC %s Axis=%c N=%hu Hop=%hu Blocks=%lu Cycles/Blk=%lu (max %lu) uS/Blk=%.2f Duty=%.4f%%" strNL,
+		psSpec->Mode == lis2hh12_specFFT ? "FFT" : "GOERTZEL", 'X' + psSpec->Axis, psSpec->N, psSpec->Hop,
+		psSpec->Blocks, CpB, psSpec->CyclesMax, UpB, Duty);
+}
+
+/**
+ * @brief		time FFT and 4 bin Goertzel blocks at every ODR, report cost and duty cycle
+ * @note		runs on a synthetic tone without a device, blocks the caller for a few mSec
+ */
+int lis2hh12SpecBench(report_t * psR) {
+	static lis2hh12_spec_t sSpec;
+	static lis2hh12_t sDev = { .psSpec = &sSpec };			// too large for a task stack
+	lis2hh12_xyz_t XYZ;
+	int iRV = 0;
+	for (u8_t ODR = 1; ODR <= 6; ++ODR) {
+		for (int Mode = lis2hh12_specFFT; Mode <= lis2hh12_specGOERTZEL; ++Mode) {
+			lis2hh12SpecInit(&sSpec, ODR, Mode, 0, 50, NULL);
+			for (int b = 1; b <= 4; ++b) lis2hh12SpecAddBin(&sSpec, sSpec.Fs * b / 10.0f);
+			for (int n = 0; sSpec.Blocks < 8; ++n) {
+				XYZ.X = (i16_t) (1000.0f * sinf(2.0f * (f32_t) M_PI * n / 7.3f));
+				lis2hh12SpecFeed(&sDev, &XYZ, 1);
+			}
+			iRV += lis2hh12ReportSpec(psR, &sSpec);
+		}
+	}
+	return iRV;
+}
+
+#endif
@@ -0,0 +1,136 @@
+// lis2hh12_spi.c - Copyright (c) 2022-24 Andre M. Maree / KSS Technologies (Pty) Ltd.
+
+#include "hal_platform.h"
+
+#if (HAL_LIS2HH12 > 0)
+#include "hal_i2c_common.h"
+#include "lis2hh12.h"
+#include "report.h"
+#include "errors_events.h"
+
+#if (lis2hh12SPI > 0)
+#include "driver/spi_master.h"
+
+// ############################################# Macros ############################################
+
+#define	debugFLAG					0xF000
+#define	debugTIMING					(debugFLAG_GLOBAL & debugFLAG & 0x1000)
+#define	debugTRACK					(debugFLAG_GLOBAL & debugFLAG & 0x2000)
+#define	debugPARAM					(debugFLAG_GLOBAL & debugFLAG & 0x4000)
+#define	debugRESULT					(debugFLAG_GLOBAL & debugFLAG & 0x8000)
+
+#define	lis2hh12SPI_READ			0x80				// R/W bit in the address byte, 1 = read
+#define	lis2hh12SPI_TX				8					// write payload copied for ISR deferred transactions
+
+// ######################################## Local structures #######################################
+
+typedef struct {						// transaction queued from ISR context, completed in the timer task
+	u8_t Busy;
+	u8_t eCmd;
+	u8_t TxSize;
+	u8_t Tx[lis2hh12SPI_TX];
+	u8_t * pRx;
+	size_t RxSize;
+	i2cq_p1_t p1;
+	i2cq_p2_t p2;
+} lis2hh12_spi_req_t;
+
+// ###################################### Local variables ##########################################
+
+static lis2hh12_spi_req_t SpiReq[lis2hh12MAX_DEV] = { 0 };
+
+// #################################### Local ONLY functions #######################################
+
+/**
+ * @brief		single SPI transaction, address byte in the address phase, payload in the data phase
+ * @note		CTRL4 IF_ADD_INC (reset default 1) must remain set for the multi byte register bursts
+ */
+static int lis2hh12SpiXfer(lis2hh12_t * psDev, u8_t Addr, const u8_t * pTx, u8_t * pRx, size_t Size) {
+	if (Size == 0)									return erSUCCESS;
+	spi_transaction_t sT = {
+		.addr = Addr, .length = Size * 8, .rxlength = pRx ? Size * 8 : 0, .tx_buffer = pTx, .rx_buffer = pRx,
+	};
+	return (spi_device_polling_transmit((spi_device_handle_t) psDev->pvBus, &sT) == ESP_OK) ? erSUCCESS : erFAILURE;
+}
+
+/**
+ * @brief		complete a transaction, task context only
+ * @note		bus released before the i2cWRC callback since callbacks may issue further transactions
+ */
+static int lis2hh12SpiExec(lis2hh12_t * psDev, int eCmd, u8_t * pTx, size_t TxSize, u8_t * pRx, size_t RxSize, i2cq_p1_t p1, i2cq_p2_t p2) {
+	IF_myASSERT(debugPARAM, pTx && TxSize && (RxSize == 0 || TxSize == 1));
+	if (psDev->mux == NULL) psDev->mux = xSemaphoreCreateMutex();	// first use is lis2hh12Identify()
+	xSemaphoreTake(psDev->mux, portMAX_DELAY);
+	int iRV;
+	u8_t Addr = pTx[0];
+	if (eCmd == i2cWRMW) {								// read, modify & write back under one bus lock
+		u8_t Val;
+		iRV = lis2hh12SpiXfer(psDev, Addr | lis2hh12SPI_READ, NULL, &Val, sizeof(Val));
+		if (iRV == erSUCCESS) {
+			Val = (Val & (u8_t) (uintptr_t) p1) | (u8_t) (uintptr_t) p2;
+			iRV = lis2hh12SpiXfer(psDev, Addr, &Val, NULL, sizeof(Val));
+			if (pRx) *pRx = Val;
+		}
+	} else if (RxSize) {
+		iRV = lis2hh12SpiXfer(psDev, Addr | lis2hh12SPI_READ, NULL, pRx, RxSize);
+	} else {
+		iRV = lis2hh12SpiXfer(psDev, Addr, pTx + 1, NULL, TxSize - 1);
+	}
+	xSemaphoreGive(psDev->mux);
+	if (iRV == erSUCCESS && eCmd == i2cWRC && p1) ((void (*)(void *)) p1)(p2);
+	return iRV;
+}
+
+/**
+ * @brief		timer task half of an ISR queued transaction, e.g. the lis2hh12IRQ_0 status burst
+ */
+static void lis2hh12SpiDefer(void * pvPara, u32_t Idx) {
+	lis2hh12_spi_req_t sReq;
+	memcpy(&sReq, &SpiReq[Idx], sizeof(sReq));
+	__atomic_store_n(&SpiReq[Idx].Busy, 0, __ATOMIC_RELEASE);
+	lis2hh12SpiExec((lis2hh12_t *) pvPara, sReq.eCmd, sReq.Tx, sReq.TxSize, sReq.pRx, sReq.RxSize, sReq.p1, sReq.p2);
+}
+
+// ###################################### Public functions #########################################
+
+/**
+ * @brief		4 wire SPI transport, same command & callback semantics as halI2C_Queue()
+ * @return		erSUCCESS/erFAILURE in task context, from ISR context pdTRUE if a yield is required,
+ * 				erINV_STATE if the previous ISR transaction for the device is still pending or erINV_PARA
+ * 				if the handle is not one of sLIS2HH12[]
+ * @note		the application adds the device before lis2hh12IdentifyBus(psI2C, &lis2hh12BusSPI, hDev)
+ * 				with mode 3, address_bits 8, command_bits 0, clock <= lis2hh12SPI_HZ and its own CS pin.
+ * 				Polling transmit, so Rx buffers need only be DMA capable (internal RAM) for bursts over
+ * 				the hardware FIFO, pool blocks and driver buffers are. Task context transactions complete
+ * 				synchronously, those from ISR context are completed in the timer task.
+ */
+int lis2hh12SpiQueue(lis2hh12_t * psDev, int eCmd, u8_t * pTx, size_t TxSize, u8_t * pRx, size_t RxSize, i2cq_p1_t p1, i2cq_p2_t p2) {
+	if (xPortInIsrContext() == 0)					return lis2hh12SpiExec(psDev, eCmd, pTx, TxSize, pRx, RxSize, p1, p2);
+	IF_myASSERT(debugPARAM, TxSize <= lis2hh12SPI_TX);
+	u32_t Idx = 0;
+	while (Idx < lis2hh12MAX_DEV && psDev != &sLIS2HH12[Idx]) ++Idx;
+	if (Idx == lis2hh12MAX_DEV)						return erINV_PARA;	// not in sLIS2HH12[], no request slot
+	lis2hh12_spi_req_t * psReq = &SpiReq[Idx];
+	if (__atomic_exchange_n(&psReq->Busy, 1, __ATOMIC_ACQUIRE))	return erINV_STATE;
+	psReq->eCmd = eCmd;
+	psReq->TxSize = TxSize;
+	memcpy(psReq->Tx, pTx, TxSize);						// caller's Tx is typically on the ISR stack
+	psReq->pRx = pRx;
+	psReq->RxSize = RxSize;
+	psReq->p1 = p1;
+	psReq->p2 = p2;
+	BaseType_t xHPTW = pdFALSE;
+	if (xTimerPendFunctionCallFromISR(lis2hh12SpiDefer, psDev, Idx, &xHPTW) != pdPASS) {
+		__atomic_store_n(&psReq->Busy, 0, __ATOMIC_RELEASE);
+		return erFAILURE;
+	}
+	return xHPTW;
+}
+
+const lis2hh12_bus_t lis2hh12BusSPI = {
+	.pcName = "SPI", .Queue = lis2hh12SpiQueue, .Hz = lis2hh12SPI_HZ, .BitsPerByte = 8, .AddrBytes = 0, .FrameBits = 2,
+	.CTRL4 = 0x02,										// i2c_disable, SPI traffic must not be decoded as I2C
+};
+
+#endif
+#endif
@@ -0,0 +1,121 @@
+// lis2hh12_stat.c - Copyright (c) 2022-24 Andre M. Maree / KSS Technologies (Pty) Ltd.
+
+#include "hal_platform.h"
+
+#if (HAL_LIS2HH12 > 0)
+#include "hal_i2c_common.h"
+#include "lis2hh12.h"
+#include "report.h"
+#include "errors_events.h"
+
+// ############################################# Macros ############################################
+
+#define	debugFLAG					0xF000
+#define	debugTIMING					(debugFLAG_GLOBAL & debugFLAG & 0x1000)
+#define	debugTRACK					(debugFLAG_GLOBAL & debugFLAG & 0x2000)
+#define	debugPARAM					(debugFLAG_GLOBAL & debugFLAG & 0x4000)
+#define	debugRESULT					(debugFLAG_GLOBAL & debugFLAG & 0x8000)
+
+// #################################### Local ONLY functions #######################################
+
+static void lis2hh12StatClear(lis2hh12_stat_t * psStat) {
+	psStat->Count = 0;
+	for (int a = 0; a < 3; ++a) {
+		lis2hh12_mom_t * psM = &psStat->Mom[a];
+		psM->Min = INT16_MAX;
+		psM->Max = INT16_MIN;
+		psM->Mean = psM->M2 = psM->M3 = psM->M4 = 0.0f;
+	}
+}
+
+static inline u16_t lis2hh12StatQ8(f32_t Val) {
+	Val = Val * 256.0f + 0.5f;
+	return (Val >= (f32_t) UINT16_MAX) ? UINT16_MAX : (u16_t) Val;
+}
+
+static void lis2hh12StatEmit(lis2hh12_t * psDev, u64_t TS) {
+	lis2hh12_stat_t * psStat = psDev->psStat;
+	lis2hh12_sum_t sSum = { .TS = TS, .Count = psStat->Count, .FS = psDev->Reg.ctrl4.fs, .Seq = psStat->Seq++ };
+	f32_t N = (f32_t) psStat->Count;
+	for (int a = 0; a < 3; ++a) {
+		lis2hh12_mom_t * psM = &psStat->Mom[a];
+		lis2hh12_axsum_t * psA = &sSum.Axis[a];
+		f32_t Var = psM->M2 / N;
+		f32_t RMS = sqrtf(Var);
+		f32_t PeakP = (f32_t) psM->Max - psM->Mean, PeakN = psM->Mean - (f32_t) psM->Min;
+		f32_t Peak = (PeakP > PeakN) ? PeakP : PeakN;
+		psA->Mean = (i16_t) (psM->Mean + (psM->Mean < 0.0f ? -0.5f : 0.5f));
+		psA->RMS = (u16_t) (RMS + 0.5f);
+		psA->Min = psM->Min;
+		psA->Max = psM->Max;
+		psA->Crest = (RMS > 0.0f) ? lis2hh12StatQ8(Peak / RMS) : 0;
+		psA->Kurt = (psM->M2 > 0.0f) ? lis2hh12StatQ8(N * psM->M4 / (psM->M2 * psM->M2)) : 0;
+	}
+	if (psStat->cbSum) psStat->cbSum(psDev, &sSum);
+	lis2hh12StatClear(psStat);
+}
+
+// ###################################### Public functions #########################################
+
+/**
+ * @brief		initialise window statistics
+ * @param[in]	Window - samples (after any DSP decimation) per summary record, 2 or more
+ * @param[in]	cbSum - called from the sample path with each completed summary
+ * @return		erSUCCESS or erINV_PARA
+ */
+int lis2hh12StatInit(lis2hh12_stat_t * psStat, u16_t Window, lis2hh12_sum_cb_t cbSum) {
+	if (Window < 2)									return erINV_PARA;
+	psStat->cbSum = cbSum;
+	psStat->Window = Window;
+	psStat->Seq = 0;
+	lis2hh12StatClear(psStat);
+	return erSUCCESS;
+}
+
+/**
+ * @brief		single pass update of per axis min/max and central moments, emits when window full
+ * @param[in]	TS - timestamp of the last sample in psXYZ, Period - uSec between samples
+ * @param[in]	Gap - samples lost before psXYZ[0], a partial window is discarded and its Seq skipped
+ * @note		min/max integer, moments using the Welford / Pebay incremental form which stays
+ * 				numerically stable with the gravity offset present in the raw samples
+ */
+void lis2hh12StatFeed(lis2hh12_t * psDev, lis2hh12_xyz_t * psXYZ, size_t Count, u64_t TS, u32_t Period, u16_t Gap) {
+	lis2hh12_stat_t * psStat = psDev->psStat;
+	if (Gap && psStat->Count) {							// window not contiguous, as DSP history
+		lis2hh12StatClear(psStat);
+		++psStat->Seq;
+	}
+	for (size_t i = 0; i < Count; ++i) {
+		f32_t N1 = (f32_t) psStat->Count;
+		f32_t N = N1 + 1.0f;
+		f32_t InvN = 1.0f / N;
+		f32_t K4 = N * N - 3.0f * N + 3.0f;
+		for (int a = 0; a < 3; ++a) {
+			lis2hh12_mom_t * psM = &psStat->Mom[a];
+			i16_t X = psXYZ[i].Axis[a];
+			if (X < psM->Min) psM->Min = X;
+			if (X > psM->Max) psM->Max = X;
+			f32_t Delta = (f32_t) X - psM->Mean;
+			f32_t DeltaN = Delta * InvN;
+			f32_t DeltaN2 = DeltaN * DeltaN;
+			f32_t Term1 = Delta * DeltaN * N1;
+			psM->Mean += DeltaN;
+			psM->M4 += Term1 * DeltaN2 * K4 + 6.0f * DeltaN2 * psM->M2 - 4.0f * DeltaN * psM->M3;
+			psM->M3 += Term1 * DeltaN * (N - 2.0f) - 3.0f * DeltaN * psM->M2;
+			psM->M2 += Term1;
+		}
+		if (++psStat->Count == psStat->Window) lis2hh12StatEmit(psDev, TS - (u64_t) (Count - 1 - i) * Period);
+	}
+}
+
+int lis2hh12ReportSum(report_t * psR, lis2hh12_sum_t * psSum) {
+	int iRV = xReport(psR, "\tSUM #%hhu  TS=%llu  N=%hu  FS=%hhu" strNL, psSum->Seq, psSum->TS, psSum->Count, psSum->FS);
+	for (int a = 0; a < 3; ++a) {
+		lis2hh12_axsum_t * psA = &psSum->Axis[a];
+		iRV += xReport(psR, "\t  %c Mean=%hd  RMS=%hu  Min=%hd  Max=%hd  Crest=%.2f  Kurt=%.2f" strNL, 'X' + a,
+			psA->Mean, psA->RMS, psA->Min, psA->Max, (f32_t) psA->Crest / 256.0f, (f32_t) psA->Kurt / 256.0f);
+	}
+	return iRV;
+}
+
+#endif